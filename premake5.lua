@@ -317,6 +317,16 @@ workspace "bifrost"
     bifrost_add_external_args()
     bifrost_add_external_spdlog()
     
+  project "logdump"
+    kind "ConsoleApp"
+    includedirs { "source" }
+    targetname "bifrost-logdump"
+    
+    files {"source/logdump/*.cpp" }
+    
+    bifrost_add_bifrost_core()
+    bifrost_add_external_args()
+    
   -- *
   -- *** Compiler ***
   -- *
@@ -14,8 +14,8 @@
 #include "bifrost/core/common.h"
 #include "bifrost/core/context.h"
 #include "bifrost/core/ilogger.h"
+#include "bifrost/core/shared_logger.h"
 #include "bifrost/core/shared_memory.h"
-#include "bifrost/core/sm_log_stash.h"
 
 namespace bifrost::api {
 
@@ -58,19 +58,4 @@ void Free(StructT* s) {
   }
 }
 
-class SharedLogger : public ILogger {
- public:
-  SharedLogger(Context* ctx) : m_ctx(ctx) {}
-
-  virtual void SetModule(const char* module) override { m_module = module; }
-  virtual void Sink(LogLevel level, const char* module, const char* msg) override {
-    m_ctx->Memory().GetSMLogStash()->Push(m_ctx, static_cast<u32>(level), module, msg);
-  }
-  virtual void Sink(LogLevel level, const char* msg) override { Sink(level, m_module.c_str(), msg); }
-
- private:
-  Context* m_ctx;
-  std::string m_module;
-};
-
 }  // namespace bifrost::api
\ No newline at end of file
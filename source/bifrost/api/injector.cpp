@@ -13,6 +13,7 @@
 
 #include "bifrost/api/injector.h"
 #include "bifrost/api/helper.h"
+#include "bifrost/core/binary_log.h"
 #include "bifrost/core/buffered_logger.h"
 #include "bifrost/core/context.h"
 #include "bifrost/core/error.h"
@@ -23,7 +24,12 @@
 #include "bifrost/core/plugin_param.h"
 #include "bifrost/core/process.h"
 #include "bifrost/core/shared_memory.h"
+#include "bifrost/core/sm_channel.h"
+#include "bifrost/core/sm_atom_table.h"
+#include "bifrost/core/sm_log_levels.h"
 #include "bifrost/core/sm_log_stash.h"
+#include "bifrost/core/sm_storage.h"
+#include "bifrost/core/timestamp.h"
 #include "bifrost/debugger/debugger.h"
 
 #include "bifrost/template/plugin_fwd.h"
@@ -49,6 +55,76 @@ class ForwardLogger : public ILogger {
   bfi_LoggingCallback m_cb;
 };
 
+class BatchForwardLogger : public ILogger {
+ public:
+  static constexpr u32 DefaultBatchSize = 64;
+
+  BatchForwardLogger(bfi_BatchLoggingCallback cb, u32 batchSize, u32 maxLatencyInMs)
+      : m_cb(cb), m_batchSize(batchSize == 0 ? DefaultBatchSize : batchSize), m_maxLatencyInTicks(maxLatencyInMs * GetTimestampFrequency() / 1000) {
+    m_records.reserve(m_batchSize);
+    m_offsets.reserve(m_batchSize);
+  }
+  ~BatchForwardLogger() { Flush(); }
+
+  virtual void SetModule(const char* module) override { m_module = module; }
+  virtual void Sink(LogLevel level, const char* module, const char* msg) override {
+    LogRecord record{level, module, msg};
+    SinkBatch(&record, 1);
+  }
+  virtual void Sink(LogLevel level, const char* msg) override { Sink(level, m_module.c_str(), msg); }
+
+  virtual void SinkBatch(const LogRecord* records, u64 count) override {
+    u64 now = GetTimestamp();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (u64 i = 0; i < count; ++i) {
+      const LogRecord& r = records[i];
+      if (m_records.empty()) m_firstTimestamp = now;
+
+      // The strings are resolved on delivery as the text may grow
+      u64 timestamp = r.Timestamp != 0 ? r.Timestamp : now;
+      u32 threadId = r.Timestamp != 0 ? r.ThreadId : (u32)::GetCurrentThreadId();
+      m_records.emplace_back(bfi_LogRecord{(uint32_t)r.Level, threadId, nullptr, nullptr, TimestampToUnixMicroseconds(timestamp)});
+
+      u64 moduleOffset = m_text.size();
+      m_text.append(r.Module ? r.Module : "").push_back('\0');
+      m_offsets.emplace_back(moduleOffset, m_text.size());
+      m_text.append(r.Message).push_back('\0');
+
+      if (m_records.size() == m_batchSize) DeliverImpl();
+    }
+    if (!m_records.empty() && now - m_firstTimestamp >= m_maxLatencyInTicks) DeliverImpl();
+  }
+
+  virtual void Flush() override {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DeliverImpl();
+  }
+
+ private:
+  void DeliverImpl() {
+    if (m_records.empty()) return;
+    for (u64 i = 0; i < m_records.size(); ++i) {
+      m_records[i].Module = m_text.data() + m_offsets[i].first;
+      m_records[i].Message = m_text.data() + m_offsets[i].second;
+    }
+    m_cb(m_records.data(), (uint32_t)m_records.size());
+    m_records.clear();
+    m_offsets.clear();
+    m_text.clear();
+  }
+
+  std::string m_module;
+  bfi_BatchLoggingCallback m_cb;
+  u32 m_batchSize;
+  u64 m_maxLatencyInTicks;
+
+  std::mutex m_mutex;
+  std::vector<bfi_LogRecord> m_records;
+  std::vector<std::pair<u64, u64>> m_offsets;  ///< Offsets of module and message of the records into `m_text`
+  std::string m_text;
+  u64 m_firstTimestamp = 0;
+};
+
 class InjectorContext {
  public:
   InjectorContext() {
@@ -62,10 +138,12 @@ class InjectorContext {
 
   ~InjectorContext() {
     m_logStashConsumer.reset();
+    m_binaryLogWriter.reset();
     m_memory.reset();
     m_loader.reset();
     m_bufferedLogger.reset();
     m_forwardLogger.reset();
+    m_batchForwardLogger.reset();
   }
 
   // Load the plugins
@@ -303,6 +381,8 @@ class InjectorContext {
       m_memory = std::move(memory);
       m_ctx->SetMemory(m_memory.get());
       SetUpLogConsumer();
+      ApplyLogLevels();
+      ApplyLogOverflowPolicy();
     }
   }
 
@@ -322,17 +402,92 @@ class InjectorContext {
 
   // Set the log callback
   bfi_Status SetLogCallback(bfi_LoggingCallback cb) {
-    if (cb != NULL) {
-      SetUpForwardLogger(cb);
+    ReplaceLogger([&]() {
+      if (cb != NULL) {
+        SetUpForwardLogger(cb);
+      } else {
+        SetUpBufferedLogger();
+      }
+    });
+    return BFP_OK;
+  }
+
+  // Set the batch log callback
+  bfi_Status SetBatchLogCallback(bfi_BatchLoggingCallback cb, u32 batchSize, u32 maxLatencyInMs) {
+    ReplaceLogger([&]() {
+      if (cb != NULL) {
+        SetUpBatchForwardLogger(cb, batchSize, maxLatencyInMs);
+      } else {
+        SetUpBufferedLogger();
+      }
+    });
+    return BFP_OK;
+  }
+
+  // Set the minimum log level of `module` (NULL for the default level)
+  bfi_Status SetLogLevel(const char* module, u32 level) {
+    if (level > static_cast<u32>(LogLevel::Error)) throw Exception("Invalid log level %u", level);
+
+    if (module) {
+      m_logLevels[module] = level;
     } else {
-      SetUpBufferedLogger();
+      m_defaultLogLevel = level;
+    }
+    ApplyLogLevels();
+    return BFP_OK;
+  }
+
+  // Apply the log levels to the shared memory (if any)
+  void ApplyLogLevels() {
+    if (!m_memory) return;
+
+    SMLogLevels* levels = m_memory->GetSMLogLevels();
+    if (m_defaultLogLevel) levels->SetDefaultLevel(*m_defaultLogLevel);
+    for (const auto& [module, level] : m_logLevels) {
+      levels->SetLevel(m_ctx.get(), m_memory->GetSMAtomTable()->Intern(m_ctx.get(), module.c_str()), level);
     }
+  }
+
+  // Set the overflow policy of the log stash
+  bfi_Status SetLogOverflowPolicy(bfi_LogOverflowPolicy policy, u64 maxBytes, u64 maxMessages, u32 blockTimeoutInMs) {
+    if (policy < BFI_LOG_DROP_NEWEST || policy > BFI_LOG_SPILL_TO_DISK) throw Exception("Invalid log overflow policy %i", (int)policy);
+
+    m_logOverflowPolicy = LogOverflowPolicy{(SMLogStash::OverflowPolicy)policy, maxBytes, maxMessages, blockTimeoutInMs};
+    ApplyLogOverflowPolicy();
     return BFP_OK;
   }
 
+  // Apply the overflow policy to the log stash (if any)
+  void ApplyLogOverflowPolicy() {
+    if (!m_memory || !m_logOverflowPolicy) return;
+
+    SMLogStash* logStash = m_memory->GetSMLogStash();
+    logStash->SetOverflowPolicy(m_logOverflowPolicy->Policy, m_logOverflowPolicy->BlockTimeoutInMs);
+    logStash->SetBudget(m_logOverflowPolicy->MaxBytes == 0 ? logStash->Capacity() : m_logOverflowPolicy->MaxBytes, m_logOverflowPolicy->MaxMessages);
+  }
+
   // Logging
+  template <class FunctorT>
+  void ReplaceLogger(FunctorT&& setUpLogger) {
+    // The log consumer sinks to the current logger, stop it before the logger is replaced
+    bool hasConsumer = m_logStashConsumer != nullptr;
+    m_logStashConsumer.reset();
+    m_ctx->Logger().Flush();
+
+    setUpLogger();
+    if (hasConsumer) SetUpLogConsumer();
+  }
+
   void SetUpBufferedLogger() { m_ctx->SetLogger(m_bufferedLogger.get()); }
 
+  void SetUpBatchForwardLogger(bfi_BatchLoggingCallback cb, u32 batchSize, u32 maxLatencyInMs) {
+    m_batchForwardLogger = std::make_unique<BatchForwardLogger>(cb, batchSize, maxLatencyInMs);
+    m_batchForwardLogger->SetModule(m_bufferedLogger->GetModule());
+    m_ctx->SetLogger(m_batchForwardLogger.get());
+    m_bufferedLogger->Flush(m_batchForwardLogger.get());
+    m_batchForwardLogger->Flush();
+  }
+
   void SetUpForwardLogger(bfi_LoggingCallback cb) {
     m_forwardLogger = std::make_unique<ForwardLogger>(cb);
     m_forwardLogger->SetModule(m_bufferedLogger->GetModule());
@@ -342,10 +497,44 @@ class InjectorContext {
 
   void SetUpLogConsumer() {
     if (m_memory) {
-      m_logStashConsumer = std::make_unique<LogStashConsumer>(m_ctx.get(), m_memory->GetSMLogStash(), &m_ctx->Logger());
+      m_logStashConsumer.reset();
+      m_logStashConsumer = std::make_unique<LogStashConsumer>(m_ctx.get(), m_memory->GetSMLogStash(), &m_ctx->Logger(), m_binaryLogWriter.get());
     }
   }
 
+  // Write the log messages of the remote process to binary log files
+  bfi_Status EnableBinaryLogging(const wchar_t* path, u64 maxFileSizeInBytes, u32 maxFiles) {
+    // Stop the consumer before replacing the writer it appends to
+    m_logStashConsumer.reset();
+    m_binaryLogWriter.reset();
+
+    if (path) {
+      m_binaryLogWriter = std::make_unique<BinaryLogWriter>(path, maxFileSizeInBytes == 0 ? BinaryLogWriter::DefaultMaxFileSize : maxFileSizeInBytes,
+                                                            maxFiles == 0 ? BinaryLogWriter::DefaultMaxFiles : maxFiles);
+      m_ctx->Logger().InfoFormat(L"Writing binary log to \"%s\"", m_binaryLogWriter->GetPath().c_str());
+    }
+    SetUpLogConsumer();
+    return BFP_OK;
+  }
+
+  // Open a channel in the shared memory
+  bfi_Status ChannelOpen(const char* name, uint32_t elementSize, uint32_t capacity, bfi_Channel** channel) {
+    if (!m_memory) throw Exception("Failed to open channel: no shared memory has been set up (load the plugins first)");
+    if (!name) throw Exception("Failed to open channel: name is NULL");
+
+    SMByteChannel* smChannel = m_memory->GetSMChannelRegistry()->Open(m_ctx.get(), name, elementSize, capacity);
+    *channel = new bfi_Channel;
+    (*channel)->_Internal = smChannel;
+    return BFP_OK;
+  }
+
+  // Get the key/value storage in the shared memory
+  SMStorage* GetStorage(const char* key) {
+    if (!m_memory) throw Exception("Failed to access storage: no shared memory has been set up (load the plugins first)");
+    if (!key) throw Exception("Failed to access storage: key is NULL");
+    return m_memory->GetSMStorage();
+  }
+
   Context* GetContext() { return m_ctx.get(); }
 
  private:
@@ -353,17 +542,31 @@ class InjectorContext {
   std::unique_ptr<Context> m_ctx;
 
   std::unique_ptr<SharedMemory> m_memory;
+  std::unique_ptr<BinaryLogWriter> m_binaryLogWriter;
   std::unique_ptr<LogStashConsumer> m_logStashConsumer;
   std::unique_ptr<ModuleLoader> m_loader;
   std::unique_ptr<Debugger> m_debugger;
 
   std::unique_ptr<BufferedLogger> m_bufferedLogger;
   std::unique_ptr<ForwardLogger> m_forwardLogger;
+  std::unique_ptr<BatchForwardLogger> m_batchForwardLogger;
+
+  std::map<std::string, u32> m_logLevels;
+  std::optional<u32> m_defaultLogLevel;
+
+  struct LogOverflowPolicy {
+    SMLogStash::OverflowPolicy Policy;
+    u64 MaxBytes;
+    u64 MaxMessages;
+    u32 BlockTimeoutInMs;
+  };
+  std::optional<LogOverflowPolicy> m_logOverflowPolicy;
 };
 
 InjectorContext* Get(bfi_Context* ctx) { return (InjectorContext*)ctx->_Internal; }
 Process* Get(bfi_Process* process) { return (Process*)process->_Internal; }
 Process* Get(const bfi_Process* process) { return (Process*)process->_Internal; }
+SMByteChannel* Get(bfi_Channel* channel) { return (SMByteChannel*)channel->_Internal; }
 
 }  // namespace
 
@@ -390,6 +593,23 @@ bfi_Status bfi_ContextSetLoggingCallback(bfi_Context* ctx, bfi_LoggingCallback c
   BIFROST_INJECTOR_CATCH_ALL({ return Get(ctx)->SetLogCallback(cb); })
 }
 
+bfi_Status bfi_ContextSetBatchLoggingCallback(bfi_Context* ctx, bfi_BatchLoggingCallback cb, uint32_t batchSize, uint32_t maxLatencyInMs) {
+  BIFROST_INJECTOR_CATCH_ALL({ return Get(ctx)->SetBatchLogCallback(cb, batchSize, maxLatencyInMs); })
+}
+
+bfi_Status bfi_ContextSetLogLevel(bfi_Context* ctx, const char* module, uint32_t level) {
+  BIFROST_INJECTOR_CATCH_ALL({ return Get(ctx)->SetLogLevel(module, level); })
+}
+
+bfi_Status bfi_ContextEnableBinaryLogging(bfi_Context* ctx, const wchar_t* path, uint64_t maxFileSizeInBytes, uint32_t maxFiles) {
+  BIFROST_INJECTOR_CATCH_ALL({ return Get(ctx)->EnableBinaryLogging(path, maxFileSizeInBytes, maxFiles); })
+}
+
+bfi_Status bfi_ContextSetLogOverflowPolicy(bfi_Context* ctx, bfi_LogOverflowPolicy policy, uint64_t maxBytes, uint64_t maxMessages,
+                                           uint32_t blockTimeoutInMs) {
+  BIFROST_INJECTOR_CATCH_ALL({ return Get(ctx)->SetLogOverflowPolicy(policy, maxBytes, maxMessages, blockTimeoutInMs); })
+}
+
 #pragma endregion
 
 #pragma region Process
@@ -494,4 +714,118 @@ BIFROST_INJECTOR_API bfi_Status bfi_PluginHelpFree(bfi_Context* ctx, char* help)
 
 #pragma endregion
 
+#pragma region Channel
+
+bfi_Status bfi_ChannelOpen(bfi_Context* ctx, const char* name, uint32_t elementSize, uint32_t capacity, bfi_Channel** channel) {
+  BIFROST_INJECTOR_CATCH_ALL({ return Get(ctx)->ChannelOpen(name, elementSize, capacity, channel); });
+}
+
+bfi_Status bfi_ChannelFree(bfi_Context* ctx, bfi_Channel* channel) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    if (channel) delete channel;
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_ChannelPush(bfi_Context* ctx, bfi_Channel* channel, const void* elements, uint32_t count, uint32_t timeoutInMs, uint32_t* numPushed) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    u32 n = (u32)Get(channel)->Push(Get(ctx)->GetContext(), elements, count, timeoutInMs);
+    if (numPushed) *numPushed = n;
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_ChannelPop(bfi_Context* ctx, bfi_Channel* channel, void* elements, uint32_t count, uint32_t timeoutInMs, uint32_t* numPopped) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    u32 n = (u32)Get(channel)->Pop(Get(ctx)->GetContext(), elements, count, timeoutInMs);
+    if (numPopped) *numPopped = n;
+    return BFP_OK;
+  });
+}
+
+#pragma endregion
+
+#pragma region Storage
+
+bfi_Status bfi_StorageInsertBool(bfi_Context* ctx, const char* key, int32_t value) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    Get(ctx)->GetStorage(key)->InsertBool(Get(ctx)->GetContext(), key, value != 0);
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_StorageInsertInt(bfi_Context* ctx, const char* key, int32_t value) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    Get(ctx)->GetStorage(key)->InsertInt(Get(ctx)->GetContext(), key, value);
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_StorageInsertDouble(bfi_Context* ctx, const char* key, double value) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    Get(ctx)->GetStorage(key)->InsertDouble(Get(ctx)->GetContext(), key, value);
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_StorageInsertString(bfi_Context* ctx, const char* key, const char* value) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    Get(ctx)->GetStorage(key)->InsertString(Get(ctx)->GetContext(), key, std::string_view(value ? value : ""));
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_StorageInsertBlob(bfi_Context* ctx, const char* key, const void* data, uint64_t sizeInBytes) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    Get(ctx)->GetStorage(key)->InsertBlob(Get(ctx)->GetContext(), key, data, sizeInBytes);
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_StorageInsertFloatArray(bfi_Context* ctx, const char* key, const float* data, uint64_t count) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    Get(ctx)->GetStorage(key)->InsertArray(Get(ctx)->GetContext(), key, data, count);
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_StorageInsertDoubleArray(bfi_Context* ctx, const char* key, const double* data, uint64_t count) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    Get(ctx)->GetStorage(key)->InsertArray(Get(ctx)->GetContext(), key, data, count);
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_StorageInsertInt32Array(bfi_Context* ctx, const char* key, const int32_t* data, uint64_t count) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    Get(ctx)->GetStorage(key)->InsertArray(Get(ctx)->GetContext(), key, data, count);
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_StorageInsertInt64Array(bfi_Context* ctx, const char* key, const int64_t* data, uint64_t count) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    Get(ctx)->GetStorage(key)->InsertArray(Get(ctx)->GetContext(), key, data, count);
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_StorageRemove(bfi_Context* ctx, const char* key, int32_t* removed) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    bool r = Get(ctx)->GetStorage(key)->Remove(Get(ctx)->GetContext(), key);
+    if (removed) *removed = r;
+    return BFP_OK;
+  });
+}
+
+bfi_Status bfi_StorageWatch(bfi_Context* ctx, const char* key, uint64_t lastVersion, uint32_t timeoutInMs, uint64_t* version) {
+  BIFROST_INJECTOR_CATCH_ALL({
+    u64 v = Get(ctx)->GetStorage(key)->Watch(Get(ctx)->GetContext(), key, lastVersion, timeoutInMs);
+    if (version) *version = v;
+    return BFP_OK;
+  });
+}
+
+#pragma endregion
+
 BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved) { return TRUE; }
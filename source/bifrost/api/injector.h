@@ -41,6 +41,15 @@ enum bfi_ExecutableMode {
   BFI_CONNECT_VIA_NAME,  ///< Connect to process via name
 };
 
+/// @brief Behavior of the remote process if the log buffer in the shared memory is full
+enum bfi_LogOverflowPolicy {
+  BFI_LOG_DROP_NEWEST = 0,  ///< Drop the message which is logged
+  BFI_LOG_DROP_OLDEST,      ///< Discard the oldest buffered messages
+  BFI_LOG_BLOCK,            ///< Wait for the injector to consume messages (up to a timeout), then drop the message
+  BFI_LOG_SPILL,            ///< Store the message in a side buffer in the shared memory
+  BFI_LOG_SPILL_TO_DISK,    ///< Write the message to a temporary file of the remote process, the injector replays it in order
+};
+
 #pragma endregion
 
 #pragma region Structs
@@ -62,6 +71,11 @@ typedef struct bfi_Context_t {
   void* _Internal;  ///< Internal pointer, do not use
 } bfi_Context;
 
+/// @brief Shared memory channel, use `bfi_ChannelOpen` to open a channel
+typedef struct bfi_Channel_t {
+  void* _Internal;  ///< Internal pointer, do not use
+} bfi_Channel;
+
 /// @brief Executable description
 typedef struct bfi_Executable_t {
   bfi_ExecutableMode Mode;          ///< Launch or connect to the executable?
@@ -128,6 +142,15 @@ typedef struct bfi_PluginUnloadResult_t {
   int32_t* Unloaded;  ///< Set to 1 if the plugin has been successfully unloaded, 0 otherwise - (size `bfi_PluginUnloadArguments.NumPlugins`)
 } bfi_PluginUnloadResult;
 
+/// @brief Log message passed to the batch logging callback
+typedef struct bfi_LogRecord_t {
+  uint32_t Level;      ///< Log level (0 = Trace, 1 = Debug, 2 = Info, 3 = Warn, 4 = Error)
+  uint32_t ThreadId;   ///< Thread which logged the message
+  const char* Module;  ///< Module which logged the message
+  const char* Message; ///< Log message
+  uint64_t Timestamp;  ///< Time of the log call in microseconds since the Unix epoch
+} bfi_LogRecord;
+
 #pragma endregion
 
 #pragma region Version
@@ -166,6 +189,46 @@ typedef void (*bfi_LoggingCallback)(uint32_t, const char*, const char*);
 /// @param[in] cb   Logging callback, previously captured log messages will be flushed after registration
 BIFROST_INJECTOR_API bfi_Status bfi_ContextSetLoggingCallback(bfi_Context* ctx, bfi_LoggingCallback cb);
 
+/// @brief Batch logging callback - the records are only valid for the duration of the call
+typedef void (*bfi_BatchLoggingCallback)(const bfi_LogRecord*, uint32_t);
+
+/// @brief Register a logging callback `cb` which receives the log messages in batches - set to NULL to deregister a previously registered callback
+///
+/// The messages of the remote process are delivered from a background thread once `batchSize` messages have been collected, the oldest
+/// message is older than `maxLatencyInMs` or no further messages are pending. This replaces a callback registered via
+/// `bfi_ContextSetLoggingCallback` and vice versa.
+/// @param[in] ctx              Context description
+/// @param[in] cb               Batch logging callback, previously captured log messages will be flushed after registration
+/// @param[in] batchSize        Maximum number of messages per call (0 for the default of 64)
+/// @param[in] maxLatencyInMs   Longest time a message is held back before it is delivered
+BIFROST_INJECTOR_API bfi_Status bfi_ContextSetBatchLoggingCallback(bfi_Context* ctx, bfi_BatchLoggingCallback cb, uint32_t batchSize,
+                                                                   uint32_t maxLatencyInMs);
+
+/// @brief Set the minimum log level of `module` in the remote process - messages below the level are dropped before they are formatted
+/// @param[in] ctx     Context description
+/// @param[in] module  Name of the module or NULL to set the level of all modules without an explicit level
+/// @param[in] level   Minimum log level (0 = Trace, 1 = Debug, 2 = Info, 3 = Warn, 4 = Error), the level is applied to the shared memory
+///                    once it has been set up (i.e if called before loading the plugins, the level is applied while loading)
+BIFROST_INJECTOR_API bfi_Status bfi_ContextSetLogLevel(bfi_Context* ctx, const char* module, uint32_t level);
+
+/// @brief Set the behavior of the remote process if the log buffer in the shared memory is full
+/// @param[in] ctx                Context description
+/// @param[in] policy             Overflow policy
+/// @param[in] maxBytes           Byte budget of the log buffer (0 to use the full buffer)
+/// @param[in] maxMessages        Maximum number of unconsumed messages (0 for no limit)
+/// @param[in] blockTimeoutInMs   Longest time a thread waits with `BFI_LOG_BLOCK` (or to announce spilled messages with `BFI_LOG_SPILL_TO_DISK`)
+BIFROST_INJECTOR_API bfi_Status bfi_ContextSetLogOverflowPolicy(bfi_Context* ctx, bfi_LogOverflowPolicy policy, uint64_t maxBytes,
+                                                                uint64_t maxMessages, uint32_t blockTimeoutInMs);
+
+/// @brief Write the log messages of the remote process unformatted to binary log files instead of passing them to the logging callback
+///
+/// The files are written to "<path>.<n>.bflog" and rotated once they reach `maxFileSizeInBytes`. Use bifrost-logdump to decode them.
+/// @param[in] ctx                  Context description
+/// @param[in] path                 Base path of the binary log files or NULL to disable binary logging
+/// @param[in] maxFileSizeInBytes   Size of a file before it is rotated (0 for the default of 64 MB)
+/// @param[in] maxFiles             Number of files kept on disk (0 for the default of 8)
+BIFROST_INJECTOR_API bfi_Status bfi_ContextEnableBinaryLogging(bfi_Context* ctx, const wchar_t* path, uint64_t maxFileSizeInBytes, uint32_t maxFiles);
+
 /// @brief Get the last error message occurred in `ctx`
 /// @param[in] ctx  Context description
 BIFROST_INJECTOR_API const char* bfi_ContextGetLastError(bfi_Context* ctx);
@@ -269,6 +332,102 @@ BIFROST_INJECTOR_API bfi_Status bfi_PluginHelpFree(bfi_Context* ctx, char* help)
 
 #pragma endregion
 
+#pragma region Channel
+
+/// @brief Wait forever in `bfi_ChannelPush` and `bfi_ChannelPop`
+#define BIFROST_INJECTOR_CHANNEL_INFINITE (0xFFFFFFFF)
+
+/// @brief Open the single-producer/single-consumer channel `name` in the shared memory or create it if it does not exist
+///
+/// The shared memory has to be set up first (e.g via `bfi_PluginLoad`). The channel is valid as long as the shared memory is alive.
+/// @param[in] ctx           Context description
+/// @param[in] name          Name of the channel
+/// @param[in] elementSize   Size of an element in bytes (has to match the size used by the other side of the channel)
+/// @param[in] capacity      Number of elements the channel can hold (rounded up to the next power of 2) - ignored if the channel already exists
+/// @param[out] channel      Channel description
+BIFROST_INJECTOR_API bfi_Status bfi_ChannelOpen(bfi_Context* ctx, const char* name, uint32_t elementSize, uint32_t capacity, bfi_Channel** channel);
+
+/// @brief Free the channel description (the channel itself stays in the shared memory)
+/// @param[in] ctx       Context description
+/// @param[in] channel   Channel description
+BIFROST_INJECTOR_API bfi_Status bfi_ChannelFree(bfi_Context* ctx, bfi_Channel* channel);
+
+/// @brief Push `count` elements to the channel (only one thread may push at a time)
+/// @param[in] ctx           Context description
+/// @param[in] channel       Channel description
+/// @param[in] elements      Elements to push (`count * elementSize` bytes)
+/// @param[in] count         Number of elements to push
+/// @param[in] timeoutInMs   Time to wait for free space (0 to never wait, BIFROST_INJECTOR_CHANNEL_INFINITE to wait forever)
+/// @param[out] numPushed    Number of pushed elements (can be NULL)
+BIFROST_INJECTOR_API bfi_Status bfi_ChannelPush(bfi_Context* ctx, bfi_Channel* channel, const void* elements, uint32_t count, uint32_t timeoutInMs,
+                                                uint32_t* numPushed);
+
+/// @brief Pop up to `count` elements from the channel (only one thread may pop at a time)
+/// @param[in] ctx           Context description
+/// @param[in] channel       Channel description
+/// @param[out] elements     Buffer of at least `count * elementSize` bytes
+/// @param[in] count         Maximum number of elements to pop
+/// @param[in] timeoutInMs   Time to wait for the first element (0 to never wait, BIFROST_INJECTOR_CHANNEL_INFINITE to wait forever)
+/// @param[out] numPopped    Number of popped elements
+BIFROST_INJECTOR_API bfi_Status bfi_ChannelPop(bfi_Context* ctx, bfi_Channel* channel, void* elements, uint32_t count, uint32_t timeoutInMs,
+                                               uint32_t* numPopped);
+
+#pragma endregion
+
+#pragma region Storage
+
+/// @brief Wait forever in `bfi_StorageWatch`
+#define BIFROST_INJECTOR_STORAGE_INFINITE (0xFFFFFFFF)
+
+/// @brief Insert the value `value` of `key` into the key/value storage of the shared memory (overrides the value if `key` already exists)
+///
+/// The shared memory has to be set up first (e.g via `bfi_PluginLoad`). Plugins waiting on the key via `SMStorage::Watch` are woken up.
+/// @param[in] ctx     Context description
+/// @param[in] key     Name of the key
+/// @param[in] value   Value to insert
+BIFROST_INJECTOR_API bfi_Status bfi_StorageInsertBool(bfi_Context* ctx, const char* key, int32_t value);
+BIFROST_INJECTOR_API bfi_Status bfi_StorageInsertInt(bfi_Context* ctx, const char* key, int32_t value);
+BIFROST_INJECTOR_API bfi_Status bfi_StorageInsertDouble(bfi_Context* ctx, const char* key, double value);
+BIFROST_INJECTOR_API bfi_Status bfi_StorageInsertString(bfi_Context* ctx, const char* key, const char* value);
+
+/// @brief Insert the blob `data` of `sizeInBytes` bytes as value of `key` into the key/value storage of the shared memory
+/// @param[in] ctx           Context description
+/// @param[in] key           Name of the key
+/// @param[in] data          Data to copy into the shared memory
+/// @param[in] sizeInBytes   Size of `data` in bytes
+BIFROST_INJECTOR_API bfi_Status bfi_StorageInsertBlob(bfi_Context* ctx, const char* key, const void* data, uint64_t sizeInBytes);
+
+/// @brief Insert the array `data` of `count` elements as value of `key` into the key/value storage of the shared memory
+///
+/// Plugins read the array without a copy via `SMStorage::GetArray` of the matching element type.
+/// @param[in] ctx     Context description
+/// @param[in] key     Name of the key
+/// @param[in] data    Elements to copy into the shared memory
+/// @param[in] count   Number of elements in `data`
+BIFROST_INJECTOR_API bfi_Status bfi_StorageInsertFloatArray(bfi_Context* ctx, const char* key, const float* data, uint64_t count);
+BIFROST_INJECTOR_API bfi_Status bfi_StorageInsertDoubleArray(bfi_Context* ctx, const char* key, const double* data, uint64_t count);
+BIFROST_INJECTOR_API bfi_Status bfi_StorageInsertInt32Array(bfi_Context* ctx, const char* key, const int32_t* data, uint64_t count);
+BIFROST_INJECTOR_API bfi_Status bfi_StorageInsertInt64Array(bfi_Context* ctx, const char* key, const int64_t* data, uint64_t count);
+
+/// @brief Remove `key` from the key/value storage of the shared memory
+/// @param[in] ctx       Context description
+/// @param[in] key       Name of the key
+/// @param[out] removed  1 if the key existed, 0 otherwise (can be NULL)
+BIFROST_INJECTOR_API bfi_Status bfi_StorageRemove(bfi_Context* ctx, const char* key, int32_t* removed);
+
+/// @brief Block until the version of `key` differs from `lastVersion` or `timeoutInMs` elapsed
+///
+/// The version of a key increases every time the key is inserted and is 0 if the key does not exist. Pass 0 as `lastVersion` to get the
+/// current version of an existing key immediately.
+/// @param[in] ctx           Context description
+/// @param[in] key           Name of the key
+/// @param[in] lastVersion   Last version of the key seen by the caller
+/// @param[in] timeoutInMs   Time to wait for a change (0 to never wait, BIFROST_INJECTOR_STORAGE_INFINITE to wait forever)
+/// @param[out] version      Current version of the key
+BIFROST_INJECTOR_API bfi_Status bfi_StorageWatch(bfi_Context* ctx, const char* key, uint64_t lastVersion, uint32_t timeoutInMs, uint64_t* version);
+
+#pragma endregion
+
 #if __cplusplus
 }  // extern "C"
 #endif
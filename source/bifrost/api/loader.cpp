@@ -94,8 +94,9 @@ class LoaderContext {
       storage->Memory = std::make_unique<SharedMemory>(storage->Context.get(), param.SharedMemoryName, param.SharedMemorySize);
       storage->Context->SetMemory(storage->Memory.get());
 
-      // Flush the buffered logger and start logging to shared memory
-      storage->SharedLogger = std::make_unique<SharedLogger>(storage->Context.get());
+      // Flush the buffered logger and start logging to shared memory (messages are published immediately and repeats are not collapsed as
+      // the storage may be destroyed while the process detaches, where the flusher thread of the logger can't be joined)
+      storage->SharedLogger = std::make_unique<SharedLogger>(storage->Context.get(), 0, 0);
       storage->SharedLogger->SetModule(curModule.c_str());
       storage->Context->SetLogger(storage->SharedLogger.get());
       storage->BufferedLogger->Flush(storage->SharedLogger.get());
@@ -13,10 +13,12 @@
 
 #include "bifrost/api/helper.h"
 #include "bifrost/api/plugin_context.h"
+#include "bifrost/core/exception.h"
 #include "bifrost/core/hook_manager.h"
 
 #include "bifrost/core/macros.h"
 #include "bifrost/core/mutex.h"
+#include "bifrost/core/sm_channel.h"
 
 using namespace bifrost;
 using namespace bifrost::api;
@@ -27,6 +29,7 @@ namespace {
 #define BIFROST_PLUGIN_CATCH_ALL_PTR(stmts) BIFROST_API_CATCH_ALL_IMPL(ctx, stmts, nullptr)
 
 inline PluginContext* Get(bfp_PluginContext* ctx) { return (PluginContext*)ctx->_Internal; }
+inline SMByteChannel* Get(bfp_Channel* channel) { return (SMByteChannel*)channel->_Internal; }
 
 // Singleton context
 static SpinMutex g_mutex;
@@ -138,6 +141,11 @@ bfp_Status bfp_PluginLog(bfp_PluginContext* ctx, uint32_t level, const char* mod
   BIFROST_PLUGIN_CATCH_ALL({ return Get(ctx)->Log(level, module, msg); });
 }
 
+bfp_Status bfp_PluginLogDeferred(bfp_PluginContext* ctx, uint32_t level, const char* module, const char* format, const void* args, uint32_t argsSize) {
+  static_assert(BFP_LOG_ARG_STR == (int)DeferredArgTag::Str, "bfp_LogArgTag does not match DeferredArgTag");
+  BIFROST_PLUGIN_CATCH_ALL({ return Get(ctx)->LogDeferred(level, module, format, args, argsSize); });
+}
+
 const char* bfp_PluginGetLastError(bfp_PluginContext* ctx) { return Get(ctx)->GetLastError(); }
 
 BIFROST_PLUGIN_API bfp_Status bfp_HookSet(bfp_PluginContext* ctx, const bfp_HookSetDesc* desc, void** original) {
@@ -161,4 +169,44 @@ bfp_Status bfp_HookEnableDebug(bfp_PluginContext* ctx) {
   });
 }
 
+#pragma endregion
+
+#pragma region Channel
+
+bfp_Status bfp_ChannelOpen(bfp_PluginContext* ctx, const char* name, uint32_t elementSize, uint32_t capacity, bfp_Channel** channel) {
+  BIFROST_PLUGIN_CATCH_ALL({
+    Context* context = Get(ctx)->GetContext();
+    if (!context->HasSharedMemory()) throw Exception("Failed to open channel: plugin is not connected to the shared memory");
+    if (!name) throw Exception("Failed to open channel: name is NULL");
+
+    SMByteChannel* smChannel = context->Memory().GetSMChannelRegistry()->Open(context, name, elementSize, capacity);
+    *channel = new bfp_Channel;
+    (*channel)->_Internal = smChannel;
+    return BFP_OK;
+  });
+}
+
+bfp_Status bfp_ChannelFree(bfp_PluginContext* ctx, bfp_Channel* channel) {
+  BIFROST_PLUGIN_CATCH_ALL({
+    if (channel) delete channel;
+    return BFP_OK;
+  });
+}
+
+bfp_Status bfp_ChannelPush(bfp_PluginContext* ctx, bfp_Channel* channel, const void* elements, uint32_t count, uint32_t timeoutInMs, uint32_t* numPushed) {
+  BIFROST_PLUGIN_CATCH_ALL({
+    u32 n = (u32)Get(channel)->Push(Get(ctx)->GetContext(), elements, count, timeoutInMs);
+    if (numPushed) *numPushed = n;
+    return BFP_OK;
+  });
+}
+
+bfp_Status bfp_ChannelPop(bfp_PluginContext* ctx, bfp_Channel* channel, void* elements, uint32_t count, uint32_t timeoutInMs, uint32_t* numPopped) {
+  BIFROST_PLUGIN_CATCH_ALL({
+    u32 n = (u32)Get(channel)->Pop(Get(ctx)->GetContext(), elements, count, timeoutInMs);
+    if (numPopped) *numPopped = n;
+    return BFP_OK;
+  });
+}
+
 #pragma endregion
\ No newline at end of file
@@ -39,6 +39,17 @@ enum bfp_HookType {
   BFP_VTABLE          ///< VTable method hook
 };
 
+/// @brief Type tag of an argument passed to `bfp_PluginLogDeferred` - each argument is encoded as the tag byte followed by the raw value
+enum bfp_LogArgTag {
+  BFP_LOG_ARG_I32 = 0,  ///< int32_t
+  BFP_LOG_ARG_U32,      ///< uint32_t
+  BFP_LOG_ARG_I64,      ///< int64_t
+  BFP_LOG_ARG_U64,      ///< uint64_t
+  BFP_LOG_ARG_F64,      ///< double
+  BFP_LOG_ARG_PTR,      ///< Pointer stored as uint64_t
+  BFP_LOG_ARG_STR       ///< uint32_t length followed by the characters (not '\0' terminated)
+};
+
 #pragma endregion
 
 #pragma region Structs
@@ -81,6 +92,11 @@ typedef struct bfp_HookRemoveDesc_t {
   void* Target;       ///< A pointer to the target function, which was used during set (used to identify the hook)
 } bfp_HookRemoveDesc;
 
+/// @brief Shared memory channel, use `bfp_ChannelOpen` to open a channel
+typedef struct bfp_Channel_t {
+  void* _Internal;  ///< Internal pointer, do not use
+} bfp_Channel;
+
 #pragma endregion
 
 #pragma region Version
@@ -152,6 +168,18 @@ BIFROST_PLUGIN_API bfp_Status bfp_PluginTearDownEnd(bfp_PluginContext* ctx, cons
 /// @param[in] msg       Log message
 BIFROST_PLUGIN_API bfp_Status bfp_PluginLog(bfp_PluginContext* ctx, uint32_t level, const char* module, const char* msg);
 
+/// @brief Log the message `format` whose formatting is deferred to the injector
+///
+/// The arguments are only formatted by the consumer of the log (and not at all if the level of `module` is disabled).
+/// @param[in] ctx       Plugin context description
+/// @param[in] level     Severity of the log message
+/// @param[in] module    Module to log from
+/// @param[in] format    printf-style format string, has to be a string literal (the address identifies the call site)
+/// @param[in] args      Arguments encoded as described by `bfp_LogArgTag`
+/// @param[in] argsSize  Size of `args` in bytes (at most 512 bytes are used)
+BIFROST_PLUGIN_API bfp_Status bfp_PluginLogDeferred(bfp_PluginContext* ctx, uint32_t level, const char* module, const char* format, const void* args,
+                                                    uint32_t argsSize);
+
 /// @brief Get the last error message occurred in `plugin`
 /// @param[in] plugin   Plugin context description
 BIFROST_PLUGIN_API const char* bfp_PluginGetLastError(bfp_PluginContext* plugin);
@@ -174,6 +202,46 @@ BIFROST_PLUGIN_API bfp_Status bfp_HookEnableDebug(bfp_PluginContext* ctx);
 
 #pragma endregion
 
+#pragma region Channel
+
+/// @brief Wait forever in `bfp_ChannelPush` and `bfp_ChannelPop`
+#define BIFROST_PLUGIN_CHANNEL_INFINITE (0xFFFFFFFF)
+
+/// @brief Open the single-producer/single-consumer channel `name` in the shared memory or create it if it does not exist
+/// @param[in] ctx           Plugin context description
+/// @param[in] name          Name of the channel
+/// @param[in] elementSize   Size of an element in bytes (has to match the size used by the other side of the channel)
+/// @param[in] capacity      Number of elements the channel can hold (rounded up to the next power of 2) - ignored if the channel already exists
+/// @param[out] channel      Channel description
+BIFROST_PLUGIN_API bfp_Status bfp_ChannelOpen(bfp_PluginContext* ctx, const char* name, uint32_t elementSize, uint32_t capacity, bfp_Channel** channel);
+
+/// @brief Free the channel description (the channel itself stays in the shared memory)
+/// @param[in] ctx       Plugin context description
+/// @param[in] channel   Channel description
+BIFROST_PLUGIN_API bfp_Status bfp_ChannelFree(bfp_PluginContext* ctx, bfp_Channel* channel);
+
+/// @brief Push `count` elements to the channel (only one thread may push at a time)
+/// @param[in] ctx           Plugin context description
+/// @param[in] channel       Channel description
+/// @param[in] elements      Elements to push (`count * elementSize` bytes)
+/// @param[in] count         Number of elements to push
+/// @param[in] timeoutInMs   Time to wait for free space (0 to never wait, BIFROST_PLUGIN_CHANNEL_INFINITE to wait forever)
+/// @param[out] numPushed    Number of pushed elements (can be NULL)
+BIFROST_PLUGIN_API bfp_Status bfp_ChannelPush(bfp_PluginContext* ctx, bfp_Channel* channel, const void* elements, uint32_t count, uint32_t timeoutInMs,
+                                              uint32_t* numPushed);
+
+/// @brief Pop up to `count` elements from the channel (only one thread may pop at a time)
+/// @param[in] ctx           Plugin context description
+/// @param[in] channel       Channel description
+/// @param[out] elements     Buffer of at least `count * elementSize` bytes
+/// @param[in] count         Maximum number of elements to pop
+/// @param[in] timeoutInMs   Time to wait for the first element (0 to never wait, BIFROST_PLUGIN_CHANNEL_INFINITE to wait forever)
+/// @param[out] numPopped    Number of popped elements
+BIFROST_PLUGIN_API bfp_Status bfp_ChannelPop(bfp_PluginContext* ctx, bfp_Channel* channel, void* elements, uint32_t count, uint32_t timeoutInMs,
+                                             uint32_t* numPopped);
+
+#pragma endregion
+
 #if __cplusplus
 }  // extern "C"
 #endif
@@ -14,6 +14,7 @@
 #include "bifrost/core/common.h"
 
 #include "bifrost/api/plugin_context.h"
+#include "bifrost/core/exception.h"
 
 namespace bifrost::api {
 
@@ -92,9 +93,10 @@ bfp_Status PluginContext::TearDownEnd(bfp_PluginContext* ctx, const void* tearDo
     // Free allocated arguments
     if (args) delete args;
 
-    // Remove the shared logger
-    m_sharedLogger.reset();
+    // Publish the staged messages and remove the shared logger
+    m_sharedLogger->Flush();
     m_ctx->SetLogger(m_bufferedLogger.get());
+    m_sharedLogger.reset();
 
     // Disconnect the shared memory
     m_memory.reset();
@@ -114,6 +116,24 @@ bfp_Status PluginContext::Log(uint32_t level, const char* module, const char* ms
   return BFP_OK;
 }
 
+bfp_Status PluginContext::LogDeferred(uint32_t level, const char* module, const char* format, const void* args, uint32_t argsSize) {
+  if (!format) throw Exception("Failed to log: format is NULL");
+
+  // The format strings are string literals of the plugin, the site (and thus the atom of the format) is cached by address
+  DeferredFormatSite* site = nullptr;
+  {
+    BIFROST_LOCK_GUARD(m_deferredSitesMutex);
+    auto& deferredSite = m_deferredSites[format];
+    if (!deferredSite) deferredSite = std::make_unique<DeferredFormatSite>(format);
+    site = deferredSite.get();
+  }
+
+  DeferredArgs encodedArgs;
+  encodedArgs.Assign(static_cast<const u8*>(args), args ? argsSize : 0);
+  m_ctx->Logger().SinkDeferred((ILogger::LogLevel)level, module, *site, encodedArgs);
+  return BFP_OK;
+}
+
 PluginContext::~PluginContext() {
   m_sharedLogger.reset();
   m_memory.reset();
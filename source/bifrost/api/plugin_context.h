@@ -17,7 +17,9 @@
 #include "bifrost/api/plugin.h"
 #include "bifrost/core/buffered_logger.h"
 #include "bifrost/core/context.h"
+#include "bifrost/core/deferred_format.h"
 #include "bifrost/core/module_loader.h"
+#include "bifrost/core/mutex.h"
 #include "bifrost/core/shared_memory.h"
 #include "bifrost/core/timer.h"
 
@@ -51,6 +53,9 @@ class PluginContext {
   /// Log from the plugin
   bfp_Status Log(uint32_t level, const char* module, const char* msg);
 
+  /// Log the message of `format` with the encoded `args` from the plugin (`format` has to outlive the plugin context)
+  bfp_Status LogDeferred(uint32_t level, const char* module, const char* format, const void* args, uint32_t argsSize);
+
   /// Set the unique identifier of this plugin (used by the HookManager)
   u32 GetId() { return m_id; }
   void SetId(u32 id) { m_id = id; }
@@ -72,6 +77,9 @@ class PluginContext {
   std::unique_ptr<BufferedLogger> m_bufferedLogger;
   std::unique_ptr<SharedLogger> m_sharedLogger;
 
+  SpinMutex m_deferredSitesMutex;
+  std::unordered_map<const char*, std::unique_ptr<DeferredFormatSite>> m_deferredSites;
+
   Timer m_timer;
 };
 
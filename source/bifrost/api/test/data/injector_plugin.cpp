@@ -32,7 +32,11 @@ using namespace bifrost;
 
 class InjectorTestPlugin final : public ::injector_plugin::Plugin {
  public:
-  virtual void SetUp() override { WriteToFile(GetArguments(), "SetUp", this); }
+  virtual void SetUp() override {
+    WriteToFile(GetArguments(), "SetUp", this);
+    OpenChannel<std::int32_t>("InjectorTestPlugin", 16).TryPush(42);
+    LogDeferred(LogLevel::Info, "InjectorTestPlugin: %s #%i", "deferred", 1);
+  }
   virtual void TearDown() override { WriteToFile(GetArguments(), "TearDown", this); }
 
   static const char* Help() { return "Help"; }
@@ -54,6 +54,64 @@ TEST_F(TestInjector, LoadAndUnload) {
   ASSERT_EQ(Wait(loadResult.Process), 0);
 }
 
+std::vector<bfi_LogRecord> batchRecords;
+std::vector<u32> batchSizes;
+
+void BatchLogCallback(const bfi_LogRecord* records, uint32_t numRecords) {
+  batchSizes.emplace_back(numRecords);
+  for (u32 i = 0; i < numRecords; ++i) {
+    // The strings are only valid during the call
+    bfi_LogRecord record = records[i];
+    record.Module = record.Message = nullptr;
+    batchRecords.emplace_back(record);
+    LogCallback(records[i].Level, records[i].Module, records[i].Message);
+  }
+}
+
+TEST_F(TestInjector, BatchLoggingCallback) {
+  BIFROST_EXPECT_OK(bfi_ContextSetBatchLoggingCallback(GetContext(), BatchLogCallback, 4, 1000));
+
+  auto tmpFile = GetTmpFile();
+  auto launchArgs = MakeExecutableArgumentsForLaunch();
+  auto injectorArgs = MakeInjectorArguments();
+  auto pluginLoadDesc = MakePluginLoadDesc(tmpFile);
+
+  auto loadArgs = MakePluginLoadArguments(launchArgs, injectorArgs, pluginLoadDesc);
+  auto loadResult = Load(loadArgs);
+  ASSERT_EQ(Wait(loadResult.Process), 0);
+
+  // Deregistering delivers the remaining messages
+  BIFROST_EXPECT_OK(bfi_ContextSetBatchLoggingCallback(GetContext(), NULL, 0, 0));
+
+  ASSERT_FALSE(batchRecords.empty());
+  for (u32 size : batchSizes) EXPECT_LE(size, 4);
+  for (const auto& record : batchRecords) EXPECT_GT(record.Timestamp, 0);
+}
+
+std::vector<std::string> deferredMessages;
+
+void DeferredLogCallback(uint32_t level, const char* module, const char* msg) {
+  deferredMessages.emplace_back(msg);
+  LogCallback(level, module, msg);
+}
+
+TEST_F(TestInjector, DeferredLog) {
+  BIFROST_EXPECT_OK(bfi_ContextSetLoggingCallback(GetContext(), DeferredLogCallback));
+
+  auto tmpFile = GetTmpFile();
+  auto launchArgs = MakeExecutableArgumentsForLaunch();
+  auto injectorArgs = MakeInjectorArguments();
+  auto pluginLoadDesc = MakePluginLoadDesc(tmpFile);
+
+  auto loadArgs = MakePluginLoadArguments(launchArgs, injectorArgs, pluginLoadDesc);
+  auto loadResult = Load(loadArgs);
+  ASSERT_EQ(Wait(loadResult.Process), 0);
+
+  // Deregistering delivers the remaining messages
+  BIFROST_EXPECT_OK(bfi_ContextSetLoggingCallback(GetContext(), NULL));
+  EXPECT_NE(deferredMessages.end(), std::find(deferredMessages.begin(), deferredMessages.end(), "InjectorTestPlugin: deferred #1"));
+}
+
 TEST_F(TestInjector, LoadLoad) {
   auto tmpFile = GetTmpFile();
 
@@ -101,6 +159,95 @@ TEST_F(TestInjector, ForceLoadLoad) {
   ASSERT_STREQ(GetContent(tmpFile).c_str(), "SetUp:TearDown:SetUp:TearDown:") << "File: " << tmpFile;
 }
 
+TEST_F(TestInjector, Channel) {
+  auto tmpFile = GetTmpFile();
+
+  auto launchArgs = MakeExecutableArgumentsForLaunch();
+  auto injectorArgs = MakeInjectorArguments();
+  auto pluginLoadDesc = MakePluginLoadDesc(tmpFile);
+
+  // Load (the plugin pushes 42 during SetUp)
+  auto loadArgs = MakePluginLoadArguments(launchArgs, injectorArgs, pluginLoadDesc);
+  auto loadResult = Load(loadArgs);
+
+  bfi_Channel* channel = nullptr;
+  BIFROST_EXPECT_OK(bfi_ChannelOpen(GetContext(), "InjectorTestPlugin", sizeof(i32), 16, &channel));
+  ASSERT_NE(nullptr, channel);
+
+  i32 value = 0;
+  uint32_t numPopped = 0;
+  BIFROST_EXPECT_OK(bfi_ChannelPop(GetContext(), channel, &value, 1, 5000, &numPopped));
+  EXPECT_EQ(1, numPopped);
+  EXPECT_EQ(42, value);
+
+  // Nothing left
+  BIFROST_EXPECT_OK(bfi_ChannelPop(GetContext(), channel, &value, 1, 0, &numPopped));
+  EXPECT_EQ(0, numPopped);
+
+  // Element size mismatch
+  bfi_Channel* channel2 = nullptr;
+  EXPECT_EQ(BFP_ERROR, bfi_ChannelOpen(GetContext(), "InjectorTestPlugin", sizeof(double), 16, &channel2));
+
+  BIFROST_EXPECT_OK(bfi_ChannelFree(GetContext(), channel));
+
+  // Wait
+  ASSERT_EQ(Wait(loadResult.Process), 0);
+}
+
+TEST_F(TestInjector, Storage) {
+  // No shared memory yet
+  EXPECT_EQ(BFP_ERROR, bfi_StorageInsertInt(GetContext(), "InjectorTest", 1));
+
+  auto tmpFile = GetTmpFile();
+
+  auto launchArgs = MakeExecutableArgumentsForLaunch();
+  auto injectorArgs = MakeInjectorArguments();
+  auto pluginLoadDesc = MakePluginLoadDesc(tmpFile);
+
+  auto loadArgs = MakePluginLoadArguments(launchArgs, injectorArgs, pluginLoadDesc);
+  auto loadResult = Load(loadArgs);
+
+  uint64_t version = 0;
+  BIFROST_EXPECT_OK(bfi_StorageWatch(GetContext(), "InjectorTest", 0, 0, &version));
+  EXPECT_EQ(0, version);
+
+  BIFROST_EXPECT_OK(bfi_StorageInsertInt(GetContext(), "InjectorTest", 1));
+  BIFROST_EXPECT_OK(bfi_StorageWatch(GetContext(), "InjectorTest", 0, 0, &version));
+  EXPECT_NE(0, version);
+
+  // Timeout
+  uint64_t newVersion = 0;
+  BIFROST_EXPECT_OK(bfi_StorageWatch(GetContext(), "InjectorTest", version, 10, &newVersion));
+  EXPECT_EQ(version, newVersion);
+
+  // Change from another thread
+  std::thread writer([&]() {
+    ::Sleep(10);
+    const char blob[] = {1, 2, 3};
+    BIFROST_EXPECT_OK(bfi_StorageInsertBlob(GetContext(), "InjectorTest", blob, sizeof(blob)));
+  });
+  BIFROST_EXPECT_OK(bfi_StorageWatch(GetContext(), "InjectorTest", version, BIFROST_INJECTOR_STORAGE_INFINITE, &newVersion));
+  EXPECT_GT(newVersion, version);
+  writer.join();
+
+  // Typed arrays
+  const float floats[] = {1.0f, 2.0f};
+  const double doubles[] = {1.0, 2.0};
+  const int32_t ints32[] = {1, 2};
+  const int64_t ints64[] = {1, 2};
+  BIFROST_EXPECT_OK(bfi_StorageInsertFloatArray(GetContext(), "InjectorTestFloat", floats, 2));
+  BIFROST_EXPECT_OK(bfi_StorageInsertDoubleArray(GetContext(), "InjectorTestDouble", doubles, 2));
+  BIFROST_EXPECT_OK(bfi_StorageInsertInt32Array(GetContext(), "InjectorTestInt32", ints32, 2));
+  BIFROST_EXPECT_OK(bfi_StorageInsertInt64Array(GetContext(), "InjectorTestInt64", ints64, 2));
+
+  int32_t removed = 0;
+  BIFROST_EXPECT_OK(bfi_StorageRemove(GetContext(), "InjectorTest", &removed));
+  EXPECT_EQ(1, removed);
+
+  // Wait
+  ASSERT_EQ(Wait(loadResult.Process), 0);
+}
+
 TEST_F(TestInjector, Help) {
   // Help
   auto helpStr = Help();
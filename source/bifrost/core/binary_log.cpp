@@ -0,0 +1,287 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/binary_log.h"
+#include "bifrost/core/deferred_format.h"
+#include "bifrost/core/error.h"
+#include "bifrost/core/sm_atom_table.h"
+#include "bifrost/core/timestamp.h"
+#include "bifrost/core/util.h"
+
+namespace bifrost {
+
+namespace {
+
+inline u64 AlignFrameSize(u64 size) { return (size + 7) & ~u64(7); }
+
+}  // namespace
+
+namespace binary_log {
+
+std::filesystem::path GetFilePath(const std::filesystem::path& basePath, u64 fileIndex) {
+  std::filesystem::path path = basePath;
+  path += StringFormat(".%llu.bflog", fileIndex);
+  return path;
+}
+
+std::filesystem::path GetIndexPath(const std::filesystem::path& basePath) {
+  std::filesystem::path path = basePath;
+  path += ".bfidx";
+  return path;
+}
+
+std::vector<IndexEntry> ReadIndex(const std::filesystem::path& basePath) {
+  std::vector<IndexEntry> index;
+  std::ifstream ifs(GetIndexPath(basePath), std::ios::binary);
+  IndexEntry entry;
+  while (ifs.read((char*)&entry, sizeof(IndexEntry))) index.emplace_back(entry);
+  return index;
+}
+
+}  // namespace binary_log
+
+//
+// BinaryLogWriter
+//
+
+BinaryLogWriter::BinaryLogWriter(std::filesystem::path basePath, u64 maxFileSize, u32 maxFiles)
+    : m_basePath(std::move(basePath)), m_maxFileSize(std::max(maxFileSize, MinFileSize)), m_maxFiles(std::max(maxFiles, 1u)) {
+  // Continue after the files of previous sessions instead of overwriting them
+  m_index = binary_log::ReadIndex(m_basePath);
+  if (!m_index.empty()) m_fileIndex = m_index.back().FileIndex + 1;
+  OpenFile();
+}
+
+BinaryLogWriter::~BinaryLogWriter() { CloseFile(); }
+
+void BinaryLogWriter::Write(Context* ctx, const SMLogStash::RawLogMessage& msg) {
+  u32 format = 0;
+  if (msg.Deferred) std::memcpy(&format, msg.Data, sizeof(u32));
+
+  // Rotate if the message and the atoms it references don't fit into the current file
+  u64 size = AlignFrameSize(sizeof(binary_log::FrameHeader) + sizeof(binary_log::MessageFrameData) + msg.Length);
+  u64 requiredSize = size + AtomFrameSize(ctx, msg.Module) + (msg.Deferred ? AtomFrameSize(ctx, format) : 0);
+  if (((binary_log::FileHeader*)m_data)->UsedBytes + requiredSize > m_maxFileSize) {
+    CloseFile();
+    m_fileIndex++;
+    OpenFile();
+  }
+
+  WriteAtom(ctx, msg.Module);
+  if (msg.Deferred) WriteAtom(ctx, format);
+
+  u64 frameSize;
+  auto* data = (binary_log::MessageFrameData*)Append(binary_log::MessageFrame, sizeof(binary_log::MessageFrameData) + msg.Length, frameSize);
+  data->Timestamp = msg.Timestamp;
+  data->ThreadId = msg.ThreadId;
+  data->Level = msg.Level;
+  data->Module = msg.Module;
+  data->Deferred = msg.Deferred;
+  data->Length = msg.Length;
+  data->Padding = 0;
+  std::memcpy(data + 1, msg.Data, msg.Length);
+  Commit(frameSize);
+
+  binary_log::IndexEntry& entry = m_index.back();
+  u64 timestamp = TimestampToUnixMicroseconds(msg.Timestamp);
+  if (entry.NumMessages++ == 0) entry.FirstTimestamp = timestamp;
+  entry.FirstTimestamp = std::min(entry.FirstTimestamp, timestamp);
+  entry.LastTimestamp = std::max(entry.LastTimestamp, timestamp);
+}
+
+void BinaryLogWriter::Flush() {
+  if (!m_data) return;
+  u64 usedBytes = ((binary_log::FileHeader*)m_data)->UsedBytes;
+  ::FlushViewOfFile(m_data, usedBytes);
+
+  // Publish the timestamps and size of the current file
+  m_index.back().SizeInBytes = usedBytes;
+  WriteIndex();
+}
+
+void BinaryLogWriter::OpenFile() {
+  m_path = binary_log::GetFilePath(m_basePath, m_fileIndex);
+
+  m_file = ::CreateFileW(m_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (m_file == INVALID_HANDLE_VALUE) {
+    m_file = nullptr;
+    throw std::runtime_error(StringFormat("Failed to create binary log \"%s\": %s", m_path.string().c_str(), GetLastWin32Error().c_str()));
+  }
+
+  m_mapping = ::CreateFileMappingW(m_file, NULL, PAGE_READWRITE, (DWORD)(m_maxFileSize >> 32), (DWORD)m_maxFileSize, NULL);
+  if (m_mapping != NULL) m_data = (u8*)::MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_maxFileSize);
+  if (m_data == nullptr) {
+    std::string msg = StringFormat("Failed to map binary log \"%s\": %s", m_path.string().c_str(), GetLastWin32Error().c_str());
+    if (m_mapping != NULL) ::CloseHandle(m_mapping);
+    ::CloseHandle(m_file);
+    m_mapping = m_file = nullptr;
+    throw std::runtime_error(msg);
+  }
+
+  binary_log::FileHeader* header = (binary_log::FileHeader*)m_data;
+  std::memcpy(header->Magic, binary_log::Magic, sizeof(binary_log::Magic));
+  header->Version = binary_log::Version;
+  header->HeaderSize = (u32)AlignFrameSize(sizeof(binary_log::FileHeader));
+  header->FileIndex = m_fileIndex;
+  header->TimestampFrequency = GetTimestampFrequency();
+  header->OpenTimestamp = GetTimestamp();
+  header->OpenUnixMicroseconds = TimestampToUnixMicroseconds(header->OpenTimestamp);
+  header->UsedBytes = header->HeaderSize;
+
+  m_writtenAtoms.clear();
+  m_index.emplace_back(binary_log::IndexEntry{m_fileIndex, 0, 0, 0, header->UsedBytes});
+  RemoveOldestFiles();
+  WriteIndex();
+}
+
+void BinaryLogWriter::CloseFile() {
+  if (!m_data) return;
+
+  u64 usedBytes = ((binary_log::FileHeader*)m_data)->UsedBytes;
+  ::FlushViewOfFile(m_data, usedBytes);
+  ::UnmapViewOfFile(m_data);
+  ::CloseHandle(m_mapping);
+
+  // Shrink the file to the written frames
+  LARGE_INTEGER size;
+  size.QuadPart = (LONGLONG)usedBytes;
+  ::SetFilePointerEx(m_file, size, NULL, FILE_BEGIN);
+  ::SetEndOfFile(m_file);
+  ::CloseHandle(m_file);
+
+  m_data = nullptr;
+  m_mapping = m_file = nullptr;
+  m_index.back().SizeInBytes = usedBytes;
+  WriteIndex();
+}
+
+void BinaryLogWriter::RemoveOldestFiles() {
+  while (m_index.size() > m_maxFiles) {
+    std::error_code ec;
+    std::filesystem::remove(binary_log::GetFilePath(m_basePath, m_index.front().FileIndex), ec);
+    m_index.erase(m_index.begin());
+  }
+}
+
+void BinaryLogWriter::WriteIndex() {
+  std::ofstream ofs(binary_log::GetIndexPath(m_basePath), std::ios::binary | std::ios::trunc);
+  ofs.write((const char*)m_index.data(), m_index.size() * sizeof(binary_log::IndexEntry));
+}
+
+u64 BinaryLogWriter::AtomFrameSize(Context* ctx, u32 atom) const {
+  if (m_writtenAtoms.count(atom)) return 0;
+  return AlignFrameSize(sizeof(binary_log::FrameHeader) + sizeof(binary_log::AtomFrameData) +
+                        ctx->Memory().GetSMAtomTable()->GetString(ctx, atom).size());
+}
+
+void BinaryLogWriter::WriteAtom(Context* ctx, u32 atom) {
+  if (!m_writtenAtoms.insert(atom).second) return;
+
+  std::string_view str = ctx->Memory().GetSMAtomTable()->GetString(ctx, atom);
+  u64 frameSize;
+  auto* data = (binary_log::AtomFrameData*)Append(binary_log::AtomFrame, sizeof(binary_log::AtomFrameData) + str.size(), frameSize);
+  data->Atom = atom;
+  data->Length = (u32)str.size();
+  std::memcpy(data + 1, str.data(), str.size());
+  Commit(frameSize);
+}
+
+u8* BinaryLogWriter::Append(u32 type, u64 size, u64& frameSize) {
+  binary_log::FileHeader* header = (binary_log::FileHeader*)m_data;
+  frameSize = AlignFrameSize(sizeof(binary_log::FrameHeader) + size);
+  BIFROST_ASSERT(header->UsedBytes + frameSize <= m_maxFileSize);
+
+  auto* frame = (binary_log::FrameHeader*)(m_data + header->UsedBytes);
+  frame->Type = type;
+  frame->Size = (u32)frameSize;
+  return (u8*)(frame + 1);
+}
+
+void BinaryLogWriter::Commit(u64 frameSize) {
+  // The frame only becomes visible to readers of the mapping once its payload is complete
+  std::atomic_thread_fence(std::memory_order_release);
+  ((binary_log::FileHeader*)m_data)->UsedBytes += frameSize;
+}
+
+//
+// BinaryLogReader
+//
+
+BinaryLogReader::BinaryLogReader(const std::filesystem::path& path) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs.is_open()) throw std::runtime_error(StringFormat("Failed to open binary log \"%s\"", path.string().c_str()));
+  m_data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+
+  if (m_data.size() < sizeof(binary_log::FileHeader) || std::memcmp(m_data.data(), binary_log::Magic, sizeof(binary_log::Magic)) != 0) {
+    throw std::runtime_error(StringFormat("Failed to read binary log \"%s\": not a binary log file", path.string().c_str()));
+  }
+  std::memcpy(&m_header, m_data.data(), sizeof(binary_log::FileHeader));
+  if (m_header.Version != binary_log::Version) {
+    throw std::runtime_error(StringFormat("Failed to read binary log \"%s\": unsupported version %u", path.string().c_str(), m_header.Version));
+  }
+
+  // Ignore frames which were not completely written
+  m_data.resize(std::min<u64>(m_data.size(), m_header.UsedBytes));
+  m_pos = m_header.HeaderSize;
+}
+
+bool BinaryLogReader::Next(Message& msg) {
+  while (m_pos + sizeof(binary_log::FrameHeader) <= m_data.size()) {
+    binary_log::FrameHeader frame;
+    std::memcpy(&frame, m_data.data() + m_pos, sizeof(frame));
+    if (frame.Size < sizeof(frame) || m_pos + frame.Size > m_data.size()) return false;
+
+    const char* data = m_data.data() + m_pos + sizeof(frame);
+    m_pos += frame.Size;
+
+    // Frames whose payload exceeds the frame are corrupt, stop reading
+    u64 payloadSize = frame.Size - sizeof(frame);
+    if (frame.Type == binary_log::AtomFrame) {
+      binary_log::AtomFrameData atom;
+      if (payloadSize < sizeof(atom)) return false;
+      std::memcpy(&atom, data, sizeof(atom));
+      if (atom.Length > payloadSize - sizeof(atom)) return false;
+      m_atoms[atom.Atom].assign(data + sizeof(atom), atom.Length);
+
+    } else if (frame.Type == binary_log::MessageFrame) {
+      binary_log::MessageFrameData message;
+      if (payloadSize < sizeof(message)) return false;
+      std::memcpy(&message, data, sizeof(message));
+      if (message.Length > payloadSize - sizeof(message)) return false;
+      const char* payload = data + sizeof(message);
+
+      msg.Timestamp = ToUnixMicroseconds(message.Timestamp);
+      msg.ThreadId = message.ThreadId;
+      msg.Level = message.Level;
+      msg.Module = m_atoms[message.Module];
+      if (message.Deferred) {
+        u32 format = 0;
+        if (message.Length >= sizeof(u32)) std::memcpy(&format, payload, sizeof(u32));
+        msg.Text.clear();
+        FormatDeferred(msg.Text, m_atoms[format], (const u8*)payload + sizeof(u32), message.Length - std::min<u32>(message.Length, sizeof(u32)));
+      } else {
+        msg.Text.assign(payload, message.Length);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+u64 BinaryLogReader::ToUnixMicroseconds(u64 timestamp) const {
+  i64 delta = (i64)(timestamp - m_header.OpenTimestamp);
+  i64 frequency = (i64)m_header.TimestampFrequency;
+  i64 micros = (delta / frequency) * 1000000 + ((delta % frequency) * 1000000) / frequency;
+  return (u64)((i64)m_header.OpenUnixMicroseconds + micros);
+}
+
+}  // namespace bifrost
@@ -0,0 +1,169 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/non_copyable.h"
+#include "bifrost/core/sm_log_stash.h"
+
+namespace bifrost {
+
+/// Binary log file format
+///
+/// A binary log is a sequence of files "<base>.<n>.bflog" and an index "<base>.bfidx". Each file starts with a FileHeader followed by
+/// 8 byte aligned frames. Atom frames define the string of a module or format atom before its first use in the file, hence every file
+/// can be decoded on its own.
+namespace binary_log {
+
+constexpr char Magic[8] = {'B', 'F', 'L', 'O', 'G', 0, 0, 0};
+constexpr u32 Version = 1;
+
+struct FileHeader {
+  char Magic[8];
+  u32 Version;
+  u32 HeaderSize;
+  u64 FileIndex;
+  u64 TimestampFrequency;    ///< Ticks per second of the timestamps
+  u64 OpenTimestamp;         ///< Timestamp at the time the file was opened
+  u64 OpenUnixMicroseconds;  ///< `OpenTimestamp` in microseconds since the Unix epoch
+  u64 UsedBytes;             ///< Number of valid bytes in the file (including the header)
+};
+
+enum FrameType : u32 { AtomFrame = 1, MessageFrame };
+
+struct FrameHeader {
+  u32 Type;
+  u32 Size;  ///< Size of the frame including the header
+};
+
+struct AtomFrameData {
+  u32 Atom;
+  u32 Length;
+  // Followed by `Length` characters
+};
+
+struct MessageFrameData {
+  u64 Timestamp;
+  u32 ThreadId;
+  u32 Level;
+  u32 Module;
+  u32 Deferred;  ///< If non-zero, the data is the format atom followed by the encoded arguments
+  u32 Length;
+  u32 Padding;
+  // Followed by `Length` bytes of data
+};
+
+struct IndexEntry {
+  u64 FileIndex;
+  u64 FirstTimestamp;  ///< In microseconds since the Unix epoch
+  u64 LastTimestamp;   ///< In microseconds since the Unix epoch
+  u64 NumMessages;
+  u64 SizeInBytes;
+};
+
+/// Get the path of the file `fileIndex` of the binary log `basePath`
+extern std::filesystem::path GetFilePath(const std::filesystem::path& basePath, u64 fileIndex);
+
+/// Get the path of the index of the binary log `basePath`
+extern std::filesystem::path GetIndexPath(const std::filesystem::path& basePath);
+
+/// Read the index of the binary log `basePath` (returns an empty index if the index does not exist)
+extern std::vector<IndexEntry> ReadIndex(const std::filesystem::path& basePath);
+
+}  // namespace binary_log
+
+/// Append unformatted log stash messages to memory-mapped binary log files which are rotated once they reach `maxFileSize`
+class BinaryLogWriter : public NonCopyable {
+ public:
+  /// Default size of a file in bytes
+  static constexpr u64 DefaultMaxFileSize = 64 << 20;
+
+  /// Default number of files kept on disk
+  static constexpr u32 DefaultMaxFiles = 8;
+
+  /// Smallest size of a file in bytes
+  static constexpr u64 MinFileSize = 1 << 20;
+
+  /// Open the binary log at `basePath` and continue after the files of previous sessions - only the last `maxFiles` files are kept
+  BinaryLogWriter(std::filesystem::path basePath, u64 maxFileSize = DefaultMaxFileSize, u32 maxFiles = DefaultMaxFiles);
+  ~BinaryLogWriter();
+
+  /// Append `msg` - atoms are resolved in the shared memory of `ctx`
+  void Write(Context* ctx, const SMLogStash::RawLogMessage& msg);
+
+  /// Flush the written messages and the index to disk
+  void Flush();
+
+  /// Get the path of the current file
+  const std::filesystem::path& GetPath() const { return m_path; }
+
+ private:
+  void OpenFile();
+  void CloseFile();
+  void WriteIndex();
+  void RemoveOldestFiles();
+
+  /// Get the size of the atom frame of `atom` (0 if the atom was already written to the current file)
+  u64 AtomFrameSize(Context* ctx, u32 atom) const;
+
+  /// Write the atom frame of `atom` if the atom was not yet written to the current file
+  void WriteAtom(Context* ctx, u32 atom);
+
+  /// Prepare a frame of `type` with `size` bytes of data - returns a pointer to the data, the frame is written once `Commit` is called
+  u8* Append(u32 type, u64 size, u64& frameSize);
+
+  /// Make the frame prepared by `Append` visible by advancing the used bytes by `frameSize`
+  void Commit(u64 frameSize);
+
+  std::filesystem::path m_basePath;
+  std::filesystem::path m_path;
+  u64 m_maxFileSize;
+  u32 m_maxFiles;
+
+  u64 m_fileIndex = 0;
+  void* m_file = nullptr;
+  void* m_mapping = nullptr;
+  u8* m_data = nullptr;
+  std::unordered_set<u32> m_writtenAtoms;
+  std::vector<binary_log::IndexEntry> m_index;
+};
+
+/// Decode a binary log file written by BinaryLogWriter
+class BinaryLogReader {
+ public:
+  struct Message {
+    u64 Timestamp;  ///< In microseconds since the Unix epoch
+    u32 ThreadId;
+    u32 Level;
+    std::string Module;
+    std::string Text;
+  };
+
+  /// Read the binary log file `path` - throws if the file is not a binary log
+  explicit BinaryLogReader(const std::filesystem::path& path);
+
+  /// Decode the next message into `msg` - returns false at the end of the file
+  bool Next(Message& msg);
+
+  /// Get the header of the file
+  const binary_log::FileHeader& GetHeader() const { return m_header; }
+
+ private:
+  u64 ToUnixMicroseconds(u64 timestamp) const;
+
+  binary_log::FileHeader m_header;
+  std::vector<char> m_data;
+  u64 m_pos;
+  std::unordered_map<u32, std::string> m_atoms;
+};
+
+}  // namespace bifrost
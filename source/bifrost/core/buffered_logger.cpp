@@ -13,86 +13,149 @@
 
 #include "bifrost/core/common.h"
 #include "bifrost/core/buffered_logger.h"
+#include "bifrost/core/timestamp.h"
 #include "bifrost/core/util.h"
 #include <fstream>
 #include <iostream>
 
 namespace bifrost {
 
-template <class StreamT>
-static void FlushImpl(StreamT& os, const std::vector<BufferedLogger::LogMessage>& messages) {
-  for (const BufferedLogger::LogMessage& msg : messages) {
-    if (msg.Level == ILogger::LogLevel::Disable) return;
-
-    std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
-    auto now_ms = now.time_since_epoch();
-    auto now_sec = std::chrono::duration_cast<std::chrono::seconds>(now_ms);
-    auto tm_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now_ms - now_sec);
+namespace {
 
-    std::time_t currentTime = std::chrono::system_clock::to_time_t(now);
-    struct tm* localTime = std::localtime(&currentTime);
+/// Copy `src` to `dst` and truncate it to `maxLength` characters (truncated strings end in "...")
+void CopyTruncated(char* dst, u32 maxLength, const char* src) {
+  u32 length = 0;
+  for (; src[length] != '\0' && length < maxLength; ++length) dst[length] = src[length];
+  if (src[length] != '\0') std::memcpy(dst + maxLength - 3, "...", 3);
+  dst[length] = '\0';
+}
 
-    auto timeStr = StringFormat("%02i:%02i:%02i.%03i", localTime->tm_hour, localTime->tm_min, localTime->tm_sec, tm_ms.count());
+template <class StreamT>
+void FlushImpl(StreamT& os, TimestampFormatter& formatter, const BufferedLogger::LogMessage& msg) {
+  if (msg.Level == ILogger::LogLevel::Disable) return;
 
-    os << "[" << timeStr << "]";
+  os << "[" << formatter.Format(msg.Timestamp) << "] [" << msg.ThreadId << "]";
 
-    switch (msg.Level) {
-      case ILogger::LogLevel::Trace:
-        os << " [TRACE]";
-        break;
+  switch (msg.Level) {
+    case ILogger::LogLevel::Trace:
+      os << " [TRACE]";
+      break;
     case ILogger::LogLevel::Debug:
-        os << " [DEBUG]";
-        break;
-      case ILogger::LogLevel::Info:
-        os << " [INFO ]";
-        break;
-      case ILogger::LogLevel::Warn:
-        os << " [WARN ]";
-        break;
-      case ILogger::LogLevel::Error:
-        os << " [ERROR]";
-        break;
-    }
+      os << " [DEBUG]";
+      break;
+    case ILogger::LogLevel::Info:
+      os << " [INFO ]";
+      break;
+    case ILogger::LogLevel::Warn:
+      os << " [WARN ]";
+      break;
+    case ILogger::LogLevel::Error:
+      os << " [ERROR]";
+      break;
+  }
 
-    if (!msg.Module.empty()) {
-      os << " [" << msg.Module << "]";
-    }
-    os << ": " << msg.Message << std::endl;
+  if (msg.Module[0] != '\0') {
+    os << " [" << msg.Module << "]";
   }
+  os << ": " << msg.Message << std::endl;
 }
 
+}  // namespace
+
+BufferedLogger::BufferedLogger(u32 capacity) : m_messages(std::make_unique<LogMessage[]>(std::max(capacity, 1u))), m_capacity(std::max(capacity, 1u)) {}
+
 void BufferedLogger::SetModule(const char* module) {
   BIFROST_LOCK_GUARD(m_mutex);
   m_module = module;
 }
 
+void BufferedLogger::Push(LogLevel level, u64 timestamp, u32 threadId, const char* module, const char* msg) {
+  // Evict the oldest message
+  if (m_size == m_capacity) {
+    m_head = (m_head + 1) % m_capacity;
+    m_size -= 1;
+    m_numDropped += 1;
+  }
+
+  LogMessage& m = m_messages[(m_head + m_size) % m_capacity];
+  m.Level = level;
+  m.Timestamp = timestamp;
+  m.ThreadId = threadId;
+  CopyTruncated(m.Module, MaxModuleLength, module ? module : "");
+  CopyTruncated(m.Message, MaxMessageLength, msg);
+  m_size += 1;
+}
+
+template <class FunctorT>
+void BufferedLogger::ForEachAndClear(FunctorT&& functor) {
+  // Report the evicted messages before the oldest remaining message
+  if (m_numDropped > 0) {
+    LogMessage marker;
+    marker.Level = LogLevel::Warn;
+    marker.Timestamp = m_size > 0 ? m_messages[m_head].Timestamp : GetTimestamp();
+    marker.ThreadId = ::GetCurrentThreadId();
+    CopyTruncated(marker.Module, MaxModuleLength, m_module.c_str());
+    std::snprintf(marker.Message, sizeof(marker.Message), "Dropped %llu log messages as the log buffer was full", m_numDropped);
+    functor(marker);
+  }
+
+  for (u32 i = 0; i < m_size; ++i) functor(m_messages[(m_head + i) % m_capacity]);
+  m_head = 0;
+  m_size = 0;
+  m_numDropped = 0;
+}
+
 void BufferedLogger::Sink(LogLevel level, const char* module, const char* msg) {
+  u64 timestamp = GetTimestamp();
   BIFROST_LOCK_GUARD(m_mutex);
-  m_messages.emplace_back(LogMessage{level, module, msg});
+  Push(level, timestamp, ::GetCurrentThreadId(), module, msg);
 }
 
 void BufferedLogger::Sink(LogLevel level, const char* msg) { Sink(level, m_module.c_str(), msg); }
 
+void BufferedLogger::SinkBatch(const LogRecord* records, u64 count) {
+  u64 timestamp = GetTimestamp();
+  BIFROST_LOCK_GUARD(m_mutex);
+  for (u64 i = 0; i < count; ++i) {
+    const LogRecord& r = records[i];
+    if (r.Timestamp != 0) {
+      Push(r.Level, r.Timestamp, r.ThreadId, r.Module, r.Message);
+    } else {
+      Push(r.Level, timestamp, ::GetCurrentThreadId(), r.Module, r.Message);
+    }
+  }
+}
+
 void BufferedLogger::Flush(ILogger* logger) {
   BIFROST_LOCK_GUARD(m_mutex);
-  for (const auto& msg : m_messages) logger->Sink(msg.Level, msg.Module.c_str(), msg.Message.c_str());
-  m_messages.clear();
+
+  // Forward the messages in chunks to not allocate
+  LogRecord records[64];
+  u32 numRecords = 0;
+  ForEachAndClear([&](const LogMessage& msg) {
+    records[numRecords++] = LogRecord{msg.Level, msg.Module, msg.Message, msg.Timestamp, msg.ThreadId};
+    if (numRecords == ArraySize(records)) {
+      logger->SinkBatch(records, numRecords);
+      numRecords = 0;
+    }
+  });
+  if (numRecords > 0) logger->SinkBatch(records, numRecords);
 }
 
 bool BufferedLogger::FlushToDisk(const std::filesystem::path& path) {
   BIFROST_LOCK_GUARD(m_mutex);
   std::ofstream ofs(path.string());
   if (!ofs.is_open()) return false;
-  FlushImpl(ofs, m_messages);
+  TimestampFormatter formatter;
+  ForEachAndClear([&](const LogMessage& msg) { FlushImpl(ofs, formatter, msg); });
   ofs.close();
-  m_messages.clear();
   return true;
 }
 
 bool BufferedLogger::FlushToErr() {
   BIFROST_LOCK_GUARD(m_mutex);
-  FlushImpl(std::cerr, m_messages);
-  m_messages.clear();
+  TimestampFormatter formatter;
+  ForEachAndClear([&](const LogMessage& msg) { FlushImpl(std::cerr, formatter, msg); });
   return true;
 }
 
@@ -101,4 +164,14 @@ const char* BufferedLogger::GetModule() {
   return m_module.c_str();
 }
 
-}  // namespace bifrost
\ No newline at end of file
+u32 BufferedLogger::GetNumMessages() {
+  BIFROST_LOCK_GUARD(m_mutex);
+  return m_size;
+}
+
+u64 BufferedLogger::GetNumDropped() {
+  BIFROST_LOCK_GUARD(m_mutex);
+  return m_numDropped;
+}
+
+}  // namespace bifrost
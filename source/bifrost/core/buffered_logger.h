@@ -17,18 +17,33 @@
 
 namespace bifrost {
 
-/// Buffer the log messages
+/// Buffer the log messages in a fixed-capacity ring - once full, the oldest messages are evicted
 class BufferedLogger final : public ILogger {
  public:
+  /// Default number of buffered messages
+  static constexpr u32 DefaultCapacity = 512;
+
+  /// Maximum length of the module of a message (longer modules are truncated)
+  static constexpr u32 MaxModuleLength = 63;
+
+  /// Maximum length of a message (longer messages are truncated)
+  static constexpr u32 MaxMessageLength = 447;
+
   struct LogMessage {
     LogLevel Level;
-    std::string Module;
-    std::string Message;
+    u64 Timestamp;
+    u32 ThreadId;
+    char Module[MaxModuleLength + 1];
+    char Message[MaxMessageLength + 1];
   };
 
+  /// Allocate the ring of `capacity` messages
+  explicit BufferedLogger(u32 capacity = DefaultCapacity);
+
   virtual void SetModule(const char* module) override;
   virtual void Sink(LogLevel level, const char* module, const char* msg) override;
   virtual void Sink(LogLevel level, const char* msg) override;
+  virtual void SinkBatch(const LogRecord* records, u64 count) override;
 
   /// Flush the messages to `logger`
   void Flush(ILogger* logger);
@@ -42,10 +57,25 @@ class BufferedLogger final : public ILogger {
   /// Access the module
   const char* GetModule();
 
+  /// Get the number of buffered messages
+  u32 GetNumMessages();
+
+  /// Get the number of messages evicted since the last flush
+  u64 GetNumDropped();
+
  private:
+  void Push(LogLevel level, u64 timestamp, u32 threadId, const char* module, const char* msg);
+
+  template <class FunctorT>
+  void ForEachAndClear(FunctorT&& functor);
+
   SpinMutex m_mutex;
   std::string m_module;
-  std::vector<LogMessage> m_messages;
+  std::unique_ptr<LogMessage[]> m_messages;
+  u32 m_capacity;
+  u32 m_head = 0;
+  u32 m_size = 0;
+  u64 m_numDropped = 0;
 };
 
 }  // namespace bifrost
\ No newline at end of file
@@ -0,0 +1,269 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/deferred_format.h"
+#include "bifrost/core/context.h"
+#include "bifrost/core/shared_memory.h"
+#include "bifrost/core/sm_atom_table.h"
+#include "bifrost/core/sm_context.h"
+
+namespace bifrost {
+
+u32 DeferredFormatSite::GetAtom(Context* ctx) {
+  // Regions are told apart by their id, a new region may be mapped at the address of a previous one
+  u64 regionId = ctx->Memory().GetSMContext()->GetId();
+  if (m_state.load(std::memory_order_acquire) == Ready && m_regionId == regionId) return m_atom;
+
+  u32 atom = ctx->Memory().GetSMAtomTable()->Intern(ctx, m_format);
+
+  u32 expected = Empty;
+  if (m_state.compare_exchange_strong(expected, Writing, std::memory_order_acquire)) {
+    m_regionId = regionId;
+    m_atom = atom;
+    m_state.store(Ready, std::memory_order_release);
+  }
+  return atom;
+}
+
+namespace {
+
+/// Decoded deferred argument
+struct DeferredArg {
+  DeferredArgTag Tag;
+  i64 I;
+  u64 U;
+  double F;
+  std::string_view S;
+};
+
+bool DecodeArg(const u8* args, u64 size, u64& pos, DeferredArg& arg) {
+  if (pos >= size) return false;
+  arg.Tag = (DeferredArgTag)args[pos++];
+
+  auto read = [&](void* value, u64 valueSize) {
+    if (pos + valueSize > size) return false;
+    std::memcpy(value, args + pos, valueSize);
+    pos += valueSize;
+    return true;
+  };
+
+  switch (arg.Tag) {
+    case DeferredArgTag::I32: {
+      i32 value;
+      if (!read(&value, sizeof(value))) return false;
+      arg.I = value;
+      arg.U = (u32)value;
+      arg.F = value;
+      return true;
+    }
+    case DeferredArgTag::U32: {
+      u32 value;
+      if (!read(&value, sizeof(value))) return false;
+      arg.I = value;
+      arg.U = value;
+      arg.F = value;
+      return true;
+    }
+    case DeferredArgTag::I64: {
+      if (!read(&arg.I, sizeof(arg.I))) return false;
+      arg.U = (u64)arg.I;
+      arg.F = (double)arg.I;
+      return true;
+    }
+    case DeferredArgTag::U64:
+    case DeferredArgTag::Ptr: {
+      if (!read(&arg.U, sizeof(arg.U))) return false;
+      arg.I = (i64)arg.U;
+      arg.F = (double)arg.U;
+      return true;
+    }
+    case DeferredArgTag::F64: {
+      if (!read(&arg.F, sizeof(arg.F))) return false;
+      arg.I = (i64)arg.F;
+      arg.U = (u64)arg.F;
+      return true;
+    }
+    case DeferredArgTag::Str: {
+      u32 length;
+      if (!read(&length, sizeof(length)) || pos + length > size) return false;
+      arg.S = std::string_view((const char*)args + pos, length);
+      pos += length;
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+template <class T>
+void AppendFormat(std::string& out, const char* spec, T value) {
+  char buffer[128];
+  int size = std::snprintf(buffer, sizeof(buffer), spec, value);
+  if (size < 0) return;
+  if (size < (int)sizeof(buffer)) {
+    out.append(buffer, size);
+  } else {
+    std::size_t offset = out.size();
+    out.resize(offset + size + 1);
+    std::snprintf(out.data() + offset, size + 1, spec, value);
+    out.resize(offset + size);
+  }
+}
+
+}  // namespace
+
+void FormatDeferred(std::string& out, std::string_view fmt, const u8* args, u64 size) {
+  const char* invalidArg = "<?>";
+  u64 pos = 0;
+  std::string str;
+
+  for (std::size_t i = 0; i < fmt.size(); ++i) {
+    if (fmt[i] != '%') {
+      out.push_back(fmt[i]);
+      continue;
+    }
+    if (i + 1 < fmt.size() && fmt[i + 1] == '%') {
+      out.push_back('%');
+      ++i;
+      continue;
+    }
+
+    // Parse %[flags][width][.precision][length]conversion and rebuild the specification without the length modifier (a modifier
+    // matching the decoded argument is appended below), a `*` width or precision is replaced by the value of its argument
+    char spec[64];
+    std::size_t specSize = 0;
+    bool validSpec = true;
+    auto appendSpec = [&](const char* str, std::size_t length) {
+      if (specSize + length + 4 > sizeof(spec)) {
+        validSpec = false;
+      } else {
+        std::memcpy(spec + specSize, str, length);
+        specSize += length;
+      }
+    };
+    auto parseNumber = [&](bool precision) {
+      if (i < fmt.size() && fmt[i] == '*') {
+        ++i;
+        DeferredArg starArg;
+        if (!DecodeArg(args, size, pos, starArg) || starArg.Tag == DeferredArgTag::Str) {
+          validSpec = false;
+          return;
+        }
+        // A negative precision is treated as if it was omitted
+        if (precision && starArg.I < 0) return;
+        char digits[32];
+        int length = std::snprintf(digits, sizeof(digits), precision ? ".%lld" : "%lld", (long long)starArg.I);
+        appendSpec(digits, (std::size_t)length);
+      } else {
+        std::size_t numberStart = precision ? i - 1 : i;
+        while (i < fmt.size() && std::isdigit((unsigned char)fmt[i])) ++i;
+        appendSpec(fmt.data() + numberStart, i - numberStart);
+      }
+    };
+
+    std::size_t start = i++;
+    while (i < fmt.size() && std::strchr("-+ #0", fmt[i]) && fmt[i] != '\0') ++i;
+    appendSpec(fmt.data() + start, i - start);
+    parseNumber(false);
+    if (i < fmt.size() && fmt[i] == '.') {
+      ++i;
+      parseNumber(true);
+    }
+    while (i < fmt.size() && std::strchr("hljztLI", fmt[i]) && fmt[i] != '\0') ++i;
+    while (i < fmt.size() && std::isdigit((unsigned char)fmt[i])) ++i;  // MSVC's I32/I64
+
+    if (i >= fmt.size()) {
+      out.append(fmt.substr(start));
+      break;
+    }
+
+    // The argument is consumed even if the specification is invalid to keep the following arguments in sync
+    DeferredArg arg;
+    if (!DecodeArg(args, size, pos, arg) || !validSpec) {
+      out.append(invalidArg);
+      continue;
+    }
+    char* specEnd = spec + specSize;
+
+    char conversion = fmt[i];
+    switch (conversion) {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o':
+        if (arg.Tag == DeferredArgTag::Str) {
+          out.append(invalidArg);
+          break;
+        }
+        std::memcpy(specEnd, "ll", 2);
+        specEnd[2] = conversion;
+        specEnd[3] = '\0';
+        if (conversion == 'd' || conversion == 'i') {
+          AppendFormat(out, spec, (long long)arg.I);
+        } else {
+          AppendFormat(out, spec, (unsigned long long)arg.U);
+        }
+        break;
+      case 'c':
+        if (arg.Tag == DeferredArgTag::Str) {
+          out.append(invalidArg);
+          break;
+        }
+        specEnd[0] = 'c';
+        specEnd[1] = '\0';
+        AppendFormat(out, spec, (int)arg.I);
+        break;
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+        if (arg.Tag == DeferredArgTag::Str) {
+          out.append(invalidArg);
+          break;
+        }
+        specEnd[0] = conversion;
+        specEnd[1] = '\0';
+        AppendFormat(out, spec, arg.F);
+        break;
+      case 'p':
+        if (arg.Tag == DeferredArgTag::Str) {
+          out.append(invalidArg);
+          break;
+        }
+        specEnd[0] = 'p';
+        specEnd[1] = '\0';
+        AppendFormat(out, spec, (const void*)arg.U);
+        break;
+      case 's':
+        if (arg.Tag != DeferredArgTag::Str) {
+          out.append(invalidArg);
+          break;
+        }
+        specEnd[0] = 's';
+        specEnd[1] = '\0';
+        str.assign(arg.S);
+        AppendFormat(out, spec, str.c_str());
+        break;
+      default:
+        out.append(invalidArg);
+        break;
+    }
+  }
+}
+
+}  // namespace bifrost
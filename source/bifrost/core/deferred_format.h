@@ -0,0 +1,148 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/type.h"
+
+namespace bifrost {
+
+class Context;
+
+/// Format string of a deferred log call site - the string is interned once per shared memory region and referenced by its atom
+class DeferredFormatSite {
+ public:
+  constexpr DeferredFormatSite(const char* format) : m_format(format) {}
+
+  /// Get the format string
+  const char* GetFormat() const noexcept { return m_format; }
+
+  /// Get the atom of the format string in the shared memory of `ctx` (interns the format string on first use)
+  u32 GetAtom(Context* ctx);
+
+ private:
+  enum State : u32 { Empty = 0, Writing, Ready };
+
+  // Atom of the first region the site is used in (other regions intern the format string on every call)
+  const char* m_format;
+  std::atomic<u32> m_state{Empty};
+  u64 m_regionId = 0;
+  u32 m_atom = 0;
+};
+
+/// Type tag of an encoded deferred argument
+enum class DeferredArgTag : u8 { I32 = 0, U32, I64, U64, F64, Ptr, Str };
+
+/// Arguments of a deferred log call encoded as a tag byte followed by the raw value (strings are stored as u32 length + characters)
+class DeferredArgs {
+ public:
+  /// Maximum size of the encoded arguments in bytes
+  static constexpr u32 Capacity = 512;
+
+  /// Encode `args`
+  template <class... Args>
+  void Encode(Args&&... args) {
+    (EncodeArg(std::forward<Args>(args)), ...);
+  }
+
+  /// Copy the already encoded arguments `data` of `size` bytes (truncated to `Capacity`)
+  void Assign(const u8* data, u64 size) {
+    m_size = (u32)std::min<u64>(size, Capacity);
+    if (m_size > 0) std::memcpy(m_data, data, m_size);
+  }
+
+  /// Get the encoded arguments
+  const u8* Data() const noexcept { return m_data; }
+
+  /// Get the size of the encoded arguments in bytes
+  u32 Size() const noexcept { return m_size; }
+
+ private:
+  template <class T>
+  void EncodeArg(const T& arg) {
+    using ArgT = std::decay_t<T>;
+    if constexpr (std::is_enum<ArgT>::value) {
+      EncodeArg(static_cast<std::underlying_type_t<ArgT>>(arg));
+    } else if constexpr (std::is_same<ArgT, bool>::value) {
+      EncodeValue(DeferredArgTag::U32, (u32)arg);
+    } else if constexpr (std::is_integral<ArgT>::value && std::is_signed<ArgT>::value) {
+      if constexpr (sizeof(ArgT) <= 4) {
+        EncodeValue(DeferredArgTag::I32, (i32)arg);
+      } else {
+        EncodeValue(DeferredArgTag::I64, (i64)arg);
+      }
+    } else if constexpr (std::is_integral<ArgT>::value) {
+      if constexpr (sizeof(ArgT) <= 4) {
+        EncodeValue(DeferredArgTag::U32, (u32)arg);
+      } else {
+        EncodeValue(DeferredArgTag::U64, (u64)arg);
+      }
+    } else if constexpr (std::is_floating_point<ArgT>::value) {
+      EncodeValue(DeferredArgTag::F64, (double)arg);
+    } else if constexpr (std::is_same<ArgT, char*>::value || std::is_same<ArgT, const char*>::value) {
+      EncodeString(arg == nullptr ? std::string_view("(null)") : std::string_view(arg));
+    } else if constexpr (std::is_same<ArgT, std::string>::value || std::is_same<ArgT, std::string_view>::value) {
+      EncodeString(arg);
+    } else if constexpr (std::is_pointer<ArgT>::value && !std::is_same<std::remove_cv_t<std::remove_pointer_t<ArgT>>, wchar_t>::value) {
+      EncodeValue(DeferredArgTag::Ptr, (u64)arg);
+    } else {
+      // Wide strings would be printed as pointers by %s
+      static_assert(std::is_void<ArgT>::value, "unsupported deferred log argument");
+    }
+  }
+
+  template <class T>
+  void EncodeValue(DeferredArgTag tag, T value) {
+    if (m_size + 1 + sizeof(T) > Capacity) return;
+    m_data[m_size++] = (u8)tag;
+    std::memcpy(m_data + m_size, &value, sizeof(T));
+    m_size += sizeof(T);
+  }
+
+  void EncodeString(std::string_view str) {
+    if (m_size + 1 + sizeof(u32) > Capacity) return;
+    u32 length = (u32)std::min<u64>(str.size(), Capacity - m_size - 1 - sizeof(u32));
+    m_data[m_size++] = (u8)DeferredArgTag::Str;
+    std::memcpy(m_data + m_size, &length, sizeof(u32));
+    std::memcpy(m_data + m_size + sizeof(u32), str.data(), length);
+    m_size += sizeof(u32) + length;
+  }
+
+  u8 m_data[Capacity];
+  u32 m_size = 0;
+};
+
+/// Format the encoded arguments `args` of size `size` with the printf-style format string `fmt` and append the result to `out`
+///
+/// Missing or mismatching arguments are printed as "<?>".
+extern void FormatDeferred(std::string& out, std::string_view fmt, const u8* args, u64 size);
+
+/// Format the encoded arguments `args` of size `size` with the printf-style format string `fmt`
+inline std::string FormatDeferred(std::string_view fmt, const u8* args, u64 size) {
+  std::string out;
+  FormatDeferred(out, fmt, args, size);
+  return out;
+}
+
+}  // namespace bifrost
+
+/// Log the printf-style message `fmt` at `level` to `logger` - formatting is deferred to the consumer of the log
+///
+/// The format string has to be a string literal. Arguments are encoded in binary and the message is formatted by the injector (if the
+/// logger forwards to the shared log stash) or in place otherwise.
+#define BIFROST_LOG_DEFERRED(logger, level, fmt, ...)                           \
+  do {                                                                          \
+    if (::bifrost::ILogger::IsCompiledIn(level)) {                              \
+      static ::bifrost::DeferredFormatSite __bifrost_deferred_site(fmt);        \
+      (logger).LogDeferred((level), __bifrost_deferred_site, ##__VA_ARGS__);    \
+    }                                                                           \
+  } while (0)
@@ -0,0 +1,45 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/event.h"
+#include "bifrost/core/error.h"
+#include "bifrost/core/util.h"
+
+namespace bifrost {
+
+Event::Event(std::string name) : m_name(std::move(name)) {
+  m_handle = ::CreateEventA(NULL,   // Default security
+                            FALSE,  // Auto-reset
+                            FALSE,  // Initially not signaled
+                            GetName());
+  if (m_handle == NULL) {
+    throw std::runtime_error(StringFormat("Failed to create event \"%s\": %s", GetName(), GetLastWin32Error().c_str()));
+  }
+}
+
+Event::~Event() { ::CloseHandle(m_handle); }
+
+void Event::Signal() {
+  if (::SetEvent(m_handle) == 0) {
+    throw std::runtime_error(StringFormat("Failed to signal event \"%s\": %s", GetName(), GetLastWin32Error().c_str()));
+  }
+}
+
+bool Event::Wait(u32 timeoutInMs) {
+  DWORD reason = ::WaitForSingleObject(m_handle, timeoutInMs == Infinite ? INFINITE : timeoutInMs);
+  if (reason == WAIT_FAILED) {
+    throw std::runtime_error(StringFormat("Failed to wait for event \"%s\": %s", GetName(), GetLastWin32Error().c_str()));
+  }
+  return reason == WAIT_OBJECT_0;
+}
+
+}  // namespace bifrost
@@ -0,0 +1,44 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/non_copyable.h"
+#include "bifrost/core/type.h"
+
+namespace bifrost {
+
+/// Named auto-reset event which can be signaled across processes
+class Event : public NonCopyable {
+ public:
+  /// Wait forever
+  static constexpr u32 Infinite = 0xFFFFFFFF;
+
+  /// Create or open the event ``name``
+  Event(std::string name);
+  ~Event();
+
+  /// Get the name of the event
+  const char* GetName() const noexcept { return m_name.c_str(); }
+
+  /// Wake up one waiting thread (or the next thread calling `Wait` if nobody is waiting)
+  void Signal();
+
+  /// Wait until the event is signaled or `timeoutInMs` elapsed - returns true if the event was signaled
+  bool Wait(u32 timeoutInMs = Infinite);
+
+ private:
+  HANDLE m_handle;
+  std::string m_name;
+};
+
+}  // namespace bifrost
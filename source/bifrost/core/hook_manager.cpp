@@ -26,9 +26,9 @@ namespace bifrost {
 
 namespace {
 
-#define BIFROST_HOOK_DEBUG(...)             \
-  if (GetSettings()->Debug) {               \
-    ctx->Logger().DebugFormat(__VA_ARGS__); \
+#define BIFROST_HOOK_DEBUG(fmt, ...)                                                                     \
+  if (GetSettings()->Debug && BIFROST_LOG_ENABLED(ctx->Logger(), ::bifrost::ILogger::LogLevel::Debug)) { \
+    BIFROST_LOG_DEFERRED(ctx->Logger(), ::bifrost::ILogger::LogLevel::Debug, fmt, ##__VA_ARGS__);        \
   }
 
 /// RAII construct for suspending all threads (besides the calling thread) of this process
@@ -108,13 +108,13 @@ class HookManager::Impl {
 
     HookChain* chain = GetHookChain(target);
     if (!chain) {
-      BIFROST_HOOK_DEBUG("Skipped removing hook from %s: target has no hook");
+      BIFROST_HOOK_DEBUG("Skipped removing hook from %s: target has no hook", m_debugger->SymbolFromAdress(ctx, target));
       return;
     }
 
     HookChainNode* node = chain->GetById(id);
     if (!node) {
-      BIFROST_HOOK_DEBUG("Skipped removing hook from %s: target has no hook for the specified id");
+      BIFROST_HOOK_DEBUG("Skipped removing hook from %s: target has no hook for the specified id", m_debugger->SymbolFromAdress(ctx, target));
       return;
     }
 
@@ -40,9 +40,9 @@ class HookObject {
   HookDebugger* m_debugger;
 };
 
-#define BIFROST_HOOK_TRACE(ctx, ...)          \
-  if (this->Settings().Debug) {               \
-    (ctx)->Logger().TraceFormat(__VA_ARGS__); \
+#define BIFROST_HOOK_TRACE(ctx, fmt, ...)                                                                    \
+  if (this->Settings().Debug && BIFROST_LOG_ENABLED((ctx)->Logger(), ::bifrost::ILogger::LogLevel::Trace)) { \
+    BIFROST_LOG_DEFERRED((ctx)->Logger(), ::bifrost::ILogger::LogLevel::Trace, fmt, ##__VA_ARGS__);           \
   }
 
 }  // namespace bifrost
\ No newline at end of file
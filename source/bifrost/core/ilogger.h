@@ -11,8 +11,22 @@
 
 #pragma once
 
+#include "bifrost/core/deferred_format.h"
+#include "bifrost/core/log_rate_limiter.h"
 #include "bifrost/core/util.h"
 
+/// Minimum log level compiled into the binary (0 = Trace, 1 = Debug, 2 = Info, 3 = Warn, 4 = Error) - calls below the level compile away
+#ifndef BIFROST_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define BIFROST_LOG_MIN_LEVEL 2
+#else
+#define BIFROST_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+/// Check if `logger` logs messages at `level` - use it to guard the evaluation of expensive log arguments
+#define BIFROST_LOG_ENABLED(logger, level) (::bifrost::ILogger::IsCompiledIn(level) && (logger).IsEnabled(level))
+
 namespace bifrost {
 
 /// Logger interface
@@ -22,66 +36,104 @@ class ILogger {
 
   enum class LogLevel : u32 { Trace = 0, Debug, Info, Warn, Error, Disable };
 
+  /// Log message passed to `SinkBatch`
+  struct LogRecord {
+    LogLevel Level;
+    const char* Module;
+    const char* Message;
+    u64 Timestamp = 0;  ///< Time of the log call (see GetTimestamp) or 0 if unknown
+    u32 ThreadId = 0;   ///< Thread of the log call or 0 if unknown
+  };
+
   /// Log message at trace level
-  void Trace(const char* msg) { Sink(LogLevel::Trace, msg); }
-  void Trace(const wchar_t* msg) { Sink(LogLevel::Trace, WStringToString(msg).c_str()); }
+  void Trace(const char* msg) { Log<LogLevel::Trace>(msg); }
+  void Trace(const wchar_t* msg) { Log<LogLevel::Trace>(msg); }
   template <class... Args>
   void TraceFormat(const char* fmt, Args&&... args) {
-    Sink(LogLevel::Trace, StringFormat(fmt, std::forward<Args>(args)...).c_str());
+    LogFormat<LogLevel::Trace>(fmt, std::forward<Args>(args)...);
   }
   template <class... Args>
   void TraceFormat(const wchar_t* fmt, Args&&... args) {
-    Sink(LogLevel::Trace, WStringToString(StringFormat(fmt, std::forward<Args>(args)...)).c_str());
+    LogFormat<LogLevel::Trace>(fmt, std::forward<Args>(args)...);
   }
 
   /// Log message at debug level
-  void Debug(const char* msg) { Sink(LogLevel::Debug, msg); }
-  void Debug(const wchar_t* msg) { Sink(LogLevel::Debug, WStringToString(msg).c_str()); }
+  void Debug(const char* msg) { Log<LogLevel::Debug>(msg); }
+  void Debug(const wchar_t* msg) { Log<LogLevel::Debug>(msg); }
   template <class... Args>
   void DebugFormat(const char* fmt, Args&&... args) {
-    Sink(LogLevel::Debug, StringFormat(fmt, std::forward<Args>(args)...).c_str());
+    LogFormat<LogLevel::Debug>(fmt, std::forward<Args>(args)...);
   }
   template <class... Args>
   void DebugFormat(const wchar_t* fmt, Args&&... args) {
-    Sink(LogLevel::Debug, WStringToString(StringFormat(fmt, std::forward<Args>(args)...)).c_str());
+    LogFormat<LogLevel::Debug>(fmt, std::forward<Args>(args)...);
   }
 
   /// Log message at info level
-  void Info(const char* msg) { Sink(LogLevel::Info, msg); }
-  void Info(const wchar_t* msg) { Sink(LogLevel::Info, WStringToString(msg).c_str()); }
+  void Info(const char* msg) { Log<LogLevel::Info>(msg); }
+  void Info(const wchar_t* msg) { Log<LogLevel::Info>(msg); }
   template <class... Args>
   void InfoFormat(const char* fmt, Args&&... args) {
-    Sink(LogLevel::Info, StringFormat(fmt, std::forward<Args>(args)...).c_str());
+    LogFormat<LogLevel::Info>(fmt, std::forward<Args>(args)...);
   }
   template <class... Args>
   void InfoFormat(const wchar_t* fmt, Args&&... args) {
-    Sink(LogLevel::Info, WStringToString(StringFormat(fmt, std::forward<Args>(args)...)).c_str());
+    LogFormat<LogLevel::Info>(fmt, std::forward<Args>(args)...);
   }
 
   /// Log message at warn level
-  void Warn(const char* msg) { Sink(LogLevel::Warn, msg); }
-  void Warn(const wchar_t* msg) { Sink(LogLevel::Warn, WStringToString(msg).c_str()); }
+  void Warn(const char* msg) { Log<LogLevel::Warn>(msg); }
+  void Warn(const wchar_t* msg) { Log<LogLevel::Warn>(msg); }
   template <class... Args>
   void WarnFormat(const char* fmt, Args&&... args) {
-    Sink(LogLevel::Warn, StringFormat(fmt, std::forward<Args>(args)...).c_str());
+    LogFormat<LogLevel::Warn>(fmt, std::forward<Args>(args)...);
   }
   template <class... Args>
   void WarnFormat(const wchar_t* fmt, Args&&... args) {
-    Sink(LogLevel::Warn, WStringToString(StringFormat(fmt, std::forward<Args>(args)...)).c_str());
+    LogFormat<LogLevel::Warn>(fmt, std::forward<Args>(args)...);
   }
 
   /// Log message at error level
-  void Error(const char* msg) { Sink(LogLevel::Error, msg); }
-  void Error(const wchar_t* msg) { Sink(LogLevel::Error, WStringToString(msg).c_str()); }
+  void Error(const char* msg) { Log<LogLevel::Error>(msg); }
+  void Error(const wchar_t* msg) { Log<LogLevel::Error>(msg); }
   template <class... Args>
   void ErrorFormat(const char* fmt, Args&&... args) {
-    Sink(LogLevel::Error, StringFormat(fmt, std::forward<Args>(args)...).c_str());
+    LogFormat<LogLevel::Error>(fmt, std::forward<Args>(args)...);
   }
   template <class... Args>
   void ErrorFormat(const wchar_t* fmt, Args&&... args) {
-    Sink(LogLevel::Error, WStringToString(StringFormat(fmt, std::forward<Args>(args)...)).c_str());
+    LogFormat<LogLevel::Error>(fmt, std::forward<Args>(args)...);
   }
 
+  /// Log message at `level` whose formatting is deferred to the consumer of the log (see BIFROST_LOG_DEFERRED)
+  template <class... Args>
+  void LogDeferred(LogLevel level, DeferredFormatSite& site, Args&&... args) {
+    if (!IsCompiledIn(level) || !IsEnabled(level)) return;
+    DeferredArgs encodedArgs;
+    encodedArgs.Encode(std::forward<Args>(args)...);
+    SinkDeferred(level, site, encodedArgs);
+  }
+
+  /// Log the printf-style message `fmt` at `level` if `limiter` admits it - the number of previously suppressed messages is appended (see
+  /// BIFROST_LOG_RATE_LIMITED)
+  template <class... Args>
+  void LogRateLimited(LogLevel level, LogRateLimiter& limiter, const char* fmt, Args&&... args) {
+    if (!IsCompiledIn(level) || !IsEnabled(level)) return;
+
+    u64 numSuppressed = 0;
+    if (!limiter.TryAcquire(numSuppressed)) return;
+
+    std::string msg = StringFormat(fmt, std::forward<Args>(args)...);
+    if (numSuppressed > 0) msg += StringFormat(" (suppressed %llu messages)", numSuppressed);
+    Sink(level, msg.c_str());
+  }
+
+  /// Check if messages at `level` are compiled in (see BIFROST_LOG_MIN_LEVEL)
+  static constexpr bool IsCompiledIn(LogLevel level) { return static_cast<u32>(level) >= BIFROST_LOG_MIN_LEVEL; }
+
+  /// Check if messages at `level` of the current module are logged - called before formatting a message
+  virtual bool IsEnabled(LogLevel level) { return true; }
+
   /// Set the current module
   virtual void SetModule(const char* module) = 0;
 
@@ -90,6 +142,61 @@ class ILogger {
 
   /// Sink the log message `msg` from the current module (set via `SetModule`)
   virtual void Sink(LogLevel level, const char* msg) = 0;
+
+  /// Sink the message of `site` with the encoded `args` from the current module (formats the message in place by default)
+  virtual void SinkDeferred(LogLevel level, DeferredFormatSite& site, const DeferredArgs& args) {
+    Sink(level, FormatDeferred(site.GetFormat(), args.Data(), args.Size()).c_str());
+  }
+
+  /// Sink the message of `site` with the encoded `args` from `module` (formats the message in place by default)
+  virtual void SinkDeferred(LogLevel level, const char* module, DeferredFormatSite& site, const DeferredArgs& args) {
+    Sink(level, module, FormatDeferred(site.GetFormat(), args.Data(), args.Size()).c_str());
+  }
+
+  /// Sink `count` log messages at once (sinks them one by one by default)
+  virtual void SinkBatch(const LogRecord* records, u64 count) {
+    for (u64 i = 0; i < count; ++i) Sink(records[i].Level, records[i].Module, records[i].Message);
+  }
+
+  /// Hand over messages the logger holds back (called by the consumer of the log stash when it runs out of messages)
+  virtual void Flush() {}
+
+ private:
+  template <LogLevel Level>
+  void Log(const char* msg) {
+    if constexpr (IsCompiledIn(Level)) {
+      if (IsEnabled(Level)) Sink(Level, msg);
+    }
+  }
+  template <LogLevel Level>
+  void Log(const wchar_t* msg) {
+    if constexpr (IsCompiledIn(Level)) {
+      if (IsEnabled(Level)) Sink(Level, WStringToString(msg).c_str());
+    }
+  }
+  template <LogLevel Level, class... Args>
+  void LogFormat(const char* fmt, Args&&... args) {
+    if constexpr (IsCompiledIn(Level)) {
+      if (IsEnabled(Level)) Sink(Level, StringFormat(fmt, std::forward<Args>(args)...).c_str());
+    }
+  }
+  template <LogLevel Level, class... Args>
+  void LogFormat(const wchar_t* fmt, Args&&... args) {
+    if constexpr (IsCompiledIn(Level)) {
+      if (IsEnabled(Level)) Sink(Level, WStringToString(StringFormat(fmt, std::forward<Args>(args)...)).c_str());
+    }
+  }
 };
 
-}  // namespace bifrost
\ No newline at end of file
+}  // namespace bifrost
+
+/// Log the printf-style message `fmt` at `level` to `logger` at most `maxPerSecond` times per second from this call site
+///
+/// Suppressed messages are never formatted, the next admitted message reports how many have been suppressed.
+#define BIFROST_LOG_RATE_LIMITED(logger, level, maxPerSecond, fmt, ...)              \
+  do {                                                                               \
+    if (::bifrost::ILogger::IsCompiledIn(level)) {                                   \
+      static ::bifrost::LogRateLimiter __bifrost_rate_limiter(maxPerSecond);         \
+      (logger).LogRateLimited((level), __bifrost_rate_limiter, fmt, ##__VA_ARGS__);  \
+    }                                                                                \
+  } while (0)
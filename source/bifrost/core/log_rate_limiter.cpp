@@ -0,0 +1,35 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/log_rate_limiter.h"
+#include "bifrost/core/timestamp.h"
+
+namespace bifrost {
+
+bool LogRateLimiter::TryAcquire(u64& numSuppressed) {
+  // Start a new window once a second has passed (concurrent callers may race to reset the count which only admits a few extra messages)
+  u64 now = GetTimestamp();
+  u64 windowStart = m_windowStart.load(std::memory_order_relaxed);
+  if (now - windowStart >= GetTimestampFrequency() && m_windowStart.compare_exchange_strong(windowStart, now)) {
+    m_count.store(0, std::memory_order_relaxed);
+  }
+
+  if (m_count.fetch_add(1, std::memory_order_relaxed) < m_maxPerSecond) {
+    numSuppressed = m_numSuppressed.exchange(0);
+    return true;
+  }
+  m_numSuppressed.fetch_add(1);
+  return false;
+}
+
+}  // namespace bifrost
@@ -0,0 +1,35 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/type.h"
+
+namespace bifrost {
+
+/// Limit the number of messages of a log call site to `maxPerSecond` per second (see BIFROST_LOG_RATE_LIMITED)
+class LogRateLimiter {
+ public:
+  constexpr LogRateLimiter(u32 maxPerSecond) : m_maxPerSecond(maxPerSecond) {}
+
+  /// Check if another message may be logged - if so, `numSuppressed` is set to the number of messages suppressed since the last admitted one
+  bool TryAcquire(u64& numSuppressed);
+
+ private:
+  u32 m_maxPerSecond;
+  std::atomic<u64> m_windowStart{0};
+  std::atomic<u32> m_count{0};
+  std::atomic<u64> m_numSuppressed{0};
+};
+
+}  // namespace bifrost
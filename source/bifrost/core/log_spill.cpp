@@ -0,0 +1,156 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/error.h"
+#include "bifrost/core/log_spill.h"
+#include "bifrost/core/util.h"
+
+namespace bifrost {
+
+namespace {
+
+constexpr char SpillMagic[8] = {'B', 'F', 'S', 'P', 'I', 'L', 'L', 0};
+
+}  // namespace
+
+LogSpillFile::LogSpillFile(const std::string& name, u32 pid, bool create, u64 capacity) : m_path(GetPath(name, pid)), m_create(create) {
+  // The file is not deleted on close - the records have to survive the writer until the consumer replayed them
+  m_file = ::CreateFileW(m_path.c_str(), GENERIC_READ | GENERIC_WRITE | DELETE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                         create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_TEMPORARY, NULL);
+  if (m_file == INVALID_HANDLE_VALUE) {
+    m_file = nullptr;
+    throw std::runtime_error(StringFormat("Failed to open log spill file \"%s\": %s", m_path.string().c_str(), GetLastWin32Error().c_str()));
+  }
+
+  u64 size = 0;
+  if (create) {
+    u64 ringCapacity = 1;
+    while (ringCapacity < capacity) ringCapacity <<= 1;
+    size = HeaderSize + ringCapacity;
+  } else {
+    LARGE_INTEGER fileSize;
+    ::GetFileSizeEx(m_file, &fileSize);
+    size = (u64)fileSize.QuadPart;
+  }
+
+  m_mapping = ::CreateFileMappingW(m_file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+  if (m_mapping != NULL) m_data = (u8*)::MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (m_data == nullptr) {
+    std::string msg = StringFormat("Failed to map log spill file \"%s\": %s", m_path.string().c_str(), GetLastWin32Error().c_str());
+    if (m_mapping != NULL) ::CloseHandle(m_mapping);
+    ::CloseHandle(m_file);
+    m_mapping = m_file = nullptr;
+    throw std::runtime_error(msg);
+  }
+
+  m_header = (Header*)m_data;
+  if (create) {
+    std::memcpy(m_header->Magic, SpillMagic, sizeof(SpillMagic));
+    m_header->Capacity = size - HeaderSize;
+    m_header->WritePos.store(0);
+    m_header->ReadPos.store(0);
+  } else if (size < HeaderSize || std::memcmp(m_header->Magic, SpillMagic, sizeof(SpillMagic)) != 0 || m_header->Capacity != size - HeaderSize) {
+    ::UnmapViewOfFile(m_data);
+    ::CloseHandle(m_mapping);
+    ::CloseHandle(m_file);
+    m_data = nullptr;
+    m_mapping = m_file = nullptr;
+    throw std::runtime_error(StringFormat("Failed to open log spill file \"%s\": not a log spill file", m_path.string().c_str()));
+  }
+}
+
+LogSpillFile::~LogSpillFile() {
+  // The writer deletes the file only if nothing is left to replay
+  if (m_create && m_data && GetReadPos() >= GetWritePos()) m_deleteOnClose = true;
+
+  if (m_data) ::UnmapViewOfFile(m_data);
+  if (m_mapping) ::CloseHandle(m_mapping);
+  if (m_file) {
+    if (m_deleteOnClose) {
+      FILE_DISPOSITION_INFO info = {TRUE};
+      ::SetFileInformationByHandle(m_file, FileDispositionInfo, &info, sizeof(info));
+    }
+    ::CloseHandle(m_file);
+  }
+}
+
+std::filesystem::path LogSpillFile::GetPath(const std::string& name, u32 pid) {
+  return std::filesystem::temp_directory_path() / StringFormat("bifrost.%s.%u.spill", name.c_str(), pid);
+}
+
+LogSpillFile* LogSpillFiles::GetOwn() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_own) {
+    m_own = std::make_unique<LogSpillFile>(m_name, (u32)::GetCurrentProcessId(), true);
+    m_ownFile.store(m_own.get(), std::memory_order_release);
+  }
+  return m_own.get();
+}
+
+LogSpillFiles::~LogSpillFiles() {
+  for (auto& [pid, opened] : m_opened) {
+    if (opened.Process) ::CloseHandle(opened.Process);
+  }
+}
+
+LogSpillFile* LogSpillFiles::Open(u32 pid) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_own && pid == ::GetCurrentProcessId()) return m_own.get();
+
+  auto it = m_opened.find(pid);
+  if (it != m_opened.end()) return it->second.File.get();
+
+  // Open the process first, the file of a process which exited is left for us to replay
+  OpenedFile opened;
+  opened.Process = ::OpenProcess(SYNCHRONIZE, FALSE, pid);
+  if (opened.Process == NULL && ::GetLastError() == ERROR_INVALID_PARAMETER) opened.Exited = true;
+
+  try {
+    opened.File = std::make_unique<LogSpillFile>(m_name, pid, false);
+  } catch (std::runtime_error&) {
+    // The file is gone (e.g the temp directory was cleaned up)
+    if (opened.Process) ::CloseHandle(opened.Process);
+    return nullptr;
+  }
+  return m_opened.emplace(pid, std::move(opened)).first->second.File.get();
+}
+
+u64 LogSpillFiles::NumOpened() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_opened.size();
+}
+
+bool LogSpillFiles::UpdateExited() {
+  bool anyExited = false;
+  for (auto& [pid, opened] : m_opened) {
+    if (opened.Process && !opened.Exited) opened.Exited = ::WaitForSingleObject(opened.Process, 0) == WAIT_OBJECT_0;
+    anyExited |= opened.Exited;
+  }
+  return anyExited;
+}
+
+void LogSpillFiles::CloseExitedImpl(bool stashEmpty) {
+  // Only the files of exited processes are deleted, the writer of a live process still appends to its file
+  for (auto it = m_opened.begin(); it != m_opened.end();) {
+    OpenedFile& opened = it->second;
+    if (opened.Exited && (stashEmpty || opened.File->GetReadPos() >= opened.File->GetWritePos())) {
+      if (opened.Process) ::CloseHandle(opened.Process);
+      opened.File->DeleteOnClose();
+      it = m_opened.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace bifrost
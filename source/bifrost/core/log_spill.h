@@ -0,0 +1,154 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/non_copyable.h"
+#include "bifrost/core/type.h"
+
+namespace bifrost {
+
+/// Memory-mapped file the log records of a process are spilled to if the log stash is full (see SMLogStash::OverflowPolicy::SpillToDisk)
+///
+/// The file is written by the process which logs ("<temp>/bifrost.<name>.<pid>.spill") and read by the consumer of the log stash. The data
+/// is a ring addressed by monotonically increasing positions, the write and read position are stored in the header of the file. The file
+/// outlives the writing process until its records are replayed - the consumer deletes it (see LogSpillFiles::CloseExited), the writer only
+/// if all records have been consumed when it closes the file.
+class LogSpillFile : public NonCopyable {
+ public:
+  /// Default size of the ring in bytes
+  static constexpr u64 DefaultCapacity = 64 << 20;
+
+  /// Create (`create` is true) or open the spill file of process `pid` of the shared memory `name` - throws on failure
+  LogSpillFile(const std::string& name, u32 pid, bool create, u64 capacity = DefaultCapacity);
+  ~LogSpillFile();
+
+  /// Get the path of the spill file of process `pid` of the shared memory `name`
+  static std::filesystem::path GetPath(const std::string& name, u32 pid);
+
+  /// Get the data of the ring
+  u8* GetData() const { return m_data + HeaderSize; }
+
+  /// Get the size of the ring in bytes (a power of two)
+  u64 GetCapacity() const { return m_header->Capacity; }
+
+  /// Position up to which the records are written
+  u64 GetWritePos() const { return m_header->WritePos.load(std::memory_order_acquire); }
+  void SetWritePos(u64 pos) { m_header->WritePos.store(pos, std::memory_order_release); }
+
+  /// Position up to which the records are consumed
+  u64 GetReadPos() const { return m_header->ReadPos.load(std::memory_order_acquire); }
+  void SetReadPos(u64 pos) { m_header->ReadPos.store(pos, std::memory_order_release); }
+
+  /// Mutex of the writing process
+  std::mutex& GetMutex() { return m_mutex; }
+
+  /// Are there records which are not yet announced to the consumer by a marker in the log stash? (only used by the writing process)
+  bool HasPending() const { return m_hasPending.load(std::memory_order_acquire); }
+
+  /// Position of the first record which is not yet announced to the consumer (requires the mutex)
+  u64 GetPendingBegin() const { return m_pendingBegin; }
+
+  /// Number of records which are not yet announced (requires the mutex)
+  u32 GetNumPending() const { return m_numPending; }
+
+  /// Mark `count` records starting at `begin` as not yet announced, `begin` is ignored if there are pending records already (requires the
+  /// mutex)
+  void AddPending(u64 begin, u32 count) {
+    if (!HasPending()) m_pendingBegin = begin;
+    m_numPending += count;
+    m_hasPending.store(true, std::memory_order_release);
+  }
+
+  /// Mark all records as announced (requires the mutex)
+  void ClearPending() {
+    m_numPending = 0;
+    m_hasPending.store(false, std::memory_order_release);
+  }
+
+  /// Delete the file once it is closed by all processes
+  void DeleteOnClose() { m_deleteOnClose = true; }
+
+ private:
+  struct Header {
+    char Magic[8];
+    u64 Capacity;
+    std::atomic<u64> WritePos;
+    std::atomic<u64> ReadPos;
+  };
+  static constexpr u64 HeaderSize = 64;
+
+  std::filesystem::path m_path;
+  void* m_file = nullptr;
+  void* m_mapping = nullptr;
+  u8* m_data = nullptr;
+  Header* m_header = nullptr;
+  std::mutex m_mutex;
+  u64 m_pendingBegin = 0;
+  u32 m_numPending = 0;
+  std::atomic<bool> m_hasPending{false};
+  bool m_create;
+  bool m_deleteOnClose = false;
+};
+
+/// Spill files of a shared memory region used by this process
+class LogSpillFiles {
+ public:
+  LogSpillFiles(std::string name) : m_name(std::move(name)) {}
+  ~LogSpillFiles();
+
+  /// Get the spill file of the calling process (created on first use) - throws on failure
+  LogSpillFile* GetOwn();
+
+  /// Get the spill file of the calling process if it has been created, NULL otherwise
+  LogSpillFile* GetOwnIfCreated() const { return m_ownFile.load(std::memory_order_acquire); }
+
+  /// Get the spill file of process `pid` - returns NULL if the file does not exist (anymore)
+  ///
+  /// The file stays open until `CloseExited` finds the process exited, the handle of the process held meanwhile prevents the pid from being
+  /// reused. The file of a process which already exited is opened as well.
+  LogSpillFile* Open(u32 pid);
+
+  /// Close and delete the opened spill files of processes which exited and whose records are all replayed - `isStashEmpty()` is called once
+  /// the processes are known to have exited, if it returns true, no markers of them are left and their files are closed regardless
+  template <class FunctorT>
+  void CloseExited(FunctorT&& isStashEmpty) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (UpdateExited()) CloseExitedImpl(isStashEmpty());
+  }
+
+  /// Get the number of opened spill files of other processes
+  u64 NumOpened();
+
+ private:
+  /// Spill file of another process
+  struct OpenedFile {
+    std::unique_ptr<LogSpillFile> File;
+    void* Process = nullptr;  ///< NULL if the process exited before the file was opened or could not be opened (then `Exited` is false)
+    bool Exited = false;
+  };
+
+  /// Check which processes of the opened files exited - returns true if any did (requires the mutex)
+  bool UpdateExited();
+
+  /// Close the files of the exited processes which are replayed completely or all if `stashEmpty` is true (requires the mutex)
+  void CloseExitedImpl(bool stashEmpty);
+
+  std::string m_name;
+  std::mutex m_mutex;
+  std::unique_ptr<LogSpillFile> m_own;
+  std::atomic<LogSpillFile*> m_ownFile{nullptr};
+  std::unordered_map<u32, OpenedFile> m_opened;
+};
+
+}  // namespace bifrost
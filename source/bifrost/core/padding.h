@@ -15,6 +15,9 @@
 
 namespace bifrost {
 
+/// Assumed size of a cache line in bytes
+constexpr std::size_t CacheLineSize = 64;
+
 #pragma pack(push)
 #pragma pack(1)
 
@@ -0,0 +1,46 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/semaphore.h"
+#include "bifrost/core/error.h"
+#include "bifrost/core/util.h"
+
+namespace bifrost {
+
+Semaphore::Semaphore(std::string name) : m_name(std::move(name)) {
+  m_handle = ::CreateSemaphoreA(NULL,      // Default security
+                                0,         // Initial count
+                                LONG_MAX,  // Maximum count
+                                GetName());
+  if (m_handle == NULL) {
+    throw std::runtime_error(StringFormat("Failed to create semaphore \"%s\": %s", GetName(), GetLastWin32Error().c_str()));
+  }
+}
+
+Semaphore::~Semaphore() { ::CloseHandle(m_handle); }
+
+void Semaphore::Release(u32 count) {
+  if (count == 0) return;
+  if (::ReleaseSemaphore(m_handle, (LONG)count, NULL) == 0) {
+    throw std::runtime_error(StringFormat("Failed to release semaphore \"%s\": %s", GetName(), GetLastWin32Error().c_str()));
+  }
+}
+
+bool Semaphore::Wait(u32 timeoutInMs) {
+  DWORD reason = ::WaitForSingleObject(m_handle, timeoutInMs == Infinite ? INFINITE : timeoutInMs);
+  if (reason == WAIT_FAILED) {
+    throw std::runtime_error(StringFormat("Failed to wait for semaphore \"%s\": %s", GetName(), GetLastWin32Error().c_str()));
+  }
+  return reason == WAIT_OBJECT_0;
+}
+
+}  // namespace bifrost
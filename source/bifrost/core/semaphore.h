@@ -0,0 +1,44 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/non_copyable.h"
+#include "bifrost/core/type.h"
+
+namespace bifrost {
+
+/// Named counting semaphore which can be released across processes
+class Semaphore : public NonCopyable {
+ public:
+  /// Wait forever
+  static constexpr u32 Infinite = 0xFFFFFFFF;
+
+  /// Create or open the semaphore ``name`` (initially zero)
+  Semaphore(std::string name);
+  ~Semaphore();
+
+  /// Get the name of the semaphore
+  const char* GetName() const noexcept { return m_name.c_str(); }
+
+  /// Increase the count of the semaphore by `count` (wakes up to `count` waiting threads)
+  void Release(u32 count = 1);
+
+  /// Wait until the count is non-zero and decrement it or `timeoutInMs` elapsed - returns true if the count was decremented
+  bool Wait(u32 timeoutInMs = Infinite);
+
+ private:
+  HANDLE m_handle;
+  std::string m_name;
+};
+
+}  // namespace bifrost
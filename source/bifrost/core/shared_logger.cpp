@@ -0,0 +1,342 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/shared_logger.h"
+#include "bifrost/core/shared_memory.h"
+#include "bifrost/core/sm_atom_table.h"
+#include "bifrost/core/sm_log_levels.h"
+#include "bifrost/core/sm_log_stash.h"
+#include "bifrost/core/timestamp.h"
+
+namespace bifrost {
+
+namespace {
+
+std::atomic<u64> g_nextLoggerId{1};
+
+bool HasThreadExited(HANDLE thread) { return thread != NULL && ::WaitForSingleObject(thread, 0) == WAIT_OBJECT_0; }
+
+HANDLE DuplicateCurrentThread() {
+  HANDLE thread = NULL;
+  ::DuplicateHandle(::GetCurrentProcess(), ::GetCurrentThread(), ::GetCurrentProcess(), &thread, SYNCHRONIZE, FALSE, 0);
+  return thread;
+}
+
+}  // namespace
+
+SharedLogger::SharedLogger(Context* ctx, u32 publishIntervalInMs, u32 repeatWindowInMs)
+    : m_ctx(ctx),
+      m_id(g_nextLoggerId.fetch_add(1)),
+      m_publishIntervalInTicks(GetTimestampFrequency() * publishIntervalInMs / 1000),
+      m_repeatWindowInTicks(GetTimestampFrequency() * repeatWindowInMs / 1000) {
+  if (publishIntervalInMs == 0) return;
+
+  // Publish the messages of threads which stopped logging
+  m_flusherThread = std::thread([this, publishIntervalInMs]() {
+    std::vector<StagingBuffer*> buffers;
+    std::unique_lock<std::mutex> lock(m_buffersMutex);
+    while (!m_done) {
+      m_flusherCv.wait_for(lock, std::chrono::milliseconds(publishIntervalInMs));
+
+      // Reclaim the buffers of exited threads once everything is published (only the flusher thread erases buffers, the remaining ones
+      // stay valid after unlocking)
+      buffers.clear();
+      for (auto it = m_buffers.begin(); it != m_buffers.end();) {
+        StagingBuffer* buffer = it->second.get();
+        bool empty;
+        {
+          BIFROST_LOCK_GUARD(buffer->Mutex);
+          empty = buffer->Messages.empty() && buffer->Last.NumRepeats == 0;
+        }
+        if (empty && HasThreadExited(buffer->Thread)) {
+          it = m_buffers.erase(it);
+        } else {
+          buffers.emplace_back(buffer);
+          ++it;
+        }
+      }
+
+      // Publishing blocks if the stash is full (see SMLogStash::OverflowPolicy::Block), don't hold up threads registering their buffer
+      lock.unlock();
+      u64 now = GetTimestamp();
+      for (StagingBuffer* buffer : buffers) {
+        BIFROST_LOCK_GUARD(buffer->Mutex);
+        if (buffer->Last.NumRepeats > 0 && now - buffer->Last.WindowStart >= m_repeatWindowInTicks) StageRepeats(buffer, now);
+        if (!buffer->Messages.empty() && now - buffer->Messages.front().Timestamp >= m_publishIntervalInTicks) Publish(buffer);
+      }
+
+      // Spilled messages are only announced while the process logs, make sure the last ones are not stuck in the spill file
+      m_ctx->Memory().GetSMLogStash()->AnnounceSpilled(m_ctx);
+      lock.lock();
+    }
+  });
+}
+
+SharedLogger::~SharedLogger() {
+  if (m_flusherThread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(m_buffersMutex);
+      m_done = true;
+    }
+    m_flusherCv.notify_one();
+    m_flusherThread.join();
+  }
+  Flush();
+}
+
+bool SharedLogger::IsEnabled(LogLevel level) { return static_cast<u32>(level) >= GetMinLevel(); }
+
+void SharedLogger::SetModule(const char* module) {
+  m_moduleAtom = m_ctx->Memory().GetSMAtomTable()->Intern(m_ctx, module ? module : "");
+  m_levelVersion = InvalidVersion;
+}
+
+void SharedLogger::Sink(LogLevel level, const char* module, const char* msg) {
+  u32 moduleAtom = 0;
+  if (static_cast<u32>(level) < GetModuleLevel(module, moduleAtom)) return;
+  Stage(level, moduleAtom, msg);
+}
+
+void SharedLogger::Sink(LogLevel level, const char* msg) {
+  if (!IsEnabled(level)) return;
+  Stage(level, m_moduleAtom, msg);
+}
+
+void SharedLogger::SinkDeferred(LogLevel level, DeferredFormatSite& site, const DeferredArgs& args) {
+  // Deferred messages are a single small record, they go to the stash directly
+  if (!IsEnabled(level)) return;
+  StageDeferred(level, m_moduleAtom, site, args);
+}
+
+void SharedLogger::SinkDeferred(LogLevel level, const char* module, DeferredFormatSite& site, const DeferredArgs& args) {
+  u32 moduleAtom = 0;
+  if (static_cast<u32>(level) < GetModuleLevel(module, moduleAtom)) return;
+  StageDeferred(level, moduleAtom, site, args);
+}
+
+void SharedLogger::SinkBatch(const LogRecord* records, u64 count) {
+  SMAtomTable* atoms = m_ctx->Memory().GetSMAtomTable();
+  SMLogLevels* levels = m_ctx->Memory().GetSMLogLevels();
+
+  // Drop the records below the level of their module
+  std::vector<LogRecord> enabledRecords;
+  enabledRecords.reserve(count);
+
+  const char* lastModule = nullptr;
+  u32 lastMinLevel = 0;
+  for (u64 i = 0; i < count; ++i) {
+    const char* module = records[i].Module ? records[i].Module : "";
+    if (lastModule == nullptr || std::strcmp(module, lastModule) != 0) {
+      lastModule = module;
+      lastMinLevel = levels->GetLevel(m_ctx, atoms->Intern(m_ctx, module));
+    }
+    if (static_cast<u32>(records[i].Level) >= lastMinLevel) enabledRecords.emplace_back(records[i]);
+  }
+
+  m_ctx->Memory().GetSMLogStash()->PushBatch(m_ctx, enabledRecords.data(), enabledRecords.size());
+}
+
+void SharedLogger::Flush() {
+  std::lock_guard<std::mutex> lock(m_buffersMutex);
+  for (auto& [threadId, buffer] : m_buffers) {
+    BIFROST_LOCK_GUARD(buffer->Mutex);
+    StageRepeats(buffer.get(), GetTimestamp());
+    Publish(buffer.get());
+  }
+  m_ctx->Memory().GetSMLogStash()->AnnounceSpilled(m_ctx);
+}
+
+u32 SharedLogger::GetMinLevel() {
+  SMLogLevels* levels = m_ctx->Memory().GetSMLogLevels();
+
+  u32 version = levels->GetVersion();
+  if (version != m_levelVersion.load(std::memory_order_relaxed)) {
+    m_minLevel.store(levels->GetLevel(m_ctx, m_moduleAtom), std::memory_order_relaxed);
+    m_levelVersion.store(version, std::memory_order_relaxed);
+  }
+  return m_minLevel.load(std::memory_order_relaxed);
+}
+
+u32 SharedLogger::GetModuleLevel(const char* module, u32& moduleAtom) {
+  if (module == nullptr) module = "";
+
+  // Plugins log from the same module over and over, avoid the cross-process locks of the atom table and the log levels
+  struct ModuleCache {
+    u64 LoggerId = 0;
+    std::string Module;
+    u32 Atom = 0;
+    u32 MinLevel = 0;
+    u32 Version = InvalidVersion;
+  };
+  thread_local ModuleCache t_cache;
+
+  if (t_cache.LoggerId != m_id || t_cache.Module != module) {
+    t_cache.LoggerId = m_id;
+    t_cache.Module = module;
+    t_cache.Atom = m_ctx->Memory().GetSMAtomTable()->Intern(m_ctx, module);
+    t_cache.Version = InvalidVersion;
+  }
+
+  SMLogLevels* levels = m_ctx->Memory().GetSMLogLevels();
+  u32 version = levels->GetVersion();
+  if (version != t_cache.Version) {
+    t_cache.MinLevel = levels->GetLevel(m_ctx, t_cache.Atom);
+    t_cache.Version = version;
+  }
+
+  moduleAtom = t_cache.Atom;
+  return t_cache.MinLevel;
+}
+
+void SharedLogger::StageDeferred(LogLevel level, u32 moduleAtom, DeferredFormatSite& site, const DeferredArgs& args) {
+  u32 format = site.GetAtom(m_ctx);
+  if (m_repeatWindowInTicks != 0) {
+    u64 timestamp = GetTimestamp();
+    StagingBuffer* buffer = GetStagingBuffer();
+
+    BIFROST_LOCK_GUARD(buffer->Mutex);
+    RepeatState& last = buffer->Last;
+    if (last.Deferred && last.Level == level && last.ModuleAtom == moduleAtom && last.Key == format) {
+      last.NumRepeats += 1;
+      last.LastTimestamp = timestamp;
+      last.Args.Assign(args.Data(), args.Size());
+      if (timestamp - last.WindowStart >= m_repeatWindowInTicks) StageRepeats(buffer, timestamp);
+      return;
+    }
+
+    StageRepeats(buffer, timestamp);
+    last.Level = level;
+    last.ModuleAtom = moduleAtom;
+    last.ThreadId = ::GetCurrentThreadId();
+    last.Key = format;
+    last.Deferred = true;
+    last.WindowStart = timestamp;
+    last.Args.Assign(args.Data(), args.Size());
+  }
+
+  // Deferred messages are a single small record, they go to the stash directly
+  m_ctx->Memory().GetSMLogStash()->PushDeferred(m_ctx, static_cast<u32>(level), moduleAtom, format, args.Data(), args.Size());
+}
+
+void SharedLogger::Stage(LogLevel level, u32 moduleAtom, const char* msg) {
+  if (msg == nullptr) msg = "";
+  if (m_publishIntervalInTicks == 0 && m_repeatWindowInTicks == 0) {
+    m_ctx->Memory().GetSMLogStash()->Push(m_ctx, static_cast<u32>(level), moduleAtom, msg);
+    return;
+  }
+
+  u64 timestamp = GetTimestamp();
+  u32 threadId = ::GetCurrentThreadId();
+  StagingBuffer* buffer = GetStagingBuffer();
+
+  BIFROST_LOCK_GUARD(buffer->Mutex);
+  if (m_repeatWindowInTicks != 0) {
+    RepeatState& last = buffer->Last;
+    u64 key = std::hash<std::string_view>()(msg);
+    if (!last.Deferred && last.Level == level && last.ModuleAtom == moduleAtom && last.Key == key && last.Message == msg) {
+      last.NumRepeats += 1;
+      last.LastTimestamp = timestamp;
+      if (timestamp - last.WindowStart >= m_repeatWindowInTicks) StageRepeats(buffer, timestamp);
+      return;
+    }
+
+    StageRepeats(buffer, timestamp);
+    last.Level = level;
+    last.ModuleAtom = moduleAtom;
+    last.ThreadId = threadId;
+    last.Key = key;
+    last.Deferred = false;
+    last.WindowStart = timestamp;
+    last.Message.assign(msg);
+  }
+  StageImpl(buffer, level, moduleAtom, threadId, timestamp, msg);
+}
+
+void SharedLogger::StageRepeats(StagingBuffer* buffer, u64 timestamp) {
+  RepeatState& last = buffer->Last;
+  if (last.NumRepeats > 0) {
+    u64 numRepeats = last.NumRepeats;
+    last.NumRepeats = 0;
+    std::string msg = last.Deferred ? FormatDeferred(m_ctx->Memory().GetSMAtomTable()->GetString(m_ctx, (u32)last.Key), last.Args.Data(),
+                                                     last.Args.Size())
+                                    : last.Message;
+    StageImpl(buffer, last.Level, last.ModuleAtom, last.ThreadId, last.LastTimestamp,
+              StringFormat("%s (repeated %llu times)", msg.c_str(), numRepeats).c_str());
+  }
+  last.WindowStart = timestamp;
+}
+
+void SharedLogger::StageImpl(StagingBuffer* buffer, LogLevel level, u32 moduleAtom, u32 threadId, u64 timestamp, const char* msg) {
+  if (m_publishIntervalInTicks == 0) {
+    m_ctx->Memory().GetSMLogStash()->Push(m_ctx, static_cast<u32>(level), moduleAtom, msg);
+    return;
+  }
+
+  buffer->Messages.emplace_back(StagedMessage{level, moduleAtom, threadId, timestamp, buffer->Text.size()});
+  buffer->Text.append(msg);
+  buffer->Text.push_back('\0');
+
+  // Warnings and errors are published immediately as the process might be about to go down
+  if (buffer->Messages.size() >= StagingCapacity || level >= LogLevel::Warn ||
+      timestamp - buffer->Messages.front().Timestamp >= m_publishIntervalInTicks) {
+    Publish(buffer);
+  }
+}
+
+u64 SharedLogger::NumStagingBuffers() {
+  std::lock_guard<std::mutex> lock(m_buffersMutex);
+  return m_buffers.size();
+}
+
+SharedLogger::StagingBuffer* SharedLogger::GetStagingBuffer() {
+  // Cache the buffer of the last used logger of the thread
+  thread_local u64 t_loggerId = 0;
+  thread_local StagingBuffer* t_buffer = nullptr;
+  if (t_loggerId == m_id) return t_buffer;
+
+  std::lock_guard<std::mutex> lock(m_buffersMutex);
+  auto& buffer = m_buffers[std::this_thread::get_id()];
+  if (!buffer) {
+    buffer = std::make_unique<StagingBuffer>();
+    buffer->Thread = DuplicateCurrentThread();
+    buffer->Messages.reserve(StagingCapacity);
+  } else if (HasThreadExited(buffer->Thread)) {
+    // The thread reuses the id of an exited thread whose buffer is not reclaimed yet
+    ::CloseHandle(buffer->Thread);
+    buffer->Thread = DuplicateCurrentThread();
+  }
+
+  t_loggerId = m_id;
+  t_buffer = buffer.get();
+  return t_buffer;
+}
+
+void SharedLogger::Publish(StagingBuffer* buffer) {
+  if (buffer->Messages.empty()) return;
+
+  std::array<LogRecord, StagingCapacity> records;
+  std::array<u32, StagingCapacity> moduleAtoms;
+  for (u64 first = 0; first < buffer->Messages.size(); first += StagingCapacity) {
+    u64 n = std::min<u64>(StagingCapacity, buffer->Messages.size() - first);
+    for (u64 i = 0; i < n; ++i) {
+      const StagedMessage& msg = buffer->Messages[first + i];
+      records[i] = LogRecord{msg.Level, nullptr, buffer->Text.c_str() + msg.MessageOffset, msg.Timestamp, msg.ThreadId};
+      moduleAtoms[i] = msg.ModuleAtom;
+    }
+    m_ctx->Memory().GetSMLogStash()->PushBatch(m_ctx, records.data(), moduleAtoms.data(), n);
+  }
+
+  buffer->Messages.clear();
+  buffer->Text.clear();
+}
+
+}  // namespace bifrost
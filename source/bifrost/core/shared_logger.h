@@ -0,0 +1,143 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/context.h"
+#include "bifrost/core/ilogger.h"
+#include "bifrost/core/mutex.h"
+
+namespace bifrost {
+
+/// Logger which pushes the messages to the log stash of the shared memory
+///
+/// Messages below the minimum level of their module (see SMLogLevels) are dropped before they are formatted. Messages are staged in a
+/// buffer per thread and published to the stash in batches - when the buffer is full, when the oldest message is older than the publish
+/// interval, on warnings and errors or on `Flush`. Messages of different threads can hence arrive out of order, the consumer restores the
+/// order using the timestamps of the messages if it has a reorder window (see LogStashConsumer) and bifrost-logdump sorts binary logs when
+/// decoding. The buffers of exited threads are reclaimed by the flusher thread.
+///
+/// Repeated messages of a thread within the repeat window are collapsed into a single "<message> (repeated N times)" record which is
+/// published at the end of the window or once a different message is logged. Deferred messages repeat if they have the same level, module
+/// and call site (the arguments may vary, the record is formatted with the arguments of the last repeat). Messages which are formatted by
+/// the caller only repeat if they have the same level, module and text as the format is not known anymore.
+class SharedLogger : public ILogger {
+ public:
+  /// Number of messages staged per thread before they are published
+  static constexpr u32 StagingCapacity = 64;
+
+  /// Default longest time a message is staged
+  static constexpr u32 DefaultPublishIntervalInMs = 20;
+
+  /// Default window in which repeated messages are collapsed
+  static constexpr u32 DefaultRepeatWindowInMs = 1000;
+
+  /// Log to the shared memory of `ctx` - if `publishIntervalInMs` is 0, messages are published immediately, if `repeatWindowInMs` is 0,
+  /// repeated messages are not collapsed
+  SharedLogger(Context* ctx, u32 publishIntervalInMs = DefaultPublishIntervalInMs, u32 repeatWindowInMs = DefaultRepeatWindowInMs);
+  ~SharedLogger();
+
+  virtual bool IsEnabled(LogLevel level) override;
+  virtual void SetModule(const char* module) override;
+  virtual void Sink(LogLevel level, const char* module, const char* msg) override;
+  virtual void Sink(LogLevel level, const char* msg) override;
+  virtual void SinkDeferred(LogLevel level, DeferredFormatSite& site, const DeferredArgs& args) override;
+  virtual void SinkDeferred(LogLevel level, const char* module, DeferredFormatSite& site, const DeferredArgs& args) override;
+  virtual void SinkBatch(const LogRecord* records, u64 count) override;
+
+  /// Publish the staged messages of all threads
+  virtual void Flush() override;
+
+  /// Number of staging buffers (one per thread which logged and whose buffer has not been reclaimed)
+  u64 NumStagingBuffers();
+
+ private:
+  /// Message staged in a StagingBuffer (the message is stored as offset into the text of the buffer)
+  struct StagedMessage {
+    LogLevel Level;
+    u32 ModuleAtom;
+    u32 ThreadId;
+    u64 Timestamp;
+    u64 MessageOffset;
+  };
+
+  /// Last message of a thread and the number of times it has been repeated since the start of the window
+  struct RepeatState {
+    LogLevel Level = LogLevel::Disable;
+    u32 ModuleAtom = 0;
+    u32 ThreadId = 0;
+    u64 Key = 0;  ///< Atom of the format string of deferred messages, hash of the text otherwise
+    bool Deferred = false;
+    u64 WindowStart = 0;
+    u64 LastTimestamp = 0;
+    u64 NumRepeats = 0;
+    std::string Message;  ///< Text of messages which are not deferred (the capacity is reused across messages)
+    DeferredArgs Args;    ///< Arguments of the last repeat of deferred messages
+  };
+
+  /// Messages of one thread which are not yet published
+  struct StagingBuffer {
+    ~StagingBuffer() {
+      if (Thread) ::CloseHandle(Thread);
+    }
+
+    SpinMutex Mutex;
+    HANDLE Thread = NULL;  ///< Handle of the thread (the buffer is only reclaimed once the thread exited, NULL if it could not be duplicated)
+    std::vector<StagedMessage> Messages;
+    std::string Text;
+    RepeatState Last;
+  };
+
+  /// Get the minimum level of the current module (only looked up again if the levels changed)
+  u32 GetMinLevel();
+
+  /// Get the atom and minimum level of `module` (cached per thread for the last module, the level is only looked up again if the levels
+  /// changed)
+  u32 GetModuleLevel(const char* module, u32& moduleAtom);
+
+  /// Collapse the deferred message if it repeats the last message of the call site, push it to the stash otherwise
+  void StageDeferred(LogLevel level, u32 moduleAtom, DeferredFormatSite& site, const DeferredArgs& args);
+
+  /// Collapse the message if it repeats the last message, stage it otherwise
+  void Stage(LogLevel level, u32 moduleAtom, const char* msg);
+
+  /// Stage the message or publish it immediately if staging is disabled (requires the lock of `buffer`)
+  void StageImpl(StagingBuffer* buffer, LogLevel level, u32 moduleAtom, u32 threadId, u64 timestamp, const char* msg);
+
+  /// Stage the "repeated N times" record of the last message, if it has been repeated, and start a new window (requires the lock of `buffer`)
+  void StageRepeats(StagingBuffer* buffer, u64 timestamp);
+
+  /// Get the staging buffer of the calling thread
+  StagingBuffer* GetStagingBuffer();
+
+  /// Publish the messages of `buffer` (requires the lock of `buffer`)
+  void Publish(StagingBuffer* buffer);
+
+  static constexpr u32 InvalidVersion = 0xFFFFFFFF;
+
+  Context* m_ctx;
+  std::atomic<u32> m_moduleAtom{0};
+  std::atomic<u32> m_minLevel{0};
+  std::atomic<u32> m_levelVersion{InvalidVersion};
+
+  u64 m_id;
+  u64 m_publishIntervalInTicks;
+  u64 m_repeatWindowInTicks;
+  std::mutex m_buffersMutex;
+  std::unordered_map<std::thread::id, std::unique_ptr<StagingBuffer>> m_buffers;
+
+  bool m_done = false;
+  std::condition_variable m_flusherCv;
+  std::thread m_flusherThread;
+};
+
+}  // namespace bifrost
@@ -11,6 +11,8 @@
 
 #include "bifrost/core/common.h"
 #include "bifrost/core/error.h"
+#include "bifrost/core/event.h"
+#include "bifrost/core/log_spill.h"
 #include "bifrost/core/shared_memory.h"
 #include "bifrost/core/module_loader.h"
 #include "bifrost/core/ilogger.h"
@@ -21,6 +23,9 @@ namespace bifrost {
 SharedMemory::SharedMemory(Context* ctx, std::string name, u64 dataSizeInBytes) : m_name(std::move(name)), m_dataSizeInBytes(dataSizeInBytes), m_ctx(ctx) {
   m_ctx->Logger().TraceFormat("Trying to allocate shared memory \"%s\" (%lu bytes) ...", GetName(), m_dataSizeInBytes);
 
+  m_logStashEvent = std::make_unique<Event>(m_name + ".logstash");
+  m_logSpillFiles = std::make_unique<LogSpillFiles>(m_name);
+
   // Create file mapping if possible
   m_handle = ::CreateFileMappingA(INVALID_HANDLE_VALUE,  // Use paging file
                                   NULL,                  // Default security
@@ -100,8 +105,22 @@ SharedMemory::~SharedMemory() {
   m_ctx->Logger().TraceFormat("Deallocated shared memory \"%s\"", GetName());
 }
 
+SMAtomTable* SharedMemory::GetSMAtomTable() noexcept { return m_sharedCtx->GetSMAtomTable(this); }
+
+SMChannelRegistry* SharedMemory::GetSMChannelRegistry() noexcept { return m_sharedCtx->GetSMChannelRegistry(this); }
+
 SMLogStash* SharedMemory::GetSMLogStash() noexcept { return m_sharedCtx->GetSMLogStash(this); }
 
+SMLogLevels* SharedMemory::GetSMLogLevels() noexcept { return m_sharedCtx->GetSMLogLevels(this); }
+
 SMStorage* SharedMemory::GetSMStorage() noexcept { return m_sharedCtx->GetSMStorage(this); }
 
+Event& SharedMemory::GetStorageWatcherEvent(u32 slot) {
+  std::lock_guard<std::mutex> lock(m_storageWatcherEventsMutex);
+  if (slot >= m_storageWatcherEvents.size()) m_storageWatcherEvents.resize(slot + 1);
+  auto& event = m_storageWatcherEvents[slot];
+  if (!event) event = std::make_unique<Event>(StringFormat("%s.storage.%u", GetName(), slot));
+  return *event;
+}
+
 }  // namespace bifrost
\ No newline at end of file
@@ -17,7 +17,12 @@
 
 namespace bifrost {
 
+class Event;
+class LogSpillFiles;
 class SMContext;
+class SMAtomTable;
+class SMChannelRegistry;
+class SMLogLevels;
 class SMLogStash;
 class SMStorage;
 
@@ -58,15 +63,37 @@ class SharedMemory {
   /// Get the shared context
   SMContext* GetSMContext() noexcept { return m_sharedCtx; }
 
+  /// Get the atom table of SMContext
+  SMAtomTable* GetSMAtomTable() noexcept;
+
+  /// Get the channel registry of SMContext
+  SMChannelRegistry* GetSMChannelRegistry() noexcept;
+
   /// Get the log stash of SMContext
   SMLogStash* GetSMLogStash() noexcept;
 
+  /// Get the log levels of SMContext
+  SMLogLevels* GetSMLogLevels() noexcept;
+
   /// Get the storage of SMContext
   SMStorage* GetSMStorage() noexcept;
 
+  /// Get the event signaled when messages are pushed to an empty log stash (named "<name>.logstash")
+  Event& GetLogStashEvent() noexcept { return *m_logStashEvent; }
+
+  /// Get the log spill files of this process (see SMLogStash::OverflowPolicy::SpillToDisk)
+  LogSpillFiles& GetLogSpillFiles() noexcept { return *m_logSpillFiles; }
+
+  /// Get the event of the watcher slot `slot` of the storage (named "<name>.storage.<slot>", see SMStorage::Watch)
+  Event& GetStorageWatcherEvent(u32 slot);
+
  private:
   MallocFreeList* m_malloc;
   SMContext* m_sharedCtx;
+  std::unique_ptr<Event> m_logStashEvent;
+  std::unique_ptr<LogSpillFiles> m_logSpillFiles;
+  std::mutex m_storageWatcherEventsMutex;
+  std::vector<std::unique_ptr<Event>> m_storageWatcherEvents;
 
   LPVOID m_startAddress;
   HANDLE m_handle;
@@ -0,0 +1,94 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/sm_atom_table.h"
+
+namespace bifrost {
+
+void SMAtomTable::Destruct(SharedMemory* mem) {
+  m_map.Destruct(mem);
+  for (u32 chunk = 0; chunk < MaxChunks; ++chunk) {
+    if (m_chunks[chunk].IsNull()) break;
+    DeleteArray(mem, m_chunks[chunk], FirstChunkSize << chunk);
+  }
+}
+
+u32 SMAtomTable::Intern(Context* ctx, std::string_view str) {
+  if (str.empty()) return EmptyAtom;
+
+  SMString key(ctx, str);
+  BIFROST_LOCK_GUARD(m_mutex);
+
+  if (const u32* atom = m_map.Get(ctx, key)) {
+    key.Destruct(&ctx->Memory());
+    return *atom;
+  }
+
+  // Allocate a new atom (the string is stored in a chunk which never moves)
+  u32 numAtoms = m_numAtoms.load(std::memory_order_relaxed);
+  u32 chunk, index;
+  Locate(numAtoms + 1, chunk, index);
+  if (chunk >= MaxChunks) {
+    key.Destruct(&ctx->Memory());
+    throw std::runtime_error("Atom table is full");
+  }
+  if (m_chunks[chunk].IsNull()) m_chunks[chunk] = NewArray<SMString>(ctx, FirstChunkSize << chunk);
+
+  SMString* strings = Resolve(ctx, m_chunks[chunk]);
+  strings[index].Assign(ctx, str);
+  m_map.Insert(ctx, key, numAtoms + 1);
+  key.Destruct(&ctx->Memory());
+
+  // Publish the atom - readers of `m_numAtoms` are guaranteed to see the string
+  m_numAtoms.store(numAtoms + 1, std::memory_order_release);
+  return numAtoms + 1;
+}
+
+bool SMAtomTable::TryGet(Context* ctx, std::string_view str, u32& atom) {
+  if (str.empty()) {
+    atom = EmptyAtom;
+    return true;
+  }
+
+  SMString key(ctx, str);
+  bool found = false;
+  {
+    BIFROST_LOCK_GUARD(m_mutex);
+    if (const u32* value = m_map.Get(ctx, key)) {
+      atom = *value;
+      found = true;
+    }
+  }
+  key.Destruct(&ctx->Memory());
+  return found;
+}
+
+std::string_view SMAtomTable::GetString(Context* ctx, u32 atom) const {
+  if (atom == EmptyAtom) return {};
+  BIFROST_ASSERT(atom <= m_numAtoms.load(std::memory_order_acquire) && "Invalid atom");
+
+  u32 chunk, index;
+  Locate(atom, chunk, index);
+  return Resolve(ctx, m_chunks[chunk])[index].AsView(ctx);
+}
+
+void SMAtomTable::Locate(u32 atom, u32& chunk, u32& index) {
+  // Chunk `k` holds `FirstChunkSize << k` strings
+  index = atom - 1;
+  chunk = 0;
+  while (index >= (FirstChunkSize << chunk)) {
+    index -= FirstChunkSize << chunk;
+    if (++chunk == MaxChunks) break;
+  }
+}
+
+}  // namespace bifrost
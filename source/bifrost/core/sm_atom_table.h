@@ -0,0 +1,57 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/mutex.h"
+#include "bifrost/core/sm_object.h"
+#include "bifrost/core/sm_hash_map.h"
+#include "bifrost/core/sm_string.h"
+
+namespace bifrost {
+
+/// String interning table mapping strings to stable 32-bit atoms - unique per shared memory region (allocated in SMContext)
+///
+/// Atoms are never released and the interned strings never move, hence resolving an atom does not require a lock.
+class SMAtomTable : public SMObject {
+ public:
+  /// Atom of the empty string
+  static constexpr u32 EmptyAtom = 0;
+
+  void Destruct(SharedMemory* mem);
+
+  /// Get the atom of `str` - interns `str` if it has not been seen before
+  u32 Intern(Context* ctx, std::string_view str);
+
+  /// Get the atom of `str` without interning it - returns true on success
+  bool TryGet(Context* ctx, std::string_view str, u32& atom);
+
+  /// Get the string of `atom` (the view is valid as long as the shared memory is mapped)
+  std::string_view GetString(Context* ctx, u32 atom) const;
+
+  /// Number of interned strings (excluding the empty string)
+  u32 Size() const { return m_numAtoms.load(std::memory_order_acquire); }
+
+ private:
+  static constexpr u32 FirstChunkSize = 16;
+  static constexpr u32 MaxChunks = 24;
+
+  /// Get the chunk and the index within the chunk of `atom`
+  static void Locate(u32 atom, u32& chunk, u32& index);
+
+  SpinMutex m_mutex;
+  std::atomic<u32> m_numAtoms{0};
+  SMHashMap<SMString, u32> m_map;
+  Ptr<SMString> m_chunks[MaxChunks];
+};
+
+}  // namespace bifrost
@@ -0,0 +1,152 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/exception.h"
+#include "bifrost/core/sm_channel.h"
+
+namespace bifrost {
+
+namespace {
+
+/// Spin first, then yield the time slice and finally sleep while waiting on the other side of the channel
+class Backoff {
+ public:
+  Backoff(u32 timeoutInMs) : m_timeoutInMs(timeoutInMs), m_start(::GetTickCount64()) {}
+
+  /// Wait a little - returns false if the timeout elapsed
+  bool Wait() {
+    if (m_timeoutInMs == 0) return false;
+    if (m_timeoutInMs != SMByteChannel::Infinite && ::GetTickCount64() - m_start >= m_timeoutInMs) return false;
+
+    if (m_iteration < 64) {
+      ::YieldProcessor();
+    } else if (m_iteration < 128) {
+      ::SwitchToThread();
+    } else {
+      ::Sleep(1);
+    }
+    ++m_iteration;
+    return true;
+  }
+
+  void Reset() { m_iteration = 0; }
+
+ private:
+  u32 m_timeoutInMs;
+  u64 m_start;
+  u32 m_iteration = 0;
+};
+
+u64 NextPowerOfTwo(u64 value) {
+  u64 result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+}  // namespace
+
+SMByteChannel::SMByteChannel(Context* ctx, u32 elementSize, u64 capacity) {
+  BIFROST_ASSERT(elementSize > 0 && "Invalid element size");
+  m_elementSize = elementSize;
+  m_capacity = NextPowerOfTwo(std::max<u64>(capacity, 2));
+  m_data = NewArray<u8>(ctx, m_capacity * m_elementSize);
+}
+
+void SMByteChannel::Destruct(SharedMemory* mem) { DeleteArray(mem, m_data, m_capacity * m_elementSize); }
+
+u64 SMByteChannel::TryPush(Context* ctx, const void* elements, u64 count) {
+  const u64 writePos = m_writePos.load(std::memory_order_relaxed);
+
+  // Only reload the read position (which is on the consumer's cache line) if the cached one says we are full
+  if (m_capacity - (writePos - m_cachedReadPos) < count) m_cachedReadPos = m_readPos.load(std::memory_order_acquire);
+  count = std::min(count, m_capacity - (writePos - m_cachedReadPos));
+  if (count == 0) return 0;
+
+  // Copy in at most two chunks (wrap-around)
+  u8* data = Resolve(ctx, m_data);
+  const u64 index = writePos & (m_capacity - 1);
+  const u64 first = std::min(count, m_capacity - index);
+  std::memcpy(data + index * m_elementSize, elements, first * m_elementSize);
+  std::memcpy(data, (const u8*)elements + first * m_elementSize, (count - first) * m_elementSize);
+
+  m_writePos.store(writePos + count, std::memory_order_release);
+  return count;
+}
+
+u64 SMByteChannel::TryPop(Context* ctx, void* elements, u64 count) {
+  const u64 readPos = m_readPos.load(std::memory_order_relaxed);
+
+  // Only reload the write position (which is on the producer's cache line) if the cached one says we are empty
+  if (m_cachedWritePos - readPos < count) m_cachedWritePos = m_writePos.load(std::memory_order_acquire);
+  count = std::min(count, m_cachedWritePos - readPos);
+  if (count == 0) return 0;
+
+  // Copy out in at most two chunks (wrap-around)
+  const u8* data = Resolve(ctx, m_data);
+  const u64 index = readPos & (m_capacity - 1);
+  const u64 first = std::min(count, m_capacity - index);
+  std::memcpy(elements, data + index * m_elementSize, first * m_elementSize);
+  std::memcpy((u8*)elements + first * m_elementSize, data, (count - first) * m_elementSize);
+
+  m_readPos.store(readPos + count, std::memory_order_release);
+  return count;
+}
+
+u64 SMByteChannel::Push(Context* ctx, const void* elements, u64 count, u32 timeoutInMs) {
+  Backoff backoff(timeoutInMs);
+  u64 numPushed = 0;
+  while (numPushed < count) {
+    u64 n = TryPush(ctx, (const u8*)elements + numPushed * m_elementSize, count - numPushed);
+    if (n > 0) {
+      numPushed += n;
+      backoff.Reset();
+    } else if (!backoff.Wait()) {
+      break;
+    }
+  }
+  return numPushed;
+}
+
+u64 SMByteChannel::Pop(Context* ctx, void* elements, u64 count, u32 timeoutInMs) {
+  Backoff backoff(timeoutInMs);
+  u64 numPopped = 0;
+  while ((numPopped = TryPop(ctx, elements, count)) == 0 && count > 0) {
+    if (!backoff.Wait()) break;
+  }
+  return numPopped;
+}
+
+void SMChannelRegistry::Destruct(SharedMemory* mem) { m_channels.Destruct(mem); }
+
+SMByteChannel* SMChannelRegistry::Open(Context* ctx, std::string_view name, u32 elementSize, u64 capacity) {
+  BIFROST_LOCK_GUARD(m_mutex);
+
+  for (u64 i = 0; i < m_channels.Size(); ++i) {
+    const Entry& entry = m_channels.At(ctx, i);
+    if (entry.Name.AsView(ctx) != name) continue;
+
+    SMByteChannel* channel = Resolve(ctx, entry.Channel);
+    if (channel->GetElementSize() != elementSize) {
+      throw Exception("Failed to open channel \"%s\": element size %u does not match existing element size %u", std::string(name).c_str(), elementSize,
+                      channel->GetElementSize());
+    }
+    return channel;
+  }
+
+  if (elementSize == 0) throw Exception("Failed to create channel \"%s\": element size is 0", std::string(name).c_str());
+
+  Ptr<SMByteChannel> channel = New<SMByteChannel>(ctx, ctx, elementSize, capacity);
+  m_channels.EmplaceBack(ctx, ctx, name, channel);
+  return Resolve(ctx, channel);
+}
+
+}  // namespace bifrost
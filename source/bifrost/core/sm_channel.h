@@ -0,0 +1,152 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/mutex.h"
+#include "bifrost/core/padding.h"
+#include "bifrost/core/sm_object.h"
+#include "bifrost/core/sm_string.h"
+#include "bifrost/core/sm_vector.h"
+
+namespace bifrost {
+
+/// Single-producer/single-consumer ring buffer of fixed-size elements in shared memory
+///
+/// Exactly one thread (of any process) may push and exactly one thread may pop at the same time.
+class SMByteChannel : public SMObject {
+ public:
+  /// Wait forever in `Push` and `Pop`
+  static constexpr u32 Infinite = 0xFFFFFFFF;
+
+  /// Create a channel of `capacity` elements (rounded up to the next power of 2) of `elementSize` bytes each
+  SMByteChannel(Context* ctx, u32 elementSize, u64 capacity);
+
+  void Destruct(SharedMemory* mem);
+
+  /// Size of an element in bytes
+  u32 GetElementSize() const { return m_elementSize; }
+
+  /// Maximum number of elements in the channel
+  u64 Capacity() const { return m_capacity; }
+
+  /// Number of elements currently in the channel (only a snapshot if the channel is in use)
+  u64 Size() const { return m_writePos.load(std::memory_order_acquire) - m_readPos.load(std::memory_order_acquire); }
+
+  /// Push up to `count` elements without blocking - returns the number of pushed elements (producer only)
+  u64 TryPush(Context* ctx, const void* elements, u64 count);
+
+  /// Pop up to `count` elements without blocking - returns the number of popped elements (consumer only)
+  u64 TryPop(Context* ctx, void* elements, u64 count);
+
+  /// Push all `count` elements waiting at most `timeoutInMs` for free space - returns the number of pushed elements (producer only)
+  u64 Push(Context* ctx, const void* elements, u64 count, u32 timeoutInMs = Infinite);
+
+  /// Pop up to `count` elements waiting at most `timeoutInMs` for the first element - returns the number of popped elements (consumer only)
+  u64 Pop(Context* ctx, void* elements, u64 count, u32 timeoutInMs = Infinite);
+
+ private:
+  static_assert(std::atomic<u64>::is_always_lock_free, "positions need to be lock-free to be shared across processes");
+
+  Ptr<u8> m_data;
+  u64 m_capacity;
+  u32 m_elementSize;
+  Padding<CacheLineSize - sizeof(Ptr<u8>) - sizeof(u64) - sizeof(u32)> m_pad0;
+
+  // Producer
+  std::atomic<u64> m_writePos{0};
+  u64 m_cachedReadPos = 0;
+  Padding<CacheLineSize - 2 * sizeof(u64)> m_pad1;
+
+  // Consumer
+  std::atomic<u64> m_readPos{0};
+  u64 m_cachedWritePos = 0;
+  Padding<CacheLineSize - 2 * sizeof(u64)> m_pad2;
+};
+
+/// Typed view of an SMByteChannel with trivially copyable elements of type `T` (the view itself lives in process memory)
+template <class T>
+class SMChannel {
+ public:
+  static_assert(std::is_trivially_copyable<T>::value, "channel elements are copied with memcpy");
+
+  static constexpr u32 Infinite = SMByteChannel::Infinite;
+
+  explicit SMChannel(SMByteChannel* channel) : m_channel(channel) {
+    BIFROST_ASSERT(m_channel->GetElementSize() == sizeof(T) && "Element size mismatch");
+  }
+
+  /// Get the underlying channel
+  SMByteChannel* Get() const { return m_channel; }
+
+  /// Maximum number of elements in the channel
+  u64 Capacity() const { return m_channel->Capacity(); }
+
+  /// Number of elements currently in the channel (only a snapshot if the channel is in use)
+  u64 Size() const { return m_channel->Size(); }
+
+  /// Push up to `count` elements without blocking - returns the number of pushed elements
+  u64 TryPush(Context* ctx, const T* elements, u64 count) { return m_channel->TryPush(ctx, elements, count); }
+  bool TryPush(Context* ctx, const T& element) { return TryPush(ctx, &element, 1) == 1; }
+
+  /// Pop up to `count` elements without blocking - returns the number of popped elements
+  u64 TryPop(Context* ctx, T* elements, u64 count) { return m_channel->TryPop(ctx, elements, count); }
+  bool TryPop(Context* ctx, T& element) { return TryPop(ctx, &element, 1) == 1; }
+
+  /// Push all `count` elements waiting at most `timeoutInMs` - returns the number of pushed elements
+  u64 Push(Context* ctx, const T* elements, u64 count, u32 timeoutInMs = Infinite) { return m_channel->Push(ctx, elements, count, timeoutInMs); }
+  bool Push(Context* ctx, const T& element, u32 timeoutInMs = Infinite) { return Push(ctx, &element, 1, timeoutInMs) == 1; }
+
+  /// Pop up to `count` elements waiting at most `timeoutInMs` for the first one - returns the number of popped elements
+  u64 Pop(Context* ctx, T* elements, u64 count, u32 timeoutInMs = Infinite) { return m_channel->Pop(ctx, elements, count, timeoutInMs); }
+  bool Pop(Context* ctx, T& element, u32 timeoutInMs = Infinite) { return Pop(ctx, &element, 1, timeoutInMs) == 1; }
+
+ private:
+  SMByteChannel* m_channel;
+};
+
+/// Named channels - unique per shared memory region (allocated in SMContext)
+class SMChannelRegistry : public SMObject {
+ public:
+  void Destruct(SharedMemory* mem);
+
+  /// Open the channel `name` or create it with `capacity` elements if it does not exist yet
+  ///
+  /// Throws if the channel exists with a different element size.
+  SMByteChannel* Open(Context* ctx, std::string_view name, u32 elementSize, u64 capacity);
+
+  /// Open the channel `name` with elements of type `T` (see above)
+  template <class T>
+  SMChannel<T> Open(Context* ctx, std::string_view name, u64 capacity) {
+    return SMChannel<T>(Open(ctx, name, sizeof(T), capacity));
+  }
+
+  /// Number of channels
+  u64 Size() const { return m_channels.Size(); }
+
+ private:
+  struct Entry : public SMObject {
+    Entry(Context* ctx, std::string_view name, Ptr<SMByteChannel> channel) : Name(ctx, name), Channel(channel) {}
+    void Destruct(SharedMemory* mem) {
+      Name.Destruct(mem);
+      Delete(mem, Channel);
+    }
+
+    SMString Name;
+    Ptr<SMByteChannel> Channel;
+  };
+
+  SpinMutex m_mutex;
+  SMVector<Entry> m_channels;
+};
+
+}  // namespace bifrost
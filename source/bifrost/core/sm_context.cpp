@@ -14,6 +14,18 @@
 
 namespace bifrost {
 
+namespace {
+
+/// Create a random non-zero identifier
+u64 NewId() {
+  std::random_device device;
+  u64 id = 0;
+  while (id == 0) id = ((u64)device() << 32) | device();
+  return id;
+}
+
+}  // namespace
+
 SMContext* SMContext::Create(SharedMemory* mem, u64 memorySize) {
   // Allocate memory (this is never released)
   void* firstAddress = mem->Allocate(sizeof(SMContext));
@@ -28,8 +40,12 @@ SMContext* SMContext::Create(SharedMemory* mem, u64 memorySize) {
   BIFROST_LOCK_GUARD(smCtx->m_mutex);
   smCtx->m_refCount = 1;
   smCtx->m_memorySize = memorySize;
+  smCtx->m_id = NewId();
+  smCtx->m_atoms = New<SMAtomTable>(mem);
   smCtx->m_storage = New<SMStorage>(mem);
-  smCtx->m_logstash = New<SMLogStash>(mem);
+  smCtx->m_channels = New<SMChannelRegistry>(mem);
+  smCtx->m_logstash = New<SMLogStash>(mem, mem, memorySize);
+  smCtx->m_loglevels = New<SMLogLevels>(mem);
   return smCtx;
 }
 
@@ -45,12 +61,21 @@ void SMContext::Destruct(SharedMemory* mem, SMContext* smCtx) {
   BIFROST_LOCK_GUARD(smCtx->m_mutex);
   if (--smCtx->m_refCount == 0) {
     Delete(mem, smCtx->m_storage);
+    Delete(mem, smCtx->m_channels);
     Delete(mem, smCtx->m_logstash);
+    Delete(mem, smCtx->m_loglevels);
+    Delete(mem, smCtx->m_atoms);
   }
 }
 
+SMAtomTable* SMContext::GetSMAtomTable(SharedMemory* mem) { return m_atoms.Resolve(mem->GetBaseAddress()); }
+
+SMChannelRegistry* SMContext::GetSMChannelRegistry(SharedMemory* mem) { return m_channels.Resolve(mem->GetBaseAddress()); }
+
 SMLogStash* SMContext::GetSMLogStash(SharedMemory* mem) { return m_logstash.Resolve(mem->GetBaseAddress()); }
 
+SMLogLevels* SMContext::GetSMLogLevels(SharedMemory* mem) { return m_loglevels.Resolve(mem->GetBaseAddress()); }
+
 SMStorage* SMContext::GetSMStorage(SharedMemory* mem) { return m_storage.Resolve(mem->GetBaseAddress()); }
 
 }  // namespace bifrost
\ No newline at end of file
@@ -14,6 +14,9 @@
 #include "bifrost/core/common.h"
 #include "bifrost/core/context.h"
 #include "bifrost/core/mutex.h"
+#include "bifrost/core/sm_atom_table.h"
+#include "bifrost/core/sm_channel.h"
+#include "bifrost/core/sm_log_levels.h"
 #include "bifrost/core/sm_log_stash.h"
 #include "bifrost/core/sm_storage.h"
 
@@ -38,18 +41,34 @@ class SMContext {
   /// Get the allocated shared memory
   u64 GetMemorySize() const { return m_memorySize; }
 
+  /// Get the identifier of the shared memory region (unique across regions, even if they are mapped at the same address)
+  u64 GetId() const { return m_id; }
+
+  /// Get the atom table
+  SMAtomTable* GetSMAtomTable(SharedMemory* mem);
+
+  /// Get the channel registry
+  SMChannelRegistry* GetSMChannelRegistry(SharedMemory* mem);
+
   /// Get the log stash
   SMLogStash* GetSMLogStash(SharedMemory* mem);
 
+  /// Get the log levels
+  SMLogLevels* GetSMLogLevels(SharedMemory* mem);
+
   /// Get the storage
   SMStorage* GetSMStorage(SharedMemory* mem);
 
  private:
+  Ptr<SMAtomTable> m_atoms;
   Ptr<SMStorage> m_storage;
+  Ptr<SMChannelRegistry> m_channels;
   Ptr<SMLogStash> m_logstash;
+  Ptr<SMLogLevels> m_loglevels;
   SpinMutex m_mutex;
   u32 m_refCount;
   u64 m_memorySize;
+  u64 m_id;
 };
 
 }  // namespace bifrost
@@ -0,0 +1,189 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/ptr.h"
+#include "bifrost/core/sm_new.h"
+
+namespace bifrost {
+
+/// Shared memory double-ended queue stored as a linked list of blocks of `BlockSize` elements
+///
+/// Elements are only allocated per block and the most recently released block is kept as a spare, hence a queue at steady state does not
+/// touch the allocator.
+template <class ValueT, u32 BlockSize = 32>
+class SMDeque : public SMObject {
+  static_assert(BlockSize > 0, "invalid block size");
+
+ public:
+  struct Block {
+    Ptr<Block> Prev = Ptr<Block>();
+    Ptr<Block> Next = Ptr<Block>();
+    typename std::aligned_storage<sizeof(ValueT), alignof(ValueT)>::type Data[BlockSize];
+
+    ValueT* At(u32 i) { return reinterpret_cast<ValueT*>(&Data[i]); }
+  };
+
+  /// Destruct the deque
+  void Destruct(SharedMemory* mem) {
+    while (!Empty()) PopFrontImpl(mem);
+    if (!m_spare.IsNull()) Delete(mem, m_spare);
+    m_spare = Ptr<Block>();
+  }
+
+  /// Append `v` to the back
+  void PushBack(Context* ctx, ValueT v) {
+    if (Empty()) {
+      m_front = m_back = AllocateBlock(ctx);
+      m_frontIndex = m_backIndex = 0;
+    } else if (m_backIndex == BlockSize) {
+      Ptr<Block> block = AllocateBlock(ctx);
+      Resolve(ctx, block)->Prev = m_back;
+      Resolve(ctx, m_back)->Next = block;
+      m_back = block;
+      m_backIndex = 0;
+    }
+    ::new (Resolve(ctx, m_back)->At(m_backIndex++)) ValueT(std::move(v));
+    ++m_size;
+  }
+
+  /// Prepend `v` to the front
+  void PushFront(Context* ctx, ValueT v) {
+    if (Empty()) {
+      m_front = m_back = AllocateBlock(ctx);
+      m_frontIndex = m_backIndex = BlockSize;
+    } else if (m_frontIndex == 0) {
+      Ptr<Block> block = AllocateBlock(ctx);
+      Resolve(ctx, block)->Next = m_front;
+      Resolve(ctx, m_front)->Prev = block;
+      m_front = block;
+      m_frontIndex = BlockSize;
+    }
+    ::new (Resolve(ctx, m_front)->At(--m_frontIndex)) ValueT(std::move(v));
+    ++m_size;
+  }
+
+  /// Return the value at the front or NULL if the deque is empty
+  ValueT* PeekFront(Context* ctx) const {
+    if (Empty()) return nullptr;
+    return Resolve(ctx, m_front)->At(m_frontIndex);
+  }
+
+  /// Return the value at the back or NULL if the deque is empty
+  ValueT* PeekBack(Context* ctx) const {
+    if (Empty()) return nullptr;
+    return Resolve(ctx, m_back)->At(m_backIndex - 1);
+  }
+
+  /// Remove the front element
+  void PopFront(Context* ctx) { PopFrontImpl(&ctx->Memory()); }
+
+  /// Remove the back element
+  void PopBack(Context* ctx) {
+    BIFROST_ASSERT(!Empty() && "PopBack on empty deque");
+    SharedMemory* mem = &ctx->Memory();
+
+    Block* back = Resolve(mem, m_back);
+    DestructElement(mem, back->At(--m_backIndex));
+    --m_size;
+
+    if (Empty()) {
+      ReleaseBlock(mem, m_back);
+      m_front = m_back = Ptr<Block>();
+    } else if (m_backIndex == 0) {
+      Ptr<Block> prev = back->Prev;
+      ReleaseBlock(mem, m_back);
+      m_back = prev;
+      Resolve(mem, m_back)->Next = Ptr<Block>();
+      m_backIndex = BlockSize;
+    }
+  }
+
+  /// Iterate from front to back
+  ///
+  /// Return `false` to stop iteration, `true` to continue
+  template <class FunctorT>
+  inline void ForEach(Context* ctx, FunctorT&& functor) const {
+    u32 index = m_frontIndex;
+    for (Ptr<Block> curBlock = m_front; !curBlock.IsNull(); curBlock = Resolve(ctx, curBlock)->Next, index = 0) {
+      Block* block = Resolve(ctx, curBlock);
+      u32 end = curBlock == m_back ? m_backIndex : BlockSize;
+      for (; index < end; ++index) {
+        if (!functor(block->At(index))) return;
+      }
+    }
+  }
+
+  /// Get the number of elements
+  u64 Size() const { return m_size; }
+
+  /// Check if deque is empty
+  bool Empty() const { return m_size == 0; }
+
+  /// Remove all elements and release the memory
+  void Clear(Context* ctx) { Destruct(&ctx->Memory()); }
+
+ private:
+  void PopFrontImpl(SharedMemory* mem) {
+    BIFROST_ASSERT(!Empty() && "PopFront on empty deque");
+
+    Block* front = Resolve(mem, m_front);
+    DestructElement(mem, front->At(m_frontIndex++));
+    --m_size;
+
+    if (Empty()) {
+      ReleaseBlock(mem, m_front);
+      m_front = m_back = Ptr<Block>();
+    } else if (m_frontIndex == BlockSize) {
+      Ptr<Block> next = front->Next;
+      ReleaseBlock(mem, m_front);
+      m_front = next;
+      Resolve(mem, m_front)->Prev = Ptr<Block>();
+      m_frontIndex = 0;
+    }
+  }
+
+  void DestructElement(SharedMemory* mem, ValueT* ptr) {
+    internal::Destruct(mem, ptr);
+    ptr->~ValueT();
+  }
+
+  Ptr<Block> AllocateBlock(Context* ctx) {
+    if (m_spare.IsNull()) return New<Block>(ctx);
+
+    Ptr<Block> block = m_spare;
+    m_spare = Ptr<Block>();
+    Block* blockP = Resolve(ctx, block);
+    blockP->Prev = Ptr<Block>();
+    blockP->Next = Ptr<Block>();
+    return block;
+  }
+
+  void ReleaseBlock(SharedMemory* mem, Ptr<Block> block) {
+    if (m_spare.IsNull()) {
+      m_spare = block;
+    } else {
+      Delete(mem, block);
+    }
+  }
+
+ private:
+  Ptr<Block> m_front = Ptr<Block>();
+  Ptr<Block> m_back = Ptr<Block>();
+  Ptr<Block> m_spare = Ptr<Block>();
+  u32 m_frontIndex = 0;
+  u32 m_backIndex = 0;
+  u64 m_size = 0;
+};
+
+}  // namespace bifrost
@@ -58,6 +58,7 @@ class SMHashMap : public SMObject {
 
   /// Get the value of element with key `k` or NULL if no such key exists
   const ValueT* Get(Context* ctx, const KeyT& k) const {
+    if (m_capacity == 0) return nullptr;
     i32 idx = HashKey(ctx, k);
 
     // Linear probing
@@ -92,6 +93,7 @@ class SMHashMap : public SMObject {
 
   /// Remove the key `k`
   bool Remove(Context* ctx, const KeyT& k) {
+    if (m_capacity == 0) return false;
     i32 idx = HashKey(ctx, k);
 
     // Linear probing
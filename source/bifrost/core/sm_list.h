@@ -17,7 +17,7 @@
 
 namespace bifrost {
 
-/// Shared memory string
+/// Shared memory doubly linked list
 template <class ValueT>
 class SMList : public SMObject {
  public:
@@ -27,7 +27,7 @@ class SMList : public SMObject {
     Ptr<Node> Next = Ptr<Node>();
   };
 
-  /// Destruct the list
+  /// Destruct the list (including the nodes in the pool)
   void Destruct(SharedMemory* mem) {
     while (!Empty()) {
       Ptr<Node> tailA = m_tail;
@@ -38,18 +38,42 @@ class SMList : public SMObject {
 
       Delete(mem, tailA);
     }
+    m_head = Ptr<Node>();
+    m_size = 0;
+
+    ShrinkPool(mem, 0);
+  }
+
+  /// Keep up to `capacity` erased nodes in a per-list pool to be reused by subsequent insertions (0 disables the pool)
+  void SetPoolCapacity(Context* ctx, u64 capacity) {
+    m_poolCapacity = capacity;
+    ShrinkPool(&ctx->Memory(), capacity);
+  }
+
+  /// Fill the pool with `count` nodes (raises the pool capacity if needed)
+  void ReservePool(Context* ctx, u64 count) {
+    m_poolCapacity = std::max(m_poolCapacity, count);
+    while (m_poolSize < count) {
+      Ptr<Node> node = New<Node>(ctx);
+      Resolve(ctx, node)->Prev = m_pool;
+      m_pool = node;
+      ++m_poolSize;
+    }
   }
 
+  /// Get the number of nodes in the pool
+  u64 PoolSize() const { return m_poolSize; }
+
   /// Create a new node with value `v` and treat it as the new head
   void PushFront(Context* ctx, ValueT v) {
     Ptr<Node> oldHead = m_head;
 
-    m_head = New<Node>(ctx);
-    Resolve(ctx, m_head)->Value = std::move(v);
+    m_head = AllocateNode(ctx, std::move(v));
     Resolve(ctx, m_head)->Prev = oldHead;
 
     if (!oldHead.IsNull()) Resolve(ctx, oldHead)->Next = m_head;
     if (m_tail.IsNull()) m_tail = m_head;
+    ++m_size;
   }
 
   /// Return the value of head or NULL if list is empty
@@ -61,19 +85,18 @@ class SMList : public SMObject {
   /// Insert a new node with value `v` *after* node `pos`
   void Insert(Context* ctx, Node* pos, ValueT v) {
     if (Empty()) {
-      PushFront(ctx, std::move(v))
+      PushFront(ctx, std::move(v));
+      return;
     }
     if (pos == Resolve(ctx, m_tail)) {
       PushBack(ctx, std::move(v));
     } else {
       Ptr<Node> posA = Ptr<Node>::FromAddress(pos, ctx->Memory().GetBaseAddress());
-      Ptr<Node> nodeA = New<Node>(ctx);
+      Ptr<Node> nodeA = AllocateNode(ctx, std::move(v));
 
       Node* nodeP = Resolve(ctx, nodeA);
       Node* posP = pos;
 
-      nodeP->Value = std::move(v);
-
       Ptr<Node> posPrevA = posP->Prev;
       Node* posPrevP = Resolve(ctx, posPrevA);
 
@@ -81,6 +104,7 @@ class SMList : public SMObject {
       nodeP->Next = posA;
       posP->Prev = nodeA;
       posPrevP->Next = nodeA;
+      ++m_size;
     }
   }
 
@@ -88,12 +112,12 @@ class SMList : public SMObject {
   void PushBack(Context* ctx, ValueT v) {
     Ptr<Node> oldTail = m_tail;
 
-    m_tail = New<Node>(ctx);
-    Resolve(ctx, m_tail)->Value = std::move(v);
+    m_tail = AllocateNode(ctx, std::move(v));
     Resolve(ctx, m_tail)->Next = oldTail;
 
     if (!oldTail.IsNull()) Resolve(ctx, oldTail)->Prev = m_tail;
     if (m_head.IsNull()) m_head = m_tail;
+    ++m_size;
   }
 
   /// Return the value of tail or NULL if list is empty
@@ -102,7 +126,7 @@ class SMList : public SMObject {
     return &Resolve(ctx, m_tail)->Value;
   }
 
-  /// Erase the node `pos`
+  /// Erase the node `pos` - if `deferDelete` is true the caller takes ownership of the node and has to `Delete` it
   inline void Erase(Context* ctx, Node* pos, bool deferDelete = false) {
     Node* posP = pos;
     Ptr<Node> posA = Ptr<Node>::FromAddress(posP, ctx->Memory().GetBaseAddress());
@@ -127,8 +151,9 @@ class SMList : public SMObject {
       Resolve(ctx, oldNext)->Prev = oldPrev;
     }
 
+    --m_size;
     if (!deferDelete) {
-      Delete(ctx, posA);
+      ReleaseNode(&ctx->Memory(), posA);
     }
   }
 
@@ -159,14 +184,8 @@ class SMList : public SMObject {
   }
 
   /// Get the size of the list
-  inline u64 Size(Context* ctx) const {
-    u64 size = 0;
-    ForeachHeadToTail(ctx, [&size](Node* node) -> bool {
-      size += 1;
-      return true;
-    });
-    return size;
-  }
+  inline u64 Size() const { return m_size; }
+  inline u64 Size(Context* ctx) const { return m_size; }
 
   /// Check if list is empty
   bool Empty() const { return m_head.IsNull() || m_tail.IsNull(); }
@@ -177,9 +196,59 @@ class SMList : public SMObject {
   /// Get the head pointer
   Ptr<Node> GetTail() const { return m_tail; }
 
+ private:
+  Ptr<Node> AllocateNode(Context* ctx, ValueT&& v) {
+    if (m_pool.IsNull()) {
+      Ptr<Node> node = New<Node>(ctx);
+      Resolve(ctx, node)->Value = std::move(v);
+      return node;
+    }
+
+    // Reuse a node of the pool (the value has already been destructed)
+    Ptr<Node> node = m_pool;
+    Node* nodeP = Resolve(ctx, node);
+    m_pool = nodeP->Prev;
+    --m_poolSize;
+
+    nodeP->Value = std::move(v);
+    nodeP->Prev = Ptr<Node>();
+    nodeP->Next = Ptr<Node>();
+    return node;
+  }
+
+  void ReleaseNode(SharedMemory* mem, Ptr<Node> node) {
+    if (m_poolSize >= m_poolCapacity) {
+      Delete(mem, node);
+      return;
+    }
+
+    // Release the shared memory held by the value and keep the node (linked via `Prev`)
+    Node* nodeP = Resolve(mem, node);
+    internal::Destruct(mem, &nodeP->Value);
+    nodeP->Prev = m_pool;
+    m_pool = node;
+    ++m_poolSize;
+  }
+
+  void ShrinkPool(SharedMemory* mem, u64 capacity) {
+    while (m_poolSize > capacity) {
+      Node* nodeP = Resolve(mem, m_pool);
+      m_pool = nodeP->Prev;
+      --m_poolSize;
+
+      // The value has already been destructed
+      nodeP->~Node();
+      mem->Deallocate(nodeP);
+    }
+  }
+
  private:
   Ptr<Node> m_head = Ptr<Node>();
   Ptr<Node> m_tail = Ptr<Node>();
+  Ptr<Node> m_pool = Ptr<Node>();
+  u64 m_size = 0;
+  u64 m_poolSize = 0;
+  u64 m_poolCapacity = 0;
 };
 
 }  // namespace bifrost
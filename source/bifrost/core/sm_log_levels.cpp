@@ -0,0 +1,66 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/sm_log_levels.h"
+
+namespace bifrost {
+
+void SMLogLevels::Destruct(SharedMemory* mem) { m_levels.Destruct(mem); }
+
+void SMLogLevels::SetDefaultLevel(u32 level) {
+  BIFROST_LOCK_GUARD(m_mutex);
+  m_defaultLevel.store(level, std::memory_order_release);
+  m_version.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void SMLogLevels::SetLevel(Context* ctx, u32 moduleAtom, u32 level) {
+  BIFROST_LOCK_GUARD(m_mutex);
+
+  Entry* entries = m_levels.Data(ctx);
+  u64 i = 0;
+  for (; i < m_levels.Size(); ++i) {
+    if (entries[i].Module == moduleAtom) break;
+  }
+
+  if (i < m_levels.Size()) {
+    entries[i].Level = level;
+  } else {
+    m_levels.PushBack(ctx, Entry{moduleAtom, level});
+  }
+  m_version.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void SMLogLevels::ResetLevel(Context* ctx, u32 moduleAtom) {
+  BIFROST_LOCK_GUARD(m_mutex);
+
+  Entry* entries = m_levels.Data(ctx);
+  for (u64 i = 0; i < m_levels.Size(); ++i) {
+    if (entries[i].Module == moduleAtom) {
+      entries[i] = entries[m_levels.Size() - 1];
+      m_levels.PopBack(ctx);
+      m_version.fetch_add(1, std::memory_order_acq_rel);
+      return;
+    }
+  }
+}
+
+u32 SMLogLevels::GetLevel(Context* ctx, u32 moduleAtom) {
+  BIFROST_LOCK_GUARD(m_mutex);
+
+  const Entry* entries = m_levels.Data(ctx);
+  for (u64 i = 0; i < m_levels.Size(); ++i) {
+    if (entries[i].Module == moduleAtom) return entries[i].Level;
+  }
+  return m_defaultLevel.load(std::memory_order_relaxed);
+}
+
+}  // namespace bifrost
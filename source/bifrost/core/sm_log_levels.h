@@ -0,0 +1,59 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/mutex.h"
+#include "bifrost/core/sm_object.h"
+#include "bifrost/core/sm_vector.h"
+
+namespace bifrost {
+
+/// Minimum log level per module - unique per shared memory region (allocated in SMContext)
+///
+/// Every change bumps a version counter, hence loggers can cache the level of their module and only look it up again if the version
+/// changed.
+class SMLogLevels : public SMObject {
+ public:
+  void Destruct(SharedMemory* mem);
+
+  /// Set the minimum level of modules without an explicit level
+  void SetDefaultLevel(u32 level);
+
+  /// Get the minimum level of modules without an explicit level
+  u32 GetDefaultLevel() const { return m_defaultLevel.load(std::memory_order_acquire); }
+
+  /// Set the minimum level of `moduleAtom`
+  void SetLevel(Context* ctx, u32 moduleAtom, u32 level);
+
+  /// Remove the explicit level of `moduleAtom` (it uses the default level afterwards)
+  void ResetLevel(Context* ctx, u32 moduleAtom);
+
+  /// Get the minimum level of `moduleAtom`
+  u32 GetLevel(Context* ctx, u32 moduleAtom);
+
+  /// Get the version of the levels (changes whenever a level is modified)
+  u32 GetVersion() const { return m_version.load(std::memory_order_acquire); }
+
+ private:
+  struct Entry {
+    u32 Module;
+    u32 Level;
+  };
+
+  SpinMutex m_mutex;
+  std::atomic<u32> m_version{0};
+  std::atomic<u32> m_defaultLevel{0};
+  SMVector<Entry> m_levels;
+};
+
+}  // namespace bifrost
@@ -11,79 +11,559 @@
 
 #include "bifrost/core/common.h"
 #include "bifrost/core/sm_log_stash.h"
+#include "bifrost/core/binary_log.h"
+#include "bifrost/core/deferred_format.h"
+#include "bifrost/core/event.h"
 #include "bifrost/core/ilogger.h"
+#include "bifrost/core/sm_atom_table.h"
+#include "bifrost/core/timestamp.h"
 
 namespace bifrost {
 
-void SMLogStash::Destruct(SharedMemory* mem) { m_messageQueue.Destruct(mem); }
+namespace {
+
+inline u64 AlignRecordSize(u64 size) { return (size + 7) & ~u64(7); }
+
+// Orders the heap of held back messages with the oldest message at the front
+struct LaterPending {
+  template <class PendingT>
+  bool operator()(const PendingT& a, const PendingT& b) const {
+    if (a.Message.Timestamp != b.Message.Timestamp) return a.Message.Timestamp > b.Message.Timestamp;
+    return a.Seq > b.Seq;
+  }
+};
+
+}  // namespace
+
+SMLogStash::SMLogStash(SharedMemory* mem, u64 memorySize) : m_capacity(ComputeCapacity(memorySize)), m_byteBudget(m_capacity) {
+  void* buffer = mem->Allocate(m_capacity);
+  if (!buffer) throw std::runtime_error("Failed to allocate memory for the log stash");
+
+  // The consumer relies on unwritten record headers being zero
+  std::memset(buffer, 0, m_capacity);
+  m_buffer = Ptr<u8>(mem->Offset(buffer));
+}
+
+void SMLogStash::Destruct(SharedMemory* mem) {
+  mem->Deallocate(Resolve(mem, m_buffer));
+  m_buffer = Ptr<u8>();
+
+  while (!m_spillHead.IsNull()) {
+    SpillRecord* spillRecord = Resolve(mem, m_spillHead);
+    m_spillHead = spillRecord->Next;
+    mem->Deallocate(spillRecord);
+  }
+  m_spillTail = Ptr<SpillRecord>();
+}
 
 bool SMLogStash::Empty() {
-  BIFROST_LOCK_GUARD(m_mutex);
-  return m_messageQueue.Empty();
+  return m_readPos.load(std::memory_order_acquire) == m_writePos.load(std::memory_order_acquire) &&
+         m_numSpilled.load(std::memory_order_acquire) == 0;
+}
+
+void SMLogStash::SetOverflowPolicy(OverflowPolicy policy, u32 blockTimeoutInMs) {
+  m_blockTimeoutInMs.store(blockTimeoutInMs, std::memory_order_relaxed);
+  m_policy.store((u32)policy, std::memory_order_relaxed);
+}
+
+void SMLogStash::SetBudget(u64 maxBytes, u64 maxRecords) {
+  m_byteBudget.store(std::max(std::min(maxBytes, m_capacity), m_capacity / 2), std::memory_order_relaxed);
+  m_recordBudget.store(maxRecords, std::memory_order_relaxed);
+}
+
+u64 SMLogStash::NumDropped() const {
+  u64 numDropped = 0;
+  for (const auto& n : m_numDropped) numDropped += n.load(std::memory_order_relaxed);
+  return numDropped;
+}
+
+void SMLogStash::Push(Context* ctx, u32 level, u32 moduleAtom, const char* message) {
+  Entry entry = MakeEntry(level, moduleAtom, message);
+  PushImpl(ctx, &entry, 1);
+}
+
+void SMLogStash::PushDeferred(Context* ctx, u32 level, u32 moduleAtom, u32 formatAtom, const u8* args, u64 size) {
+  Entry entry;
+  entry.Level = level;
+  entry.Module = moduleAtom;
+  entry.Message = (const char*)args;
+  entry.Length = std::min(size, MaxMessageLength() - sizeof(u32));
+  entry.Size = AlignRecordSize(offsetof(Record, Message) + sizeof(u32) + entry.Length);
+  entry.Flags = DeferredFlag;
+  entry.Format = formatAtom;
+  entry.Timestamp = GetTimestamp();
+  entry.ThreadId = ::GetCurrentThreadId();
+  PushImpl(ctx, &entry, 1);
+}
+
+void SMLogStash::PushBatch(Context* ctx, const ILogger::LogRecord* records, u64 count) {
+  SMAtomTable* atoms = ctx->Memory().GetSMAtomTable();
+
+  // Batches usually originate from one module - only intern the module if it changes
+  const char* lastModule = nullptr;
+  u32 lastModuleAtom = SMAtomTable::EmptyAtom;
+
+  std::array<u32, MaxBatchSize> moduleAtoms;
+  for (u64 first = 0; first < count; first += MaxBatchSize) {
+    u64 n = std::min(MaxBatchSize, count - first);
+    for (u64 i = 0; i < n; ++i) {
+      const char* module = records[first + i].Module == nullptr ? "" : records[first + i].Module;
+      if (lastModule == nullptr || std::strcmp(module, lastModule) != 0) {
+        lastModule = module;
+        lastModuleAtom = atoms->Intern(ctx, module);
+      }
+      moduleAtoms[i] = lastModuleAtom;
+    }
+    PushBatch(ctx, records + first, moduleAtoms.data(), n);
+  }
+}
+
+void SMLogStash::PushBatch(Context* ctx, const ILogger::LogRecord* records, const u32* moduleAtoms, u64 count) {
+  std::array<Entry, MaxBatchSize> entries;
+  for (u64 first = 0; first < count; first += MaxBatchSize) {
+    u64 n = std::min(MaxBatchSize, count - first);
+    for (u64 i = 0; i < n; ++i) {
+      const ILogger::LogRecord& record = records[first + i];
+      entries[i] = MakeEntry(static_cast<u32>(record.Level), moduleAtoms[first + i], record.Message);
+      if (record.Timestamp != 0) {
+        entries[i].Timestamp = record.Timestamp;
+        entries[i].ThreadId = record.ThreadId;
+      }
+    }
+    PushImpl(ctx, entries.data(), n);
+  }
 }
 
-void SMLogStash::Push(Context* ctx, u32 level, const char* module, const char* message) {
-  SMLogMessage msg{level, {ctx, module == nullptr ? "" : module}, {ctx, message == nullptr ? "" : message}};
-  BIFROST_LOCK_GUARD(m_mutex);
-  m_messageQueue.PushBack(ctx, std::move(msg));
+SMLogStash::Entry SMLogStash::MakeEntry(u32 level, u32 module, const char* message) const {
+  Entry entry;
+  entry.Level = level;
+  entry.Module = module;
+  entry.Message = message == nullptr ? "" : message;
+  entry.Length = std::min((u64)std::strlen(entry.Message), MaxMessageLength());
+  entry.Size = AlignRecordSize(offsetof(Record, Message) + entry.Length);
+  entry.Flags = 0;
+  entry.Format = 0;
+  entry.Timestamp = GetTimestamp();
+  entry.ThreadId = ::GetCurrentThreadId();
+  return entry;
+}
+
+void SMLogStash::PushImpl(Context* ctx, const Entry* entries, u64 count) {
+  BIFROST_ASSERT(count <= MaxBatchSize);
+
+  // Messages must not overtake the ones of this process which still wait in the spill file to be announced
+  if (GetOverflowPolicy() == OverflowPolicy::SpillToDisk) {
+    LogSpillFile* file = ctx->Memory().GetLogSpillFiles().GetOwnIfCreated();
+    if (file && file->HasPending()) {
+      u64 numSpilled = SpillToDisk(ctx, entries, count);
+      for (u64 i = numSpilled; i < count; ++i) Drop(entries[i]);
+      return;
+    }
+  }
+
+  u64 numPushed = TryPushImpl(ctx, entries, count);
+  if (numPushed == count) return;
+
+  // The budget is exhausted - apply the overflow policy to the remaining entries
+  switch (GetOverflowPolicy()) {
+    case OverflowPolicy::DropOldest:
+      while (numPushed < count && DiscardOldest(ctx, entries[numPushed].Size)) numPushed += TryPushImpl(ctx, entries + numPushed, count - numPushed);
+      break;
+    case OverflowPolicy::Block: {
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_blockTimeoutInMs.load(std::memory_order_relaxed));
+      ctx->Memory().GetLogStashEvent().Signal();
+      while (numPushed < count && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+        numPushed += TryPushImpl(ctx, entries + numPushed, count - numPushed);
+      }
+      break;
+    }
+    case OverflowPolicy::Spill:
+      for (; numPushed < count; ++numPushed) {
+        if (!Spill(ctx, entries[numPushed])) break;
+      }
+      WakeConsumer(ctx);
+      break;
+    case OverflowPolicy::SpillToDisk:
+      numPushed += SpillToDisk(ctx, entries + numPushed, count - numPushed);
+      break;
+    default:
+      break;
+  }
+
+  for (u64 i = numPushed; i < count; ++i) Drop(entries[i]);
+}
+
+u64 SMLogStash::TryPushImpl(Context* ctx, const Entry* entries, u64 count) {
+  u64 byteBudget = m_byteBudget.load(std::memory_order_relaxed);
+  u64 recordBudget = m_recordBudget.load(std::memory_order_relaxed);
+
+  // Reserve contiguous space for as many records as fit - if a record does not fit before the end of the buffer, the remainder is
+  // reserved as well and filled with a padding record
+  u64 pos = m_writePos.load(std::memory_order_relaxed);
+  u64 numReserved = 0;
+  for (;;) {
+    u64 readPos = m_readPos.load(std::memory_order_acquire);
+    if (readPos > pos) {
+      // The consumer already moved past our stale write position
+      pos = m_writePos.load(std::memory_order_relaxed);
+      continue;
+    }
+
+    // The record budget is a soft limit as the number of records is only updated after the reservation
+    u64 maxRecords = count;
+    if (recordBudget != 0) {
+      u64 numRecords = m_numRecords.load(std::memory_order_relaxed);
+      maxRecords = numRecords >= recordBudget ? 0 : std::min(count, recordBudget - numRecords);
+    }
+
+    u64 end = pos;
+    for (numReserved = 0; numReserved < maxRecords; ++numReserved) {
+      u64 size = entries[numReserved].Size;
+      u64 contiguous = m_capacity - (end & (m_capacity - 1));
+      u64 paddingSize = size > contiguous ? contiguous : 0;
+      if (end + paddingSize + size - readPos > byteBudget) break;
+      end += paddingSize + size;
+    }
+
+    if (numReserved == 0) return 0;
+    if (m_writePos.compare_exchange_weak(pos, end, std::memory_order_acq_rel, std::memory_order_relaxed)) break;
+  }
+  m_numRecords.fetch_add(numReserved, std::memory_order_relaxed);
+
+  // Write the records in the same layout as computed above
+  u8* buffer = Resolve(ctx, m_buffer);
+  for (u64 i = 0; i < numReserved; ++i) {
+    const Entry& entry = entries[i];
+
+    u64 contiguous = m_capacity - (pos & (m_capacity - 1));
+    if (entry.Size > contiguous) {
+      GetRecord(buffer, pos)->Header.store(contiguous | PaddingFlag | CommittedFlag, std::memory_order_release);
+      pos += contiguous;
+    }
+
+    // Publish the record
+    Record* record = GetRecord(buffer, pos);
+    WriteRecord(record, entry);
+    record->Header.store(entry.Size | entry.Flags | CommittedFlag, std::memory_order_release);
+    pos += entry.Size;
+  }
+  WakeConsumer(ctx);
+  return numReserved;
+}
+
+bool SMLogStash::DiscardOldest(Context* ctx, u64 size) {
+  BIFROST_LOCK_GUARD(m_consumerMutex);
+  u8* buffer = Resolve(ctx, m_buffer);
+
+  u64 readPos = m_readPos.load(std::memory_order_relaxed);
+  u64 writePos = m_writePos.load(std::memory_order_acquire);
+  u64 numFreed = 0;
+  while (numFreed < size && readPos != writePos) {
+    // Records which are still being written can't be discarded, neither can markers as their spilled records would never be released
+    Record* record = GetRecord(buffer, readPos);
+    u64 header = record->Header.load(std::memory_order_acquire);
+    if ((header & CommittedFlag) == 0 || (header & SpillMarkerFlag) != 0) break;
+
+    u64 recordSize = header & SizeMask;
+    if ((header & PaddingFlag) == 0) {
+      m_numDropped[std::min(record->Level, NumLevels - 1)].fetch_add(1, std::memory_order_relaxed);
+      m_numRecords.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::memset(record, 0, recordSize);
+    readPos += recordSize;
+    numFreed += recordSize;
+  }
+
+  m_readPos.store(readPos, std::memory_order_release);
+  return numFreed > 0;
 }
 
-bool SMLogStash::TryPop(Context* ctx, LogMessage& msg) {
-  SMLogMessage* newMsg = nullptr;
+bool SMLogStash::Spill(Context* ctx, const Entry& entry) {
+  if (m_numSpilledBytes.fetch_add(entry.Size, std::memory_order_relaxed) + entry.Size > m_byteBudget.load(std::memory_order_relaxed)) {
+    m_numSpilledBytes.fetch_sub(entry.Size, std::memory_order_relaxed);
+    return false;
+  }
 
-  // Get the front node
-  {
-    BIFROST_LOCK_GUARD(m_mutex);
-    newMsg = m_messageQueue.PeekFront(ctx);
-    if (!newMsg) return false;
-    m_messageQueue.PopFront(ctx, true);
+  SharedMemory* mem = &ctx->Memory();
+  SpillRecord* spillRecord = (SpillRecord*)mem->Allocate(offsetof(SpillRecord, Data) + entry.Size);
+  if (!spillRecord) {
+    m_numSpilledBytes.fetch_sub(entry.Size, std::memory_order_relaxed);
+    return false;
   }
 
-  // Copy the message out of shared memory
-  msg.Level = newMsg->Level;
-  msg.Module = newMsg->Module.AsView(ctx);
-  msg.Message = newMsg->Message.AsView(ctx);
+  spillRecord->Next = Ptr<SpillRecord>();
+  WriteRecord(&spillRecord->Data, entry);
+  spillRecord->Data.Header.store(entry.Size | entry.Flags | CommittedFlag, std::memory_order_relaxed);
 
-  // Delete the message (we delayed the delete during PopFront)
-  Delete(ctx, Ptr<SMLogMessage>::FromAddress(newMsg, ctx->Memory().GetBaseAddress()));
+  Ptr<SpillRecord> spillRecordPtr(mem->Offset(spillRecord));
+  BIFROST_LOCK_GUARD(m_spillMutex);
+  if (m_spillTail.IsNull()) {
+    m_spillHead = spillRecordPtr;
+  } else {
+    Resolve(mem, m_spillTail)->Next = spillRecordPtr;
+  }
+  m_spillTail = spillRecordPtr;
+  m_numSpilled.fetch_add(1, std::memory_order_release);
   return true;
 }
 
-u64 SMLogStash::Size(Context* ctx) {
-  BIFROST_LOCK_GUARD(m_mutex);
-  return m_messageQueue.Size(ctx);
+u64 SMLogStash::SpillToDisk(Context* ctx, const Entry* entries, u64 count) {
+  LogSpillFile* file = nullptr;
+  try {
+    file = ctx->Memory().GetLogSpillFiles().GetOwn();
+  } catch (std::runtime_error&) {
+    return 0;
+  }
+
+  std::lock_guard<std::mutex> lock(file->GetMutex());
+  u8* data = file->GetData();
+  u64 capacity = file->GetCapacity();
+
+  // Append the records to the ring of the spill file in the same layout as the stash
+  u64 readPos = file->GetReadPos();
+  u64 pos = file->GetWritePos();
+  u64 begin = pos;
+  u64 numSpilled = 0;
+  for (; numSpilled < count; ++numSpilled) {
+    const Entry& entry = entries[numSpilled];
+    u64 contiguous = capacity - (pos & (capacity - 1));
+    u64 paddingSize = entry.Size > contiguous ? contiguous : 0;
+    if (pos + paddingSize + entry.Size - readPos > capacity) break;
+
+    if (paddingSize != 0) {
+      reinterpret_cast<Record*>(data + (pos & (capacity - 1)))->Header.store(contiguous | PaddingFlag | CommittedFlag, std::memory_order_relaxed);
+      pos += paddingSize;
+    }
+
+    Record* record = reinterpret_cast<Record*>(data + (pos & (capacity - 1)));
+    WriteRecord(record, entry);
+    record->Header.store(entry.Size | entry.Flags | CommittedFlag, std::memory_order_relaxed);
+    pos += entry.Size;
+  }
+  file->SetWritePos(pos);
+  if (numSpilled > 0) file->AddPending(begin, (u32)numSpilled);
+  if (file->HasPending()) PushSpillMarker(ctx, file, m_blockTimeoutInMs.load(std::memory_order_relaxed));
+  return numSpilled;
+}
+
+void SMLogStash::AnnounceSpilled(Context* ctx) {
+  LogSpillFile* file = ctx->Memory().GetLogSpillFiles().GetOwnIfCreated();
+  if (!file || !file->HasPending()) return;
+
+  std::lock_guard<std::mutex> lock(file->GetMutex());
+  if (file->HasPending()) PushSpillMarker(ctx, file, 0);
+}
+
+bool SMLogStash::PushSpillMarker(Context* ctx, LogSpillFile* file, u32 timeoutInMs) {
+  // Announce all records which are not yet announced with a single marker - the marker is small, hence it usually fits once the consumer
+  // made some progress
+  SpillMarker marker{(u32)::GetCurrentProcessId(), file->GetNumPending(), file->GetPendingBegin(), file->GetWritePos()};
+  Entry markerEntry = MakeEntry(0, SMAtomTable::EmptyAtom, "");
+  markerEntry.Message = (const char*)&marker;
+  markerEntry.Length = sizeof(SpillMarker);
+  markerEntry.Size = AlignRecordSize(offsetof(Record, Message) + sizeof(SpillMarker));
+  markerEntry.Flags = SpillMarkerFlag;
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutInMs);
+  for (;;) {
+    if (TryPushImpl(ctx, &markerEntry, 1) == 1) {
+      file->ClearPending();
+      return true;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) return false;
+    ctx->Memory().GetLogStashEvent().Signal();
+    std::this_thread::yield();
+  }
+}
+
+void SMLogStash::WriteRecord(Record* record, const Entry& entry) {
+  record->Timestamp = entry.Timestamp;
+  record->Level = entry.Level;
+  record->Module = entry.Module;
+  record->ThreadId = entry.ThreadId;
+  if (entry.Flags & DeferredFlag) {
+    record->Length = (u32)(sizeof(u32) + entry.Length);
+    std::memcpy(record->Message, &entry.Format, sizeof(u32));
+    std::memcpy(record->Message + sizeof(u32), entry.Message, entry.Length);
+  } else {
+    record->Length = (u32)entry.Length;
+    std::memcpy(record->Message, entry.Message, entry.Length);
+  }
+}
+
+void SMLogStash::ReadRecord(Context* ctx, const Record* record, u64 header, LogMessage& msg) {
+  SMAtomTable* atoms = ctx->Memory().GetSMAtomTable();
+  msg.Level = record->Level;
+  msg.Timestamp = record->Timestamp;
+  msg.ThreadId = record->ThreadId;
+  msg.Module = atoms->GetString(ctx, record->Module);
+  if (header & DeferredFlag) {
+    // Format the message on the consumer side
+    u32 format;
+    std::memcpy(&format, record->Message, sizeof(u32));
+    msg.Message.clear();
+    FormatDeferred(msg.Message, atoms->GetString(ctx, format), (const u8*)record->Message + sizeof(u32), record->Length - sizeof(u32));
+  } else {
+    msg.Message.assign(record->Message, record->Length);
+  }
+}
+
+bool SMLogStash::TryPop(Context* ctx, LogMessage& msg) { return TryPopBatch(ctx, &msg, 1) == 1; }
+
+u64 SMLogStash::TryPopBatch(Context* ctx, LogMessage* msgs, u64 count) {
+  u64 numPopped = 0;
+  return PopImpl(ctx, count, [&](const Record* record, u64 header) { ReadRecord(ctx, record, header, msgs[numPopped++]); });
+}
+
+void SMLogStash::Wait(Context* ctx, u32 timeoutInMs) {
+  // Announce that we are about to sleep before checking for messages - a producer publishing a record either sees the flag and signals
+  // the event or its record is seen by the check (the fences pair with the one in `WakeConsumer`)
+  m_consumerWaiting.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (!IsNextRecordCommitted(ctx)) ctx->Memory().GetLogStashEvent().Wait(timeoutInMs);
+  m_consumerWaiting.store(0, std::memory_order_relaxed);
+}
+
+bool SMLogStash::IsNextRecordCommitted(Context* ctx) {
+  if (m_numSpilled.load(std::memory_order_acquire) != 0) return true;
+  u64 readPos = m_readPos.load(std::memory_order_acquire);
+  if (readPos == m_writePos.load(std::memory_order_acquire)) return false;
+  return (GetRecord(Resolve(ctx, m_buffer), readPos)->Header.load(std::memory_order_acquire) & CommittedFlag) != 0;
 }
 
-LogStashConsumer::LogStashConsumer(Context* ctx, SMLogStash* logStash, ILogger* sink) {
-  m_consumerThread = std::thread([this, ctx, logStash, sink]() {
-    std::array<u64, 5> timeoutInMs{1, 5, 10, 50, 100};
-    u64 curTimeoutInMsIndex = 0;
+void SMLogStash::WakeConsumer(Context* ctx) {
+  // Only signal if the consumer is (about to go) asleep, i.e on the transition from an empty to a non-empty stash
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_consumerWaiting.load(std::memory_order_relaxed) != 0 && m_consumerWaiting.exchange(0, std::memory_order_relaxed) != 0) {
+    ctx->Memory().GetLogStashEvent().Signal();
+  }
+}
 
-    SMLogStash::LogMessage m_buffer;
-    m_buffer.Message.reserve(1024);
-    m_buffer.Module.reserve(1024);
+u64 SMLogStash::MaxMessageLength() const { return m_capacity / 4 - offsetof(Record, Message); }
 
-    while (!m_done || !logStash->Empty()) {
-      if (logStash->Empty()) {
-        // No messages.. sleep
-        ::Sleep((DWORD)timeoutInMs[curTimeoutInMsIndex]);
-        curTimeoutInMsIndex = std::min(curTimeoutInMsIndex + 1, timeoutInMs.size() - 1);
+u64 SMLogStash::ComputeCapacity(u64 memorySize) {
+  u64 capacity = MinCapacity;
+  while (capacity < memorySize / 16 && capacity < MaxCapacity) capacity <<= 1;
+  return capacity;
+}
+
+LogStashConsumer::LogStashConsumer(Context* ctx, SMLogStash* logStash, ILogger* sink, BinaryLogWriter* writer, u32 reorderWindowInMs)
+    : m_ctx(ctx) {
+  m_records.resize(BatchSize);
+  m_due.reserve(BatchSize);
+  m_consumerThread = std::thread([this, ctx, logStash, sink, writer, reorderWindowInMs]() {
+    if (writer && ConsumeBinary(ctx, logStash, sink, writer)) return;
+    ConsumeFormatted(ctx, logStash, sink, reorderWindowInMs);
+  });
+}
+
+bool LogStashConsumer::ConsumeBinary(Context* ctx, SMLogStash* logStash, ILogger* sink, BinaryLogWriter* writer) {
+  try {
+    while (!m_done.load() || !logStash->Empty()) {
+      u64 numMessages = logStash->TryPopRaw(ctx, BatchSize, [&](const SMLogStash::RawLogMessage& msg) { writer->Write(ctx, msg); });
+      if (numMessages == 0) {
+        writer->Flush();
+        sink->Flush();
+        ctx->Memory().GetLogSpillFiles().CloseExited([&]() { return logStash->Empty(); });
+        logStash->Wait(ctx, 100);
+      }
+      ReportDropped(logStash);
+      SinkDue(sink, ~0ull);
+    }
+    writer->Flush();
+  } catch (std::exception& e) {
+    // Rotating the binary log failed (e.g the disk is full) - give up on the binary log and forward the remaining messages to the sink
+    AddPending(SMLogStash::LogMessage{(u32)ILogger::LogLevel::Error, GetTimestamp(), ::GetCurrentThreadId(), "bifrost",
+                                      StringFormat("Failed to write binary log, logging to the sink instead: %s", e.what())});
+    SinkDue(sink, ~0ull);
+    return false;
+  }
+  sink->Flush();
+  return true;
+}
+
+void LogStashConsumer::ConsumeFormatted(Context* ctx, SMLogStash* logStash, ILogger* sink, u32 reorderWindowInMs) {
+  const u64 reorderWindow = GetTimestampFrequency() * reorderWindowInMs / 1000;
+  std::vector<SMLogStash::LogMessage> messages(BatchSize);
+
+  while (!m_done.load() || !logStash->Empty()) {
+    u64 numMessages = logStash->TryPopBatch(ctx, messages.data(), messages.size());
+    for (u64 i = 0; i < numMessages; ++i) AddPending(std::move(messages[i]));
+
+    // Producers publish their messages in batches per thread - hold the messages back to restore the order across threads
+    u64 now = GetTimestamp();
+    SinkDue(sink, reorderWindow == 0 ? ~0ull : now > reorderWindow ? now - reorderWindow : 0);
+
+    if (numMessages == 0) {
+      if (m_pending.empty()) {
+        // No messages.. hand over what the sink holds back and block until a producer signals (the timeout guards against producers which
+        // died before committing a record)
+        sink->Flush();
+        ctx->Memory().GetLogSpillFiles().CloseExited([&]() { return logStash->Empty(); });
+        logStash->Wait(ctx, 100);
       } else {
-        // Try to pop one message
-        if (logStash->TryPop(ctx, m_buffer)) {
-          sink->Sink((ILogger::LogLevel)m_buffer.Level, m_buffer.Module.c_str(), m_buffer.Message.c_str());
-          curTimeoutInMsIndex = 0;
-        }
+        // Wake up once the oldest held back message is due
+        u64 due = m_pending.front().Message.Timestamp + reorderWindow;
+        u64 dueInMs = due > now ? (due - now) * 1000 / GetTimestampFrequency() + 1 : 0;
+        logStash->Wait(ctx, (u32)std::min<u64>(reorderWindowInMs, dueInMs));
       }
     }
-  });
+    ReportDropped(logStash);
+  }
+  SinkDue(sink, ~0ull);
+  sink->Flush();
+}
+
+void LogStashConsumer::AddPending(SMLogStash::LogMessage&& msg) {
+  m_pending.emplace_back(PendingMessage{std::move(msg), m_nextSeq++});
+  std::push_heap(m_pending.begin(), m_pending.end(), LaterPending());
+}
+
+void LogStashConsumer::SinkDue(ILogger* sink, u64 cutoff) {
+  while (!m_pending.empty() && m_pending.front().Message.Timestamp <= cutoff) {
+    std::pop_heap(m_pending.begin(), m_pending.end(), LaterPending());
+    m_due.emplace_back(std::move(m_pending.back().Message));
+    m_pending.pop_back();
+
+    if (m_due.size() == BatchSize || m_pending.empty() || m_pending.front().Message.Timestamp > cutoff) {
+      for (u64 i = 0; i < m_due.size(); ++i) {
+        const SMLogStash::LogMessage& msg = m_due[i];
+        m_records[i] = ILogger::LogRecord{(ILogger::LogLevel)msg.Level, msg.Module.c_str(), msg.Message.c_str(), msg.Timestamp, msg.ThreadId};
+      }
+      sink->SinkBatch(m_records.data(), m_due.size());
+      m_due.clear();
+    }
+  }
 }
 
 LogStashConsumer::~LogStashConsumer() { StopAndFlush(); }
 
+void LogStashConsumer::ReportDropped(SMLogStash* logStash) {
+  static const char* levelNames[SMLogStash::NumLevels] = {"trace", "debug", "info", "warn", "error"};
+
+  std::string levels;
+  u64 numDropped = 0;
+  for (u32 level = 0; level < SMLogStash::NumLevels; ++level) {
+    u64 n = logStash->NumDropped(level) - m_numReportedDropped[level];
+    if (n == 0) continue;
+
+    m_numReportedDropped[level] += n;
+    numDropped += n;
+    levels += StringFormat("%s%s: %llu", levels.empty() ? "" : ", ", levelNames[level], n);
+  }
+
+  if (numDropped > 0) {
+    AddPending(SMLogStash::LogMessage{(u32)ILogger::LogLevel::Warn, GetTimestamp(), ::GetCurrentThreadId(), "bifrost",
+                                      StringFormat("Dropped %llu log messages as the log stash was full (%s)", numDropped, levels.c_str())});
+  }
+}
+
 void LogStashConsumer::StopAndFlush() {
-  if (!m_done) {
-    m_done = true;
+  if (!m_done.exchange(true)) {
+    m_ctx->Memory().GetLogStashEvent().Signal();
     m_consumerThread.join();
   }
 }
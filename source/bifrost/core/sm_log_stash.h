@@ -12,60 +12,387 @@
 #pragma once
 
 #include "bifrost/core/common.h"
+#include "bifrost/core/ilogger.h"
+#include "bifrost/core/log_spill.h"
 #include "bifrost/core/mutex.h"
+#include "bifrost/core/padding.h"
 #include "bifrost/core/sm_object.h"
-#include "bifrost/core/sm_list.h"
-#include "bifrost/core/sm_string.h"
 
 namespace bifrost {
 
+class BinaryLogWriter;
+
 /// Shared log stash - unique per shared memory region (allocated in SMContext)
+///
+/// The stash is a ring of variable-length records in one preallocated buffer. Producers reserve space for a record by advancing the write
+/// position and publish it by setting the committed flag in the record header, hence pushing a message takes neither a lock nor an
+/// allocation. Records are consumed in order by a single consumer which clears the bytes before handing them back to the producers.
 class SMLogStash : public SMObject {
  public:
+  /// Smallest and largest capacity of the ring buffer in bytes
+  static constexpr u64 MinCapacity = 1 << 10;
+  static constexpr u64 MaxCapacity = 1 << 20;
+
+  /// Number of log levels with a drop counter (Trace to Error)
+  static constexpr u32 NumLevels = 5;
+
+  /// Behavior of producers if the budget of the stash is exhausted
+  enum class OverflowPolicy : u32 {
+    DropNewest = 0,  ///< Drop the message which is pushed
+    DropOldest,      ///< Discard the oldest messages in the stash to make room
+    Block,           ///< Wait up to the block timeout for the consumer to make room, then drop the message
+    Spill,           ///< Store the message in a side list allocated from the shared memory (bounded by the byte budget)
+    SpillToDisk      ///< Write the message to the spill file of the process and announce it with a marker record (see LogSpillFile)
+  };
+
+  /// Create the stash with a capacity derived from the size of the shared memory region
+  SMLogStash(SharedMemory* mem, u64 memorySize);
+
   void Destruct(SharedMemory* mem);
 
   /// System memory log message
   struct LogMessage {
     u32 Level;
+    u64 Timestamp;
+    u32 ThreadId;
     std::string Module;
     std::string Message;
   };
 
+  /// Unformatted log message passed to the functor of `TryPopRaw` (`Data` is only valid during the call)
+  struct RawLogMessage {
+    u32 Level;
+    u32 ThreadId;
+    u64 Timestamp;
+    u32 Module;    ///< Atom of the module
+    bool Deferred; ///< If true, `Data` holds the atom of the format string followed by the encoded arguments (see DeferredArgs)
+    const char* Data;
+    u32 Length;
+  };
+
   /// Is the stash empty?
   bool Empty();
 
-  /// Push a new message to the back of the queue
-  void Push(Context* ctx, u32 level, const char* module, const char* message);
+  /// Set the policy applied if the budget is exhausted - `blockTimeoutInMs` is the longest time a producer waits with `Block`
+  void SetOverflowPolicy(OverflowPolicy policy, u32 blockTimeoutInMs = 10);
+
+  /// Get the policy applied if the budget is exhausted
+  OverflowPolicy GetOverflowPolicy() const { return (OverflowPolicy)m_policy.load(std::memory_order_relaxed); }
+
+  /// Limit the stash to `maxBytes` (clamped to [Capacity / 2, Capacity]) and `maxRecords` unconsumed records (0 for no limit)
+  void SetBudget(u64 maxBytes, u64 maxRecords);
+
+  /// Push a new message to the back of the queue - `moduleAtom` is the interned module (see SMAtomTable), the message is dropped if the
+  /// stash is full
+  void Push(Context* ctx, u32 level, u32 moduleAtom, const char* message);
+
+  /// Push a message whose formatting is deferred to the consumer - `formatAtom` is the atom of the printf-style format string and `args`
+  /// the arguments encoded by DeferredArgs
+  void PushDeferred(Context* ctx, u32 level, u32 moduleAtom, u32 formatAtom, const u8* args, u64 size);
+
+  /// Push `count` messages with a single reservation - messages which don't fit into the stash are dropped (records without a timestamp are
+  /// stamped with the current time and thread)
+  void PushBatch(Context* ctx, const ILogger::LogRecord* records, u64 count);
+
+  /// Push `count` messages using already interned modules (the modules of `records` are ignored)
+  void PushBatch(Context* ctx, const ILogger::LogRecord* records, const u32* moduleAtoms, u64 count);
 
   /// Try to get the message at the top of the queue and assign it to `msg` - returns true on success
   bool TryPop(Context* ctx, LogMessage& msg);
 
-  /// Size of the stash (only used for testing - O(n))
-  u64 Size(Context* ctx);
+  /// Try to get up to `count` messages from the top of the queue - returns the number of messages assigned to `msgs`
+  u64 TryPopBatch(Context* ctx, LogMessage* msgs, u64 count);
+
+  /// Try to get up to `count` messages from the top of the queue without formatting them - returns the number of messages passed to
+  /// `functor` (called as `functor(const RawLogMessage&)`)
+  template <class FunctorT>
+  u64 TryPopRaw(Context* ctx, u64 count, FunctorT&& functor) {
+    return PopImpl(ctx, count, [&](const Record* record, u64 header) {
+      functor(RawLogMessage{record->Level, record->ThreadId, record->Timestamp, record->Module, (header & DeferredFlag) != 0, record->Message,
+                            record->Length});
+    });
+  }
+
+  /// Announce the messages of this process which have been written to its spill file but could not yet be announced to the consumer as the
+  /// stash was full (see OverflowPolicy::SpillToDisk)
+  void AnnounceSpilled(Context* ctx);
+
+  /// Block the consumer until a message can be popped, the log stash event is signaled or `timeoutInMs` elapsed
+  void Wait(Context* ctx, u32 timeoutInMs);
+
+  /// Capacity of the ring buffer in bytes
+  u64 Capacity() const { return m_capacity; }
+
+  /// Number of messages dropped because the stash was full
+  u64 NumDropped() const;
+
+  /// Number of messages at `level` dropped because the stash was full
+  u64 NumDropped(u32 level) const { return m_numDropped[std::min(level, NumLevels - 1)].load(std::memory_order_relaxed); }
+
+  /// Number of messages currently stored in the spill list
+  u64 NumSpilled() const { return m_numSpilled.load(std::memory_order_relaxed); }
+
+  /// Longest message which is stored without truncation
+  u64 MaxMessageLength() const;
+
+  /// Get the capacity of a stash in a shared memory region of `memorySize` bytes
+  static u64 ComputeCapacity(u64 memorySize);
 
  private:
-  struct SMLogMessage {
+  /// Flags of the record header (the lower 32 bits hold the size of the record in bytes, including the header)
+  static constexpr u64 SizeMask = 0xFFFFFFFF;
+  static constexpr u64 CommittedFlag = u64(1) << 32;
+  static constexpr u64 PaddingFlag = u64(1) << 33;
+  static constexpr u64 DeferredFlag = u64(1) << 34;
+  static constexpr u64 SpillMarkerFlag = u64(1) << 35;
+
+  /// Maximum number of messages reserved at once
+  static constexpr u64 MaxBatchSize = 64;
+
+  /// Message to be pushed
+  struct Entry {
+    u32 Level;
+    u32 Module;
+    u64 Timestamp;
+    u32 ThreadId;
+    const char* Message;
+    u64 Length;
+    u64 Size;
+    u64 Flags;
+    u32 Format;
+  };
+
+  /// Record of a message (deferred records store the format atom followed by the encoded arguments in `Message`)
+  struct Record {
+    std::atomic<u64> Header;
+    u64 Timestamp;
     u32 Level;
-    SMString Module;
-    SMString Message;
+    u32 Module;
+    u32 Length;
+    u32 ThreadId;
+    char Message[4];
   };
 
-  SpinMutex m_mutex;
-  SMList<SMLogMessage> m_messageQueue;
+  /// Message of a marker record - the records in [Begin, End) of the spill file of process `Pid` are replayed in place of the marker
+  struct SpillMarker {
+    u32 Pid;
+    u32 Count;  ///< Number of records (counted as dropped if the file is gone)
+    u64 Begin;
+    u64 End;
+  };
+
+  /// Record in the spill list
+  struct SpillRecord {
+    Ptr<SpillRecord> Next;
+    Record Data;
+  };
+
+  /// Fill in length and size of the record of `message` logged now by the calling thread
+  Entry MakeEntry(u32 level, u32 module, const char* message) const;
+
+  /// Push `count` entries (at most `MaxBatchSize`) and apply the overflow policy to the ones which don't fit
+  void PushImpl(Context* ctx, const Entry* entries, u64 count);
+
+  /// Reserve and write the records of as many of the `count` entries as fit into the budget - returns the number of written records
+  u64 TryPushImpl(Context* ctx, const Entry* entries, u64 count);
+
+  /// Discard the oldest records to make room for `size` bytes - returns false if nothing could be discarded
+  bool DiscardOldest(Context* ctx, u64 size);
+
+  /// Append `entry` to the spill list - returns false if the spill list is full
+  bool Spill(Context* ctx, const Entry& entry);
+
+  /// Write `count` entries to the spill file of this process and announce them with a marker record - returns the number of written entries
+  u64 SpillToDisk(Context* ctx, const Entry* entries, u64 count);
+
+  /// Push a marker announcing the pending records of `file`, retry for up to `timeoutInMs` (requires the mutex of `file`)
+  bool PushSpillMarker(Context* ctx, LogSpillFile* file, u32 timeoutInMs);
+
+  /// Replay the records announced by `marker` until `count` messages have been popped - returns true if all records have been replayed
+  template <class FunctorT>
+  bool ReplaySpilled(Context* ctx, const Record* marker, u64 count, u64& numPopped, FunctorT& functor) {
+    SpillMarker spillMarker;
+    std::memcpy(&spillMarker, marker->Message, sizeof(SpillMarker));
+
+    // The file outlives the writer until we replayed it, the records are only lost if the file was removed behind our back (their level
+    // is unknown, count them as info)
+    LogSpillFile* file = ctx->Memory().GetLogSpillFiles().Open(spillMarker.Pid);
+    if (!file) {
+      m_numDropped[(u32)ILogger::LogLevel::Info].fetch_add(spillMarker.Count, std::memory_order_relaxed);
+      return true;
+    }
+
+    u8* data = file->GetData();
+    u64 mask = file->GetCapacity() - 1;
+    u64 pos = std::max(spillMarker.Begin, file->GetReadPos());
+    while (pos < spillMarker.End && numPopped < count) {
+      const Record* record = reinterpret_cast<const Record*>(data + (pos & mask));
+      u64 header = record->Header.load(std::memory_order_acquire);
+      if ((header & PaddingFlag) == 0) {
+        functor(record, header);
+        numPopped++;
+      }
+      pos += header & SizeMask;
+    }
+
+    // Hand the bytes back to the writer
+    file->SetReadPos(pos);
+    return pos >= spillMarker.End;
+  }
+
+  /// Write the fields and the message of `entry` to `record` (the header is not touched)
+  static void WriteRecord(Record* record, const Entry& entry);
+
+  /// Read the committed `record` into `msg`
+  static void ReadRecord(Context* ctx, const Record* record, u64 header, LogMessage& msg);
+
+  /// Count `entry` as dropped
+  void Drop(const Entry& entry) { m_numDropped[std::min(entry.Level, NumLevels - 1)].fetch_add(1, std::memory_order_relaxed); }
+
+  /// Is the record at the read position committed?
+  bool IsNextRecordCommitted(Context* ctx);
+
+  /// Wake up the consumer if it is waiting (called after publishing a record)
+  void WakeConsumer(Context* ctx);
+
+  /// Consume up to `count` records in order, `functor(const Record*, u64 header)` is called for each message before it is released
+  template <class FunctorT>
+  u64 PopImpl(Context* ctx, u64 count, FunctorT&& functor) {
+    BIFROST_LOCK_GUARD(m_consumerMutex);
+    u8* buffer = Resolve(ctx, m_buffer);
+
+    u64 readPos = m_readPos.load(std::memory_order_relaxed);
+    u64 writePos = m_writePos.load(std::memory_order_acquire);
+    u64 numPopped = 0;
+    u64 numRecords = 0;
+    while (numPopped < count && readPos != writePos) {
+      // Records are consumed in order - if the next one is still being written we have to wait for it
+      Record* record = GetRecord(buffer, readPos);
+      u64 header = record->Header.load(std::memory_order_acquire);
+      if ((header & CommittedFlag) == 0) break;
+
+      u64 size = header & SizeMask;
+      if (header & SpillMarkerFlag) {
+        // Keep the marker until all of its records have been replayed
+        if (!ReplaySpilled(ctx, record, count, numPopped, functor)) break;
+        numRecords++;
+      } else if ((header & PaddingFlag) == 0) {
+        functor(static_cast<const Record*>(record), header);
+        numPopped++;
+        numRecords++;
+      }
+
+      // Clear the record before handing the bytes back to the producers
+      std::memset(record, 0, size);
+      readPos += size;
+    }
+
+    // Release all consumed records at once
+    m_readPos.store(readPos, std::memory_order_release);
+    m_numRecords.fetch_sub(numRecords, std::memory_order_relaxed);
+
+    // Spilled records are consumed once the ring is drained
+    if (numPopped < count && readPos == writePos && m_numSpilled.load(std::memory_order_acquire) != 0) {
+      SharedMemory* mem = &ctx->Memory();
+      BIFROST_LOCK_GUARD(m_spillMutex);
+      while (numPopped < count && !m_spillHead.IsNull()) {
+        SpillRecord* spillRecord = Resolve(mem, m_spillHead);
+        u64 header = spillRecord->Data.Header.load(std::memory_order_relaxed);
+        functor(static_cast<const Record*>(&spillRecord->Data), header);
+        numPopped++;
+
+        m_spillHead = spillRecord->Next;
+        if (m_spillHead.IsNull()) m_spillTail = Ptr<SpillRecord>();
+        m_numSpilledBytes.fetch_sub(header & SizeMask, std::memory_order_relaxed);
+        m_numSpilled.fetch_sub(1, std::memory_order_release);
+        mem->Deallocate(spillRecord);
+      }
+    }
+    return numPopped;
+  }
+
+  Record* GetRecord(u8* buffer, u64 pos) const { return reinterpret_cast<Record*>(buffer + (pos & (m_capacity - 1))); }
+
+  Ptr<u8> m_buffer;
+  u64 m_capacity;
+  std::atomic<u32> m_policy{(u32)OverflowPolicy::DropNewest};
+  std::atomic<u32> m_blockTimeoutInMs{10};
+  std::atomic<u64> m_byteBudget;
+  std::atomic<u64> m_recordBudget{0};
+  Padding<CacheLineSize - sizeof(Ptr<u8>) - 4 * sizeof(u64)> m_pad0;
+
+  std::atomic<u64> m_writePos{0};
+  std::atomic<u64> m_numRecords{0};
+  Padding<CacheLineSize - 2 * sizeof(u64)> m_pad1;
+
+  std::atomic<u64> m_readPos{0};
+  std::atomic<u32> m_consumerWaiting{0};
+  SpinMutex m_consumerMutex;
+  Padding<CacheLineSize - sizeof(u64) - 2 * sizeof(u32)> m_pad2;
+
+  std::atomic<u64> m_numDropped[NumLevels] = {};
+
+  SpinMutex m_spillMutex;
+  Ptr<SpillRecord> m_spillHead;
+  Ptr<SpillRecord> m_spillTail;
+  std::atomic<u64> m_numSpilled{0};
+  std::atomic<u64> m_numSpilledBytes{0};
 };
 
 /// Consume the log stash by forwarding the messages to the underlying logger
+///
+/// Producers publish the messages of a thread in batches (see SharedLogger), so a message can arrive after newer messages of other threads.
+/// By default, the messages are sinked as soon as they are popped (sorted by timestamp within a batch). If a reorder window is given, the
+/// consumer holds every message back for the window and sinks the messages in the order of their timestamps - messages which arrive later
+/// than the window are sinked as soon as possible (out of order). The binary log keeps the order of arrival, bifrost-logdump sorts the
+/// messages when decoding.
 class LogStashConsumer {
  public:
-  /// Start consuming messages from `logStash` and forward them to `sink`
-  LogStashConsumer(Context* ctx, SMLogStash* logStash, ILogger* sink);
+  /// Maximum number of messages popped and sinked at once
+  static constexpr u64 BatchSize = 64;
+
+  /// Default time a message is held back to restore the order across threads (0 to sink messages immediately)
+  static constexpr u32 DefaultReorderWindowInMs = 0;
+
+  /// Start consuming messages from `logStash` and forward them to `sink` - if `writer` is not NULL, the messages are appended unformatted to
+  /// the binary log instead (`sink` only receives the drop reports, or all messages once writing the binary log failed)
+  LogStashConsumer(Context* ctx, SMLogStash* logStash, ILogger* sink, BinaryLogWriter* writer = nullptr,
+                   u32 reorderWindowInMs = DefaultReorderWindowInMs);
   ~LogStashConsumer();
 
   /// Stop consuming messages - flushes all remaining messages
   void StopAndFlush();
 
  private:
-  bool m_done = false;
+  /// Append the messages to the binary log until stopped - returns false if writing the binary log failed
+  bool ConsumeBinary(Context* ctx, SMLogStash* logStash, ILogger* sink, BinaryLogWriter* writer);
+
+  /// Sink the messages in the order of their timestamps until stopped
+  void ConsumeFormatted(Context* ctx, SMLogStash* logStash, ILogger* sink, u32 reorderWindowInMs);
+
+  /// Queue a warning reporting the messages dropped since the last report
+  void ReportDropped(SMLogStash* logStash);
+
+  /// Sink the held back messages older than `cutoff` (all if `cutoff` is ~0) in the order of their timestamps
+  void SinkDue(ILogger* sink, u64 cutoff);
+
+  /// Held back message (`Seq` keeps the order of arrival for equal timestamps)
+  struct PendingMessage {
+    SMLogStash::LogMessage Message;
+    u64 Seq;
+  };
+
+  /// Hold back `msg` until it is due
+  void AddPending(SMLogStash::LogMessage&& msg);
+
+  std::vector<PendingMessage> m_pending;  ///< Min-heap ordered by timestamp
+  u64 m_nextSeq = 0;
+  std::vector<SMLogStash::LogMessage> m_due;
+  std::vector<ILogger::LogRecord> m_records;
+
+  std::array<u64, SMLogStash::NumLevels> m_numReportedDropped = {};
+  std::atomic<bool> m_done{false};
+  Context* m_ctx;
   std::thread m_consumerThread;
 };
 
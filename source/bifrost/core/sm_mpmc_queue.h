@@ -0,0 +1,123 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/padding.h"
+#include "bifrost/core/ptr.h"
+#include "bifrost/core/sm_new.h"
+
+namespace bifrost {
+
+/// Bounded multi-producer/multi-consumer queue of trivially copyable elements in shared memory
+///
+/// Each slot carries a sequence number which tells producers and consumers whether the slot is free or filled for the current lap, hence
+/// an enqueue or dequeue only needs a single CAS on the respective position (see D. Vyukov's bounded MPMC queue).
+template <class ValueT>
+class SMMPMCQueue : public SMObject {
+ public:
+  static_assert(std::is_trivially_copyable<ValueT>::value, "queue elements are copied between processes");
+  static_assert(std::atomic<u64>::is_always_lock_free, "positions need to be lock-free to be shared across processes");
+
+  /// Create a queue of `capacity` elements (rounded up to the next power of 2)
+  SMMPMCQueue(Context* ctx, u64 capacity) {
+    m_capacity = 2;
+    while (m_capacity < capacity) m_capacity <<= 1;
+
+    m_cells = NewArray<Cell>(ctx, m_capacity);
+    Cell* cells = Resolve(ctx, m_cells);
+    for (u64 i = 0; i < m_capacity; ++i) cells[i].Sequence.store(i, std::memory_order_relaxed);
+  }
+
+  /// Destruct the queue
+  void Destruct(SharedMemory* mem) { DeleteArray(mem, m_cells, m_capacity); }
+
+  /// Maximum number of elements in the queue
+  u64 Capacity() const { return m_capacity; }
+
+  /// Number of elements currently in the queue (only a snapshot if the queue is in use)
+  u64 Size() const {
+    u64 dequeuePos = m_dequeuePos.load(std::memory_order_acquire);
+    u64 enqueuePos = m_enqueuePos.load(std::memory_order_acquire);
+    return enqueuePos >= dequeuePos ? enqueuePos - dequeuePos : 0;
+  }
+
+  /// Try to enqueue `value` - returns false if the queue is full
+  bool TryPush(Context* ctx, const ValueT& value) {
+    Cell* cells = Resolve(ctx, m_cells);
+    Cell* cell = nullptr;
+
+    u64 pos = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells[pos & (m_capacity - 1)];
+      i64 diff = (i64)cell->Sequence.load(std::memory_order_acquire) - (i64)pos;
+      if (diff == 0) {
+        // Slot is free in this lap - claim it
+        if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        // Slot still holds an element of the previous lap
+        return false;
+      } else {
+        // Another producer claimed the slot
+        pos = m_enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->Value = value;
+    cell->Sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Try to dequeue an element into `value` - returns false if the queue is empty
+  bool TryPop(Context* ctx, ValueT& value) {
+    Cell* cells = Resolve(ctx, m_cells);
+    Cell* cell = nullptr;
+
+    u64 pos = m_dequeuePos.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells[pos & (m_capacity - 1)];
+      i64 diff = (i64)cell->Sequence.load(std::memory_order_acquire) - (i64)(pos + 1);
+      if (diff == 0) {
+        // Slot is filled in this lap - claim it
+        if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        // Slot has not been filled yet
+        return false;
+      } else {
+        // Another consumer claimed the slot
+        pos = m_dequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    value = cell->Value;
+    cell->Sequence.store(pos + m_capacity, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<u64> Sequence;
+    ValueT Value;
+  };
+
+  Ptr<Cell> m_cells;
+  u64 m_capacity;
+  Padding<CacheLineSize - sizeof(Ptr<Cell>) - sizeof(u64)> m_pad0;
+
+  std::atomic<u64> m_enqueuePos{0};
+  Padding<CacheLineSize - sizeof(u64)> m_pad1;
+
+  std::atomic<u64> m_dequeuePos{0};
+  Padding<CacheLineSize - sizeof(u64)> m_pad2;
+};
+
+}  // namespace bifrost
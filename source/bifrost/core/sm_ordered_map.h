@@ -0,0 +1,358 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/ptr.h"
+#include "bifrost/core/sm_new.h"
+
+namespace bifrost {
+
+/// Shared memory ordered map implemented as a B+ tree with `Fanout` entries per node
+///
+/// Keys and values are stored inline in the nodes and have to be trivially copyable. The leaves are linked which makes range scans a
+/// sequential walk. Removing elements does not rebalance the tree.
+template <class KeyT, class ValueT, class CompareT = std::less<KeyT>, u32 Fanout = 32>
+class SMOrderedMap : public SMObject {
+  static_assert(std::is_trivially_copyable<KeyT>::value, "keys are moved with memmove");
+  static_assert(std::is_trivially_copyable<ValueT>::value, "values are moved with memmove");
+  static_assert(Fanout >= 3, "fanout is too small");
+
+  struct Leaf {
+    u32 Size = 0;
+    KeyT Keys[Fanout];
+    ValueT Values[Fanout];
+    Ptr<Leaf> Next = Ptr<Leaf>();
+  };
+
+  /// Inner node with `Size` keys and `Size + 1` children (holds one extra key/child to split after an insertion)
+  struct Inner {
+    u32 Size = 0;
+    KeyT Keys[Fanout];
+    Ptr<u8> Children[Fanout + 1];
+  };
+
+ public:
+  /// Position in the map (only valid as long as the map is not modified)
+  class Cursor {
+   public:
+    Cursor() = default;
+    Cursor(Context* ctx, Leaf* leaf, u32 index) : m_ctx(ctx), m_leaf(leaf), m_index(index) { SkipEmpty(); }
+
+    /// Does the cursor point to an element?
+    bool IsValid() const { return m_leaf != nullptr; }
+
+    /// Get the key of the element
+    const KeyT& Key() const { return m_leaf->Keys[m_index]; }
+
+    /// Get the value of the element
+    ValueT& Value() const { return m_leaf->Values[m_index]; }
+
+    /// Advance to the next element
+    void Next() {
+      ++m_index;
+      SkipEmpty();
+    }
+
+   private:
+    void SkipEmpty() {
+      while (m_leaf && m_index >= m_leaf->Size) {
+        m_leaf = m_leaf->Next.IsNull() ? nullptr : m_leaf->Next.Resolve(m_ctx->Memory().GetBaseAddress());
+        m_index = 0;
+      }
+    }
+
+    Context* m_ctx = nullptr;
+    Leaf* m_leaf = nullptr;
+    u32 m_index = 0;
+  };
+
+  /// Destruct the map
+  void Destruct(SharedMemory* mem) {
+    if (!m_root.IsNull()) DestructNode(mem, m_root, m_height);
+    m_root = Ptr<u8>();
+    m_height = 0;
+    m_size = 0;
+  }
+
+  /// Get the number of elements
+  u64 Size() const { return m_size; }
+
+  /// Check if map is empty
+  bool Empty() const { return m_size == 0; }
+
+  /// Height of the tree (0 if the root is a leaf)
+  u32 Height() const { return m_height; }
+
+  /// Remove all elements and release the memory
+  void Clear(Context* ctx) { Destruct(&ctx->Memory()); }
+
+  /// Insert the element with key `k` and value `v` or update the value if `k` already exists - returns true if `k` was inserted
+  bool Insert(Context* ctx, const KeyT& k, const ValueT& v) {
+    if (m_root.IsNull()) m_root = New<Leaf>(ctx).template Cast<u8>();
+
+    Split split;
+    bool inserted = InsertImpl(ctx, m_root, m_height, k, v, split);
+
+    // Grow the tree
+    if (!split.Right.IsNull()) {
+      Ptr<Inner> root = New<Inner>(ctx);
+      Inner* rootP = Resolve(ctx, root);
+      rootP->Size = 1;
+      rootP->Keys[0] = split.Key;
+      rootP->Children[0] = m_root;
+      rootP->Children[1] = split.Right;
+      m_root = root.template Cast<u8>();
+      ++m_height;
+    }
+
+    if (inserted) ++m_size;
+    return inserted;
+  }
+
+  /// Get the value of element with key `k` or NULL if no such key exists
+  ValueT* Find(Context* ctx, const KeyT& k) const {
+    if (m_root.IsNull()) return nullptr;
+
+    Leaf* leaf = FindLeaf(ctx, k);
+    u32 idx = LowerBoundIndex(leaf->Keys, leaf->Size, k);
+    if (idx < leaf->Size && !CompareT{}(k, leaf->Keys[idx])) return &leaf->Values[idx];
+    return nullptr;
+  }
+
+  /// Get a cursor to the first element whose key is not less than `k`
+  Cursor LowerBound(Context* ctx, const KeyT& k) const {
+    if (m_root.IsNull()) return Cursor();
+
+    Leaf* leaf = FindLeaf(ctx, k);
+    return Cursor(ctx, leaf, LowerBoundIndex(leaf->Keys, leaf->Size, k));
+  }
+
+  /// Get a cursor to the first element
+  Cursor Begin(Context* ctx) const {
+    if (m_root.IsNull()) return Cursor();
+
+    Ptr<u8> node = m_root;
+    for (u32 level = m_height; level > 0; --level) node = Resolve(ctx, node.template Cast<Inner>())->Children[0];
+    return Cursor(ctx, Resolve(ctx, node.template Cast<Leaf>()), 0);
+  }
+
+  /// Iterate the elements with keys in [`first`, `last`) in ascending order
+  ///
+  /// Return `false` to stop iteration, `true` to continue
+  template <class FunctorT>
+  void ForEachRange(Context* ctx, const KeyT& first, const KeyT& last, FunctorT&& functor) const {
+    for (Cursor cursor = LowerBound(ctx, first); cursor.IsValid() && CompareT{}(cursor.Key(), last); cursor.Next()) {
+      if (!functor(cursor.Key(), cursor.Value())) break;
+    }
+  }
+
+  /// Remove the element with key `k` - returns true if the key existed
+  bool Remove(Context* ctx, const KeyT& k) {
+    if (m_root.IsNull()) return false;
+
+    Leaf* leaf = FindLeaf(ctx, k);
+    u32 idx = LowerBoundIndex(leaf->Keys, leaf->Size, k);
+    if (idx >= leaf->Size || CompareT{}(k, leaf->Keys[idx])) return false;
+
+    std::memmove(&leaf->Keys[idx], &leaf->Keys[idx + 1], sizeof(KeyT) * (leaf->Size - idx - 1));
+    std::memmove(&leaf->Values[idx], &leaf->Values[idx + 1], sizeof(ValueT) * (leaf->Size - idx - 1));
+    --leaf->Size;
+    --m_size;
+    return true;
+  }
+
+  /// Build the map from `count` elements sorted by strictly increasing keys (the map has to be empty)
+  void BulkLoad(Context* ctx, const KeyT* keys, const ValueT* values, u64 count) {
+    if (!Empty()) throw std::runtime_error("SMOrderedMap::BulkLoad requires an empty map");
+    Destruct(&ctx->Memory());
+    if (count == 0) return;
+
+    // Minimum key and pointer of each node of the current level
+    std::vector<KeyT> minKeys;
+    std::vector<Ptr<u8>> nodes;
+
+    // Leaves - distribute the elements evenly
+    u64 numLeaves = (count + Fanout - 1) / Fanout;
+    Leaf* prevLeaf = nullptr;
+    for (u64 i = 0, offset = 0; i < numLeaves; ++i) {
+      u32 n = (u32)(count / numLeaves + (i < count % numLeaves ? 1 : 0));
+
+      Ptr<Leaf> leaf = New<Leaf>(ctx);
+      Leaf* leafP = Resolve(ctx, leaf);
+      leafP->Size = n;
+      std::memcpy(leafP->Keys, keys + offset, sizeof(KeyT) * n);
+      std::memcpy(leafP->Values, values + offset, sizeof(ValueT) * n);
+      if (prevLeaf) prevLeaf->Next = leaf;
+      prevLeaf = leafP;
+
+      minKeys.emplace_back(keys[offset]);
+      nodes.emplace_back(leaf.template Cast<u8>());
+      offset += n;
+    }
+
+    // Inner levels - distribute the children evenly
+    u32 height = 0;
+    while (nodes.size() > 1) {
+      std::vector<KeyT> parentMinKeys;
+      std::vector<Ptr<u8>> parents;
+
+      u64 numParents = (nodes.size() + Fanout - 1) / Fanout;
+      for (u64 i = 0, offset = 0; i < numParents; ++i) {
+        u32 n = (u32)(nodes.size() / numParents + (i < nodes.size() % numParents ? 1 : 0));
+
+        Ptr<Inner> inner = New<Inner>(ctx);
+        Inner* innerP = Resolve(ctx, inner);
+        innerP->Size = n - 1;
+        for (u32 c = 0; c < n; ++c) {
+          innerP->Children[c] = nodes[offset + c];
+          if (c > 0) innerP->Keys[c - 1] = minKeys[offset + c];
+        }
+
+        parentMinKeys.emplace_back(minKeys[offset]);
+        parents.emplace_back(inner.template Cast<u8>());
+        offset += n;
+      }
+
+      minKeys = std::move(parentMinKeys);
+      nodes = std::move(parents);
+      ++height;
+    }
+
+    m_root = nodes[0];
+    m_height = height;
+    m_size = count;
+  }
+
+ private:
+  struct Split {
+    KeyT Key;
+    Ptr<u8> Right = Ptr<u8>();
+  };
+
+  /// Index of the first key not less than `k`
+  static u32 LowerBoundIndex(const KeyT* keys, u32 size, const KeyT& k) {
+    return (u32)(std::lower_bound(keys, keys + size, k, CompareT{}) - keys);
+  }
+
+  /// Index of the first key greater than `k` (i.e the child of an inner node containing `k`)
+  static u32 UpperBoundIndex(const KeyT* keys, u32 size, const KeyT& k) {
+    return (u32)(std::upper_bound(keys, keys + size, k, CompareT{}) - keys);
+  }
+
+  Leaf* FindLeaf(Context* ctx, const KeyT& k) const {
+    Ptr<u8> node = m_root;
+    for (u32 level = m_height; level > 0; --level) {
+      Inner* inner = Resolve(ctx, node.template Cast<Inner>());
+      node = inner->Children[UpperBoundIndex(inner->Keys, inner->Size, k)];
+    }
+    return Resolve(ctx, node.template Cast<Leaf>());
+  }
+
+  bool InsertImpl(Context* ctx, Ptr<u8> node, u32 level, const KeyT& k, const ValueT& v, Split& split) {
+    if (level == 0) return InsertLeaf(ctx, node.template Cast<Leaf>(), k, v, split);
+
+    Inner* inner = Resolve(ctx, node.template Cast<Inner>());
+    u32 idx = UpperBoundIndex(inner->Keys, inner->Size, k);
+
+    Split childSplit;
+    bool inserted = InsertImpl(ctx, inner->Children[idx], level - 1, k, v, childSplit);
+    if (childSplit.Right.IsNull()) return inserted;
+
+    // Insert the separator of the split child (`inner` may temporarily hold `Fanout` keys)
+    inner = Resolve(ctx, node.template Cast<Inner>());
+    std::memmove(&inner->Keys[idx + 1], &inner->Keys[idx], sizeof(KeyT) * (inner->Size - idx));
+    std::memmove(&inner->Children[idx + 2], &inner->Children[idx + 1], sizeof(Ptr<u8>) * (inner->Size - idx));
+    inner->Keys[idx] = childSplit.Key;
+    inner->Children[idx + 1] = childSplit.Right;
+    ++inner->Size;
+
+    if (inner->Size == Fanout) {
+      // Split - the middle key moves up
+      u32 mid = inner->Size / 2;
+      Ptr<Inner> right = New<Inner>(ctx);
+      Inner* rightP = Resolve(ctx, right);
+      inner = Resolve(ctx, node.template Cast<Inner>());
+
+      rightP->Size = inner->Size - mid - 1;
+      std::memcpy(rightP->Keys, &inner->Keys[mid + 1], sizeof(KeyT) * rightP->Size);
+      std::memcpy(rightP->Children, &inner->Children[mid + 1], sizeof(Ptr<u8>) * (rightP->Size + 1));
+
+      split.Key = inner->Keys[mid];
+      split.Right = right.template Cast<u8>();
+      inner->Size = mid;
+    }
+    return inserted;
+  }
+
+  bool InsertLeaf(Context* ctx, Ptr<Leaf> node, const KeyT& k, const ValueT& v, Split& split) {
+    Leaf* leaf = Resolve(ctx, node);
+    u32 idx = LowerBoundIndex(leaf->Keys, leaf->Size, k);
+
+    // Update
+    if (idx < leaf->Size && !CompareT{}(k, leaf->Keys[idx])) {
+      leaf->Values[idx] = v;
+      return false;
+    }
+
+    if (leaf->Size == Fanout) {
+      // Split the leaf in half and insert into the appropriate half
+      u32 mid = Fanout / 2;
+      Ptr<Leaf> right = New<Leaf>(ctx);
+      Leaf* rightP = Resolve(ctx, right);
+      leaf = Resolve(ctx, node);
+
+      rightP->Size = leaf->Size - mid;
+      std::memcpy(rightP->Keys, &leaf->Keys[mid], sizeof(KeyT) * rightP->Size);
+      std::memcpy(rightP->Values, &leaf->Values[mid], sizeof(ValueT) * rightP->Size);
+      rightP->Next = leaf->Next;
+      leaf->Next = right;
+      leaf->Size = mid;
+
+      split.Right = right.template Cast<u8>();
+      if (idx > mid) {
+        leaf = rightP;
+        idx -= mid;
+      }
+      InsertIntoLeaf(leaf, idx, k, v);
+      split.Key = rightP->Keys[0];
+    } else {
+      InsertIntoLeaf(leaf, idx, k, v);
+    }
+    return true;
+  }
+
+  static void InsertIntoLeaf(Leaf* leaf, u32 idx, const KeyT& k, const ValueT& v) {
+    std::memmove(&leaf->Keys[idx + 1], &leaf->Keys[idx], sizeof(KeyT) * (leaf->Size - idx));
+    std::memmove(&leaf->Values[idx + 1], &leaf->Values[idx], sizeof(ValueT) * (leaf->Size - idx));
+    leaf->Keys[idx] = k;
+    leaf->Values[idx] = v;
+    ++leaf->Size;
+  }
+
+  void DestructNode(SharedMemory* mem, Ptr<u8> node, u32 level) {
+    if (level == 0) {
+      Delete(mem, node.template Cast<Leaf>());
+    } else {
+      Inner* inner = Resolve(mem, node.template Cast<Inner>());
+      for (u32 i = 0; i <= inner->Size; ++i) DestructNode(mem, inner->Children[i], level - 1);
+      Delete(mem, node.template Cast<Inner>());
+    }
+  }
+
+ private:
+  Ptr<u8> m_root = Ptr<u8>();
+  u32 m_height = 0;
+  u64 m_size = 0;
+};
+
+}  // namespace bifrost
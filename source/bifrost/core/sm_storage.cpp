@@ -11,6 +11,8 @@
 
 #include "bifrost/core/common.h"
 #include "bifrost/core/sm_storage.h"
+#include "bifrost/core/event.h"
+#include "bifrost/core/shared_memory.h"
 #include "bifrost/core/util.h"
 
 namespace bifrost {
@@ -25,12 +27,37 @@ static const char* TypeToString(SMStorageValue::EType type) {
       return "double";
     case SMStorageValue::E_String:
       return "string";
+    case SMStorageValue::E_Blob:
+      return "blob";
+    case SMStorageValue::E_FloatArray:
+      return "float array";
+    case SMStorageValue::E_DoubleArray:
+      return "double array";
+    case SMStorageValue::E_Int32Array:
+      return "int32 array";
+    case SMStorageValue::E_Int64Array:
+      return "int64 array";
     case SMStorageValue::E_Unknown:
     default:
       return "unknown";
   }
 }
 
+Ptr<SMStorageBuffer> SMStorageBuffer::Create(SharedMemory* mem, u32 elementSize, const void* data, u64 sizeInBytes) {
+  auto buffer = static_cast<SMStorageBuffer*>(mem->Allocate(sizeof(SMStorageBuffer) + sizeInBytes));
+  if (!buffer) throw std::bad_alloc();
+
+  ::new (&buffer->RefCount) std::atomic<u32>(1);
+  buffer->ElementSize = elementSize;
+  buffer->SizeInBytes = sizeInBytes;
+  if (sizeInBytes > 0) std::memcpy(buffer->Data(), data, sizeInBytes);
+  return Ptr<SMStorageBuffer>(mem->Offset(buffer));
+}
+
+void SMStorageBuffer::Release(SharedMemory* mem) noexcept {
+  if (RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) mem->Deallocate(this);
+}
+
 SMStorageValue::SMStorageValue() : m_type(E_Unknown), m_value() {}
 
 SMStorageValue::SMStorageValue(Context* ctx, bool v) : m_type(E_Bool) { m_value.Bool = v; }
@@ -41,8 +68,11 @@ SMStorageValue::SMStorageValue(Context* ctx, double v) : m_type(E_Double) { m_va
 
 SMStorageValue::SMStorageValue(Context* ctx, SMString v) : m_type(E_String) { m_value.String = std::move(v); }
 
+SMStorageValue::SMStorageValue(Context* ctx, EType type, Ptr<SMStorageBuffer> v) : m_type(type) { m_value.Buffer = v; }
+
 void SMStorageValue::Move(SMStorageValue&& s) {
   m_type = s.m_type;
+  m_version = s.m_version;
   switch (m_type) {
     case SMStorageValue::E_Bool:
       m_value.Bool = s.m_value.Bool;
@@ -56,6 +86,16 @@ void SMStorageValue::Move(SMStorageValue&& s) {
     case SMStorageValue::E_String:
       m_value.String = std::move(s.m_value.String);
       break;
+    case SMStorageValue::E_Blob:
+    case SMStorageValue::E_FloatArray:
+    case SMStorageValue::E_DoubleArray:
+    case SMStorageValue::E_Int32Array:
+    case SMStorageValue::E_Int64Array:
+      // The reference to the buffer is transferred
+      m_value.Buffer = s.m_value.Buffer;
+      s.m_value.Buffer = Ptr<SMStorageBuffer>();
+      s.m_type = E_Unknown;
+      break;
     case SMStorageValue::E_Unknown:
     default:
       break;
@@ -72,9 +112,20 @@ SMStorageValue& SMStorageValue::operator=(SMStorageValue&& s) {
 void SMStorageValue::Destruct(SharedMemory* mem) {
   if (m_type == E_String) {
     m_value.String.Destruct(mem);
+  } else if (IsBuffer() && !m_value.Buffer.IsNull()) {
+    Resolve(mem, m_value.Buffer)->Release(mem);
+    m_value.Buffer = Ptr<SMStorageBuffer>();
   }
 }
 
+SMStorageView SMStorageValue::AsView(Context* ctx, EType type) const {
+  if (!IsBuffer() || (type != E_Blob && type != m_type)) FailConversion(ctx, TypeToString(type));
+
+  SMStorageBuffer* buffer = Resolve(ctx, m_value.Buffer);
+  buffer->Acquire();
+  return SMStorageView(&ctx->Memory(), buffer);
+}
+
 std::string_view SMStorageValue::AsStringView(Context* ctx) const {
   if (m_type == E_String) {
     return m_value.String.AsView(ctx);
@@ -163,35 +214,55 @@ double SMStorageValue::AsDouble(Context* ctx) const {
 }
 
 [[noreturn]] void SMStorageValue::FailConversion(Context* ctx, const char* to) const {
+  if (IsBuffer()) {
+    throw std::domain_error(StringFormat("cannot convert value of type '%s' (%llu bytes) to '%s'", TypeToString(m_type),
+                                         Resolve(ctx, m_value.Buffer)->SizeInBytes, to));
+  }
   throw std::domain_error(StringFormat("cannot convert value \"%s\" of type '%s' to '%s'", AsString(ctx).c_str(), TypeToString(m_type), to));
 }
 
 void SMStorage::Destruct(SharedMemory* mem) { m_map.Destruct(mem); }
 
-void SMStorage::InsertBool(Context* ctx, std::string_view key, bool value) {
-  BIFROST_LOCK_GUARD(m_mutex);
-  m_keyBuffer.Assign(ctx, key);
-  m_map.Insert(ctx, m_keyBuffer, {ctx, value});
-}
+void SMStorage::InsertBool(Context* ctx, std::string_view key, bool value) { InsertValue(ctx, key, {ctx, value}); }
 
-void SMStorage::InsertInt(Context* ctx, std::string_view key, int value) {
-  BIFROST_LOCK_GUARD(m_mutex);
-  m_keyBuffer.Assign(ctx, key);
-  m_map.Insert(ctx, m_keyBuffer, {ctx, value});
+void SMStorage::InsertInt(Context* ctx, std::string_view key, int value) { InsertValue(ctx, key, {ctx, value}); }
+
+void SMStorage::InsertDouble(Context* ctx, std::string_view key, double value) { InsertValue(ctx, key, {ctx, value}); }
+
+void SMStorage::InsertString(Context* ctx, std::string_view key, std::string_view value) { InsertString(ctx, key, {ctx, value}); }
+
+void SMStorage::InsertString(Context* ctx, std::string_view key, SMString value) { InsertValue(ctx, key, {ctx, std::move(value)}); }
+
+void SMStorage::InsertBlob(Context* ctx, std::string_view key, const void* data, u64 sizeInBytes) {
+  InsertBuffer(ctx, key, SMStorageValue::E_Blob, 1, data, sizeInBytes);
 }
 
-void SMStorage::InsertDouble(Context* ctx, std::string_view key, double value) {
-  BIFROST_LOCK_GUARD(m_mutex);
-  m_keyBuffer.Assign(ctx, key);
-  m_map.Insert(ctx, m_keyBuffer, {ctx, value});
+void SMStorage::InsertBuffer(Context* ctx, std::string_view key, SMStorageValue::EType type, u32 elementSize, const void* data,
+                             u64 sizeInBytes) {
+  // Copy the data outside of the lock
+  Ptr<SMStorageBuffer> buffer = SMStorageBuffer::Create(&ctx->Memory(), elementSize, data, sizeInBytes);
+  InsertValue(ctx, key, {ctx, type, buffer});
 }
 
-void SMStorage::InsertString(Context* ctx, std::string_view key, std::string_view value) { InsertString(ctx, key, {ctx, value}); }
+void SMStorage::InsertValue(Context* ctx, std::string_view key, SMStorageValue value) {
+  {
+    BIFROST_LOCK_GUARD(m_mutex);
+    m_keyBuffer.Assign(ctx, key);
 
-void SMStorage::InsertString(Context* ctx, std::string_view key, SMString value) {
-  BIFROST_LOCK_GUARD(m_mutex);
-  m_keyBuffer.Assign(ctx, key);
-  m_map.Insert(ctx, m_keyBuffer, {ctx, std::move(value)});
+    // Release the old value first (views of an old blob keep their own reference)
+    m_map.Remove(ctx, m_keyBuffer);
+    value.SetVersion(++m_version);
+
+    // Insert an empty value and move the value in once the node exists - if growing the map fails, the value (e.g a freshly copied
+    // buffer) is still ours to release
+    try {
+      m_map.Insert(ctx, m_keyBuffer, SMStorageValue())->Value = std::move(value);
+    } catch (...) {
+      value.Destruct(&ctx->Memory());
+      throw;
+    }
+  }
+  NotifyWatchers(ctx);
 }
 
 bool SMStorage::GetBool(Context* ctx, std::string_view key) {
@@ -294,6 +365,26 @@ std::string_view SMStorage::GetStringView(Context* ctx, std::string_view key) {
   __assume(0);
 }
 
+SMStorageView SMStorage::GetBlob(Context* ctx, std::string_view key) { return GetBuffer(ctx, key, SMStorageValue::E_Blob); }
+
+SMStorageView SMStorage::GetBuffer(Context* ctx, std::string_view key, SMStorageValue::EType type) {
+  // The reference has to be acquired under the lock as the value may be overwritten concurrently
+  BIFROST_LOCK_GUARD(m_mutex);
+  m_keyBuffer.Assign(ctx, key);
+  const SMStorageValue* value = m_map.Get(ctx, m_keyBuffer);
+
+  if (!value) {
+    throw std::runtime_error(StringFormat("Key \"%s\" does not exist", key.data()).c_str());
+  }
+
+  try {
+    return value->AsView(ctx, type);
+  } catch (std::domain_error& e) {
+    throw std::runtime_error(StringFormat("Failed to convert value of key \"%s\": %s", key.data(), e.what()).c_str());
+  }
+  __assume(0);
+}
+
 bool SMStorage::Contains(Context* ctx, std::string_view key) {
   BIFROST_LOCK_GUARD(m_mutex);
   m_keyBuffer.Assign(ctx, key);
@@ -301,9 +392,112 @@ bool SMStorage::Contains(Context* ctx, std::string_view key) {
 }
 
 bool SMStorage::Remove(Context* ctx, std::string_view key) {
+  bool removed = false;
+  {
+    BIFROST_LOCK_GUARD(m_mutex);
+    m_keyBuffer.Assign(ctx, key);
+    removed = m_map.Remove(ctx, m_keyBuffer);
+  }
+  if (removed) NotifyWatchers(ctx);
+  return removed;
+}
+
+u64 SMStorage::GetVersion(Context* ctx, std::string_view key) {
   BIFROST_LOCK_GUARD(m_mutex);
   m_keyBuffer.Assign(ctx, key);
-  return m_map.Remove(ctx, m_keyBuffer);
+  const SMStorageValue* value = m_map.Get(ctx, m_keyBuffer);
+  return value ? value->GetVersion() : 0;
+}
+
+u64 SMStorage::Watch(Context* ctx, std::string_view key, u64 lastVersion, u32 timeoutInMs) {
+  auto start = std::chrono::steady_clock::now();
+  auto remainingInMs = [&]() -> u32 {
+    if (timeoutInMs == Infinite) return Event::Infinite;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    return (u32)std::max<i64>(0, (i64)timeoutInMs - elapsed);
+  };
+
+  u32 slot = InvalidSlot;
+  bool reclaimed = false;
+  while (true) {
+    // Claim the slot while holding the lock of the storage before checking the version, a concurrent change then signals our event
+    {
+      BIFROST_LOCK_GUARD(m_mutex);
+      if (slot == InvalidSlot) slot = ClaimWatcherSlot();
+
+      m_keyBuffer.Assign(ctx, key);
+      const SMStorageValue* value = m_map.Get(ctx, m_keyBuffer);
+      u64 version = value ? value->GetVersion() : 0;
+      if (version != lastVersion || remainingInMs() == 0) {
+        if (slot != InvalidSlot) m_watchers &= ~(1ull << slot);
+        return version;
+      }
+    }
+
+    if (slot != InvalidSlot) {
+      // Any key change wakes up all watchers, watchers of other keys simply wait again
+      ctx->Memory().GetStorageWatcherEvent(slot).Wait(remainingInMs());
+    } else if (!reclaimed) {
+      reclaimed = true;
+      ReclaimWatcherSlots();
+    } else {
+      // More than `MaxWatchers` watchers, fall back to checking periodically
+      ::Sleep(std::min<u32>(remainingInMs(), FallbackIntervalInMs));
+    }
+  }
+}
+
+u32 SMStorage::ClaimWatcherSlot() {
+  for (u32 slot = 0; slot < MaxWatchers; ++slot) {
+    if ((m_watchers & (1ull << slot)) == 0) {
+      m_watchers |= 1ull << slot;
+      m_watcherPids[slot] = ::GetCurrentProcessId();
+      return slot;
+    }
+  }
+  return InvalidSlot;
+}
+
+void SMStorage::ReclaimWatcherSlots() {
+  // Watchers of processes which died while waiting never release their slot - check the processes outside of the lock
+  u64 watchers = 0;
+  std::array<u32, MaxWatchers> pids;
+  {
+    BIFROST_LOCK_GUARD(m_mutex);
+    watchers = m_watchers;
+    std::copy(std::begin(m_watcherPids), std::end(m_watcherPids), pids.begin());
+  }
+
+  u64 dead = 0;
+  for (u32 slot = 0; slot < MaxWatchers; ++slot) {
+    if ((watchers & (1ull << slot)) == 0) continue;
+
+    HANDLE process = ::OpenProcess(SYNCHRONIZE, FALSE, pids[slot]);
+    if (process == NULL) {
+      if (::GetLastError() == ERROR_INVALID_PARAMETER) dead |= 1ull << slot;
+    } else {
+      if (::WaitForSingleObject(process, 0) == WAIT_OBJECT_0) dead |= 1ull << slot;
+      ::CloseHandle(process);
+    }
+  }
+
+  BIFROST_LOCK_GUARD(m_mutex);
+  for (u32 slot = 0; slot < MaxWatchers; ++slot) {
+    if ((dead & (1ull << slot)) != 0 && m_watcherPids[slot] == pids[slot]) m_watchers &= ~(1ull << slot);
+  }
+}
+
+void SMStorage::NotifyWatchers(Context* ctx) {
+  u64 watchers = 0;
+  {
+    BIFROST_LOCK_GUARD(m_mutex);
+    watchers = m_watchers;
+  }
+
+  // The events are auto-reset, a watcher which is about to wait still sees the signal
+  for (u32 slot = 0; slot < MaxWatchers; ++slot) {
+    if ((watchers & (1ull << slot)) != 0) ctx->Memory().GetStorageWatcherEvent(slot).Signal();
+  }
 }
 
 bifrost::u32 SMStorage::Size() {
@@ -312,8 +506,12 @@ bifrost::u32 SMStorage::Size() {
 }
 
 void SMStorage::Clear(Context* ctx) {
-  m_map.Clear(ctx);
-  m_keyBuffer.Clear(ctx);
+  {
+    BIFROST_LOCK_GUARD(m_mutex);
+    m_map.Clear(ctx);
+    m_keyBuffer.Clear(ctx);
+  }
+  NotifyWatchers(ctx);
 }
 
 }  // namespace bifrost
\ No newline at end of file
@@ -17,6 +17,87 @@
 
 namespace bifrost {
 
+/// Reference counted buffer of a blob or typed-array value (the data follows the header)
+struct SMStorageBuffer {
+  std::atomic<u32> RefCount;
+  u32 ElementSize;
+  u64 SizeInBytes;
+
+  /// Get the data of the buffer
+  u8* Data() noexcept { return reinterpret_cast<u8*>(this + 1); }
+  const u8* Data() const noexcept { return reinterpret_cast<const u8*>(this + 1); }
+
+  /// Allocate a buffer of `sizeInBytes` bytes and copy `data` into it (the buffer holds one reference)
+  static Ptr<SMStorageBuffer> Create(SharedMemory* mem, u32 elementSize, const void* data, u64 sizeInBytes);
+
+  /// Acquire a reference to the buffer
+  void Acquire() noexcept { RefCount.fetch_add(1, std::memory_order_relaxed); }
+
+  /// Release a reference to the buffer and deallocate it if it was the last one
+  void Release(SharedMemory* mem) noexcept;
+};
+
+/// Zero-copy view of a blob or typed-array value - the view keeps the buffer alive even if the key is overwritten or removed
+class SMStorageView {
+ public:
+  SMStorageView() = default;
+  SMStorageView(SharedMemory* mem, SMStorageBuffer* buffer) : m_mem(mem), m_buffer(buffer) {}
+  SMStorageView(SMStorageView&& other) noexcept { *this = std::move(other); }
+  SMStorageView& operator=(SMStorageView&& other) noexcept {
+    Reset();
+    std::swap(m_mem, other.m_mem);
+    std::swap(m_buffer, other.m_buffer);
+    return *this;
+  }
+  SMStorageView(const SMStorageView&) = delete;
+  SMStorageView& operator=(const SMStorageView&) = delete;
+  ~SMStorageView() { Reset(); }
+
+  /// Get the data in shared memory
+  const void* Data() const noexcept { return m_buffer ? m_buffer->Data() : nullptr; }
+
+  /// Get the size in bytes
+  u64 SizeInBytes() const noexcept { return m_buffer ? m_buffer->SizeInBytes : 0; }
+
+  /// Check if the view references a buffer
+  bool IsValid() const noexcept { return m_buffer != nullptr; }
+
+  /// Release the reference to the buffer
+  void Reset() noexcept {
+    if (m_buffer) m_buffer->Release(m_mem);
+    m_mem = nullptr;
+    m_buffer = nullptr;
+  }
+
+ private:
+  SharedMemory* m_mem = nullptr;
+  SMStorageBuffer* m_buffer = nullptr;
+};
+
+/// Zero-copy view of a typed-array value
+template <class T>
+class SMStorageArrayView {
+ public:
+  SMStorageArrayView() = default;
+  explicit SMStorageArrayView(SMStorageView view) : m_view(std::move(view)) {}
+
+  /// Get the elements
+  const T* Data() const noexcept { return static_cast<const T*>(m_view.Data()); }
+
+  /// Get the number of elements
+  u64 Size() const noexcept { return m_view.SizeInBytes() / sizeof(T); }
+
+  const T& operator[](u64 i) const noexcept { return Data()[i]; }
+  const T* begin() const noexcept { return Data(); }
+  const T* end() const noexcept { return Data() + Size(); }
+
+  /// Get the underlying untyped view
+  const SMStorageView& GetView() const noexcept { return m_view; }
+
+ private:
+  SMStorageView m_view;
+};
+
 /// Shared storage value
 class SMStorageValue : public SMObject {
  public:
@@ -26,8 +107,30 @@ class SMStorageValue : public SMObject {
     E_Int,
     E_Double,
     E_String,
+    E_Blob,
+    E_FloatArray,
+    E_DoubleArray,
+    E_Int32Array,
+    E_Int64Array,
   };
 
+  /// Get the type of a typed-array value with elements of type `T`
+  template <class T>
+  static constexpr EType ArrayType() noexcept {
+    if constexpr (std::is_same<T, float>::value) {
+      return E_FloatArray;
+    } else if constexpr (std::is_same<T, double>::value) {
+      return E_DoubleArray;
+    } else if constexpr (std::is_same<T, i32>::value) {
+      return E_Int32Array;
+    } else if constexpr (std::is_same<T, i64>::value) {
+      return E_Int64Array;
+    } else {
+      static_assert(std::is_void<T>::value, "unsupported array element type");
+      return E_Unknown;
+    }
+  }
+
   SMStorageValue();
   SMStorageValue(SMStorageValue&&);
   SMStorageValue& operator=(SMStorageValue&&);
@@ -36,6 +139,7 @@ class SMStorageValue : public SMObject {
   SMStorageValue(Context* ctx, int v);
   SMStorageValue(Context* ctx, double v);
   SMStorageValue(Context* ctx, SMString v);
+  SMStorageValue(Context* ctx, EType type, Ptr<SMStorageBuffer> v);
 
   /// Destruct the value
   void Destruct(SharedMemory* mem);
@@ -47,21 +151,33 @@ class SMStorageValue : public SMObject {
   int AsInt(Context* ctx) const;
   double AsDouble(Context* ctx) const;
 
+  /// Acquire a view of the buffer of a blob or typed-array value (`type` is E_Blob to accept any buffer)
+  SMStorageView AsView(Context* ctx, EType type) const;
+
+  /// Check if the value is a blob or typed-array
+  bool IsBuffer() const noexcept { return m_type >= E_Blob; }
+
   /// Get the type
   EType Type() const noexcept { return m_type; }
 
+  /// Get/Set the version of the storage at which the value was inserted
+  u64 GetVersion() const noexcept { return m_version; }
+  void SetVersion(u64 version) noexcept { m_version = version; }
+
  private:
   void FailConversion(Context* ctx, const char* to) const;
   void Move(SMStorageValue&& s);
 
  private:
   EType m_type;
+  u64 m_version = 0;
 
   union Value {
     bool Bool;
     int Int;
     double Double;
     SMString String;
+    Ptr<SMStorageBuffer> Buffer;
 
     Value() : String() {}
   } m_value;
@@ -70,6 +186,12 @@ class SMStorageValue : public SMObject {
 /// Key/value storage - unique per shared memory region (allocated in SMContext)
 class SMStorage : public SMObject {
  public:
+  /// Maximum number of watchers which wait on an event (see `Watch`)
+  static constexpr u32 MaxWatchers = 64;
+
+  /// Wait forever in `Watch`
+  static constexpr u32 Infinite = 0xFFFFFFFF;
+
   /// Deallocate the map
   void Destruct(SharedMemory* mem);
 
@@ -79,6 +201,13 @@ class SMStorage : public SMObject {
   void InsertDouble(Context* ctx, std::string_view key, double value);
   void InsertString(Context* ctx, std::string_view key, std::string_view value);
   void InsertString(Context* ctx, std::string_view key, SMString value);
+  void InsertBlob(Context* ctx, std::string_view key, const void* data, u64 sizeInBytes);
+
+  /// Insert a typed-array value of `count` elements (`T` is one of float, double, i32 or i64)
+  template <class T>
+  void InsertArray(Context* ctx, std::string_view key, const T* data, u64 count) {
+    InsertBuffer(ctx, key, SMStorageValue::ArrayType<T>(), sizeof(T), data, count * sizeof(T));
+  }
 
   /// Get the value or throw
   bool GetBool(Context* ctx, std::string_view key);
@@ -87,12 +216,30 @@ class SMStorage : public SMObject {
   std::string GetString(Context* ctx, std::string_view key);
   std::string_view GetStringView(Context* ctx, std::string_view key);
 
+  /// Get a zero-copy view of the raw bytes of a blob or typed-array value or throw
+  SMStorageView GetBlob(Context* ctx, std::string_view key);
+
+  /// Get a zero-copy view of a typed-array value or throw
+  template <class T>
+  SMStorageArrayView<T> GetArray(Context* ctx, std::string_view key) {
+    return SMStorageArrayView<T>(GetBuffer(ctx, key, SMStorageValue::ArrayType<T>()));
+  }
+
   /// Check if the key is available
   bool Contains(Context* ctx, std::string_view key);
 
   /// Remove the given key
   bool Remove(Context* ctx, std::string_view key);
 
+  /// Get the version of the key or 0 if the key does not exist (the version increases every time the key is inserted)
+  u64 GetVersion(Context* ctx, std::string_view key);
+
+  /// Block until the version of the key differs from `lastVersion` or `timeoutInMs` elapsed - returns the current version of the key
+  ///
+  /// Every watcher claims one of `MaxWatchers` slots, each slot has its own named event which is signaled when any key changes, hence
+  /// watchers of all processes sharing the memory are woken up (watchers beyond `MaxWatchers` check the key periodically).
+  u64 Watch(Context* ctx, std::string_view key, u64 lastVersion, u32 timeoutInMs = Infinite);
+
   /// Get the number of items in the shared storage
   u32 Size();
 
@@ -100,7 +247,27 @@ class SMStorage : public SMObject {
   void Clear(Context* ctx);
 
  private:
+  void InsertValue(Context* ctx, std::string_view key, SMStorageValue value);
+  void InsertBuffer(Context* ctx, std::string_view key, SMStorageValue::EType type, u32 elementSize, const void* data, u64 sizeInBytes);
+  SMStorageView GetBuffer(Context* ctx, std::string_view key, SMStorageValue::EType type);
+  void NotifyWatchers(Context* ctx);
+
+  /// Claim a free watcher slot - returns `InvalidSlot` if all slots are taken (requires the lock)
+  u32 ClaimWatcherSlot();
+
+  /// Release the slots of watchers whose process exited
+  void ReclaimWatcherSlots();
+
+ private:
+  static constexpr u32 InvalidSlot = 0xFFFFFFFF;
+
+  /// Interval in which watchers without a slot check the key
+  static constexpr u32 FallbackIntervalInMs = 10;
+
   SpinMutex m_mutex;
+  u64 m_version = 0;
+  u64 m_watchers = 0;  ///< Bit mask of the claimed watcher slots
+  u32 m_watcherPids[MaxWatchers] = {};
   SMString m_keyBuffer;
   SMHashMap<SMString, SMStorageValue> m_map;
 };
@@ -19,14 +19,23 @@
 namespace bifrost {
 
 /// Shared memory string
+///
+/// Strings of up to `InlineCapacity` characters are stored inside the object itself and never touch the shared heap. Longer strings are allocated in shared
+/// memory and grow geometrically.
 class SMString : public SMObject {
  public:
-  SMString() : m_size(0), m_data() {}
+  /// Maximum number of characters which can be stored without allocating shared memory
+  static constexpr u32 InlineCapacity = 22;
 
-  SMString(Context* ctx, u32 initialSize = 0) : m_size(0) { Allocate(ctx, initialSize); }
+  SMString() : m_size(0), m_capacity(InlineCapacity) {}
+
+  SMString(Context* ctx, u32 initialSize = 0) : SMString() {
+    Reserve(ctx, initialSize);
+    m_size = initialSize;
+  }
   SMString(Context* ctx, const std::string& s) : SMString(ctx, std::string_view{s}) {}
   SMString(Context* ctx, const char* s) : SMString(ctx, std::string_view{s}) {}
-  SMString(Context* ctx, std::string_view s) : m_size(0) { Assign(ctx, s); }
+  SMString(Context* ctx, std::string_view s) : SMString() { Assign(ctx, s); }
 
   /// Destructor
   void Destruct(SharedMemory* mem) { Deallocate(mem); }
@@ -41,67 +50,109 @@ class SMString : public SMObject {
   /// Get a view of the data
   std::string_view AsView(Context* ctx) const {
     if (m_size == 0) return std::string_view{};
-
-    char* data = Resolve(ctx, m_data);
-    return std::string_view{data, m_size};
+    return std::string_view{Data(ctx), m_size};
   }
 
   /// Get a copy of the data
   std::string AsString(Context* ctx) const {
     if (m_size == 0) return std::string{};
-
-    char* data = Resolve(ctx, m_data);
-    return std::string{data, m_size};
+    return std::string{Data(ctx), m_size};
   }
 
   /// Length of the string
   u32 Size() const { return m_size; }
 
+  /// Number of characters which can be stored without reallocating
+  u32 Capacity() const { return m_capacity; }
+
+  /// Is the string stored inline (i.e not allocated in shared memory)?
+  bool IsInline() const { return m_capacity <= InlineCapacity; }
+
   /// Assign the string view
   void Assign(Context* ctx, std::string_view s) {
-    if (s.size() > m_size) {
-      Deallocate(&ctx->Memory());
-      Allocate(ctx, static_cast<u32>(s.size()));
+    if (s.size() > m_capacity) {
+      Reallocate(ctx, std::max(static_cast<u32>(s.size()), 2 * m_capacity), false);
     }
     Copy(ctx, s);
   }
   void Assign(Context* ctx, const SMString& s) { Assign(ctx, s.AsView(ctx)); }
 
+  /// Increase the capacity to at least `capacity` characters (the content is preserved)
+  void Reserve(Context* ctx, u32 capacity) {
+    if (capacity > m_capacity) Reallocate(ctx, capacity, true);
+  }
+
+  /// Release unused capacity - moves the string back inline if it fits
+  void ShrinkToFit(Context* ctx) {
+    if (IsInline() || m_capacity == m_size) return;
+
+    if (m_size <= InlineCapacity) {
+      Ptr<char> heap = m_storage.Heap;
+      char* data = Resolve(ctx, heap);
+      std::memcpy(m_storage.Inline, data, m_size);
+      DeleteArray(ctx, heap, m_capacity);
+      m_capacity = InlineCapacity;
+    } else {
+      Reallocate(ctx, m_size, true);
+    }
+  }
+
+  /// Clear the string and release the allocated memory
   void Clear(Context* ctx) { Deallocate(&ctx->Memory()); }
 
  private:
+  char* Data(Context* ctx) { return IsInline() ? m_storage.Inline : Resolve(ctx, m_storage.Heap); }
+  const char* Data(Context* ctx) const { return IsInline() ? m_storage.Inline : Resolve(ctx, m_storage.Heap); }
+
   void Move(SMString&& s) {
-    m_data = s.m_data;
+    std::memcpy(&m_storage, &s.m_storage, sizeof(Storage));
     m_size = s.m_size;
+    m_capacity = s.m_capacity;
     s.m_size = 0;
+    s.m_capacity = InlineCapacity;
   }
 
   void Copy(Context* ctx, std::string_view s) {
-    BIFROST_ASSERT(m_size >= s.size());
+    BIFROST_ASSERT(m_capacity >= s.size());
     if (s.size() > 0) {
-      char* data = Resolve(ctx, m_data);
-      std::memcpy(data, s.data(), s.size());
+      std::memcpy(Data(ctx), s.data(), s.size());
     }
     m_size = static_cast<u32>(s.size());
   }
 
   void Deallocate(SharedMemory* mem) {
-    if (m_size != 0) {
-      DeleteArray(mem, m_data, m_size);
-      m_size = 0;
+    if (!IsInline()) {
+      DeleteArray(mem, m_storage.Heap, m_capacity);
+      m_capacity = InlineCapacity;
     }
+    m_size = 0;
   }
 
-  void Allocate(Context* ctx, u32 size) {
-    if (size > 0) {
-      m_data = NewArray<char>(ctx, size);
+  void Reallocate(Context* ctx, u32 capacity, bool preserve) {
+    BIFROST_ASSERT(capacity > InlineCapacity);
+
+    Ptr<char> data = NewArray<char>(ctx, capacity);
+    if (preserve && m_size > 0) {
+      std::memcpy(Resolve(ctx, data), Data(ctx), m_size);
     }
+
+    u32 size = preserve ? m_size : 0;
+    Deallocate(&ctx->Memory());
+    m_storage.Heap = data;
+    m_capacity = capacity;
     m_size = size;
   }
 
  private:
-  Ptr<char> m_data;
+  union Storage {
+    Ptr<char> Heap;
+    char Inline[InlineCapacity];
+
+    Storage() : Inline() {}
+  } m_storage;
+
   u32 m_size;
+  u32 m_capacity;
 };
 
 template <>
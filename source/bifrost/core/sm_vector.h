@@ -0,0 +1,166 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/ptr.h"
+#include "bifrost/core/sm_new.h"
+
+namespace bifrost {
+
+/// Shared memory vector - contiguous growable array
+template <class ValueT>
+class SMVector : public SMObject {
+ public:
+  /// Create an empty vector
+  SMVector() = default;
+
+  /// Create an empty vector with given capacity
+  SMVector(Context* ctx, u64 capacity) { Reserve(ctx, capacity); }
+
+  /// Destruct the vector
+  void Destruct(SharedMemory* mem) {
+    DestructRange(mem, 0, m_size);
+    if (!m_data.IsNull()) mem->Deallocate(Resolve(mem, m_data));
+    m_data = Ptr<ValueT>();
+    m_size = 0;
+    m_capacity = 0;
+  }
+
+  /// Get the underlying array
+  ValueT* Data(Context* ctx) { return m_data.IsNull() ? nullptr : Resolve(ctx, m_data); }
+  const ValueT* Data(Context* ctx) const { return m_data.IsNull() ? nullptr : Resolve(ctx, m_data); }
+
+  /// Get the element at position `i`
+  ValueT& At(Context* ctx, u64 i) {
+    BIFROST_ASSERT(i < m_size && "Index out of bounds");
+    return Data(ctx)[i];
+  }
+  const ValueT& At(Context* ctx, u64 i) const {
+    BIFROST_ASSERT(i < m_size && "Index out of bounds");
+    return Data(ctx)[i];
+  }
+
+  /// Get the number of elements
+  u64 Size() const { return m_size; }
+
+  /// Get the number of elements which fit in the allocated storage
+  u64 Capacity() const { return m_capacity; }
+
+  /// Check if vector is empty
+  bool Empty() const { return m_size == 0; }
+
+  /// Increase the capacity to at least `capacity` elements
+  void Reserve(Context* ctx, u64 capacity) {
+    if (capacity > m_capacity) Reallocate(ctx, capacity);
+  }
+
+  /// Append `v` to the end of the vector
+  void PushBack(Context* ctx, ValueT v) {
+    if (m_size == m_capacity) Grow(ctx, m_size + 1);
+    ::new (Data(ctx) + m_size) ValueT(std::move(v));
+    ++m_size;
+  }
+
+  /// Construct a new element from `args` at the end of the vector
+  template <class... ArgsT>
+  ValueT& EmplaceBack(Context* ctx, ArgsT&&... args) {
+    if (m_size == m_capacity) {
+      // Construct before growing as `args` may reference elements of this vector
+      ValueT v(std::forward<ArgsT>(args)...);
+      Grow(ctx, m_size + 1);
+      ::new (Data(ctx) + m_size) ValueT(std::move(v));
+    } else {
+      ::new (Data(ctx) + m_size) ValueT(std::forward<ArgsT>(args)...);
+    }
+    return Data(ctx)[m_size++];
+  }
+
+  /// Append the `count` elements given by `values` (`values` may not point into this vector)
+  void Append(Context* ctx, const ValueT* values, u64 count) {
+    if (count == 0) return;
+    if (m_size + count > m_capacity) Grow(ctx, m_size + count);
+
+    ValueT* data = Data(ctx) + m_size;
+    if constexpr (std::is_trivially_copyable<ValueT>::value) {
+      std::memcpy(data, values, sizeof(ValueT) * count);
+    } else {
+      for (u64 i = 0; i < count; ++i) ::new (data + i) ValueT(values[i]);
+    }
+    m_size += count;
+  }
+
+  /// Remove the last element
+  void PopBack(Context* ctx) {
+    BIFROST_ASSERT(m_size > 0 && "PopBack on empty vector");
+    DestructRange(&ctx->Memory(), m_size - 1, m_size);
+    --m_size;
+  }
+
+  /// Resize the vector to contain `size` elements - new elements are default constructed
+  void Resize(Context* ctx, u64 size) {
+    if (size < m_size) {
+      DestructRange(&ctx->Memory(), size, m_size);
+    } else if (size > m_size) {
+      Reserve(ctx, size);
+      ValueT* data = Data(ctx);
+      for (u64 i = m_size; i < size; ++i) ::new (data + i) ValueT();
+    }
+    m_size = size;
+  }
+
+  /// Remove all elements and release the memory
+  void Clear(Context* ctx) { Destruct(&ctx->Memory()); }
+
+ private:
+  void DestructRange(SharedMemory* mem, u64 first, u64 last) {
+    if constexpr (!std::is_trivially_destructible<ValueT>::value || std::is_base_of<SMObject, ValueT>::value) {
+      ValueT* data = Resolve(mem, m_data);
+      for (u64 i = first; i < last; ++i) {
+        internal::Destruct(mem, data + i);
+        (data + i)->~ValueT();
+      }
+    }
+  }
+
+  void Grow(Context* ctx, u64 minCapacity) { Reallocate(ctx, std::max(minCapacity, std::max((u64)4, 2 * m_capacity))); }
+
+  void Reallocate(Context* ctx, u64 capacity) {
+    SharedMemory* mem = &ctx->Memory();
+    auto newData = static_cast<ValueT*>(mem->Allocate(sizeof(ValueT) * capacity));
+    if (!newData) throw std::bad_alloc();
+
+    // Relocate the elements (moved-from elements only need their C++ destructor)
+    if (!m_data.IsNull()) {
+      ValueT* oldData = Resolve(ctx, m_data);
+      if constexpr (std::is_trivially_copyable<ValueT>::value) {
+        std::memcpy(newData, oldData, sizeof(ValueT) * m_size);
+      } else {
+        for (u64 i = 0; i < m_size; ++i) {
+          ::new (newData + i) ValueT(std::move(oldData[i]));
+          (oldData + i)->~ValueT();
+        }
+      }
+      mem->Deallocate(oldData);
+    }
+
+    m_data = Ptr<ValueT>(mem->Offset(newData));
+    m_capacity = capacity;
+  }
+
+ private:
+  Ptr<ValueT> m_data = Ptr<ValueT>();
+  u64 m_size = 0;
+  u64 m_capacity = 0;
+};
+
+}  // namespace bifrost
@@ -0,0 +1,209 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/binary_log.h"
+#include "bifrost/core/sm_atom_table.h"
+#include "bifrost/core/sm_log_stash.h"
+#include "bifrost/core/timestamp.h"
+
+namespace {
+
+using namespace bifrost;
+
+class BinaryLogTest : public TestBaseSharedMemory {
+ public:
+  std::filesystem::path GetBasePath(const char* name) {
+    auto basePath = std::filesystem::temp_directory_path() / name;
+
+    // Start from scratch as writers continue the logs of previous runs
+    std::error_code ec;
+    for (const auto& entry : binary_log::ReadIndex(basePath)) std::filesystem::remove(binary_log::GetFilePath(basePath, entry.FileIndex), ec);
+    std::filesystem::remove(binary_log::GetIndexPath(basePath), ec);
+    return basePath;
+  }
+};
+
+TEST_F(BinaryLogTest, WriteAndRead) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+  auto basePath = GetBasePath("bifrost-binary-log-test");
+
+  u64 before = TimestampToUnixMicroseconds(GetTimestamp());
+  SMAtomTable* atoms = ctx->Memory().GetSMAtomTable();
+  stash->Push(ctx, (u32)ILogger::LogLevel::Info, atoms->Intern(ctx, "module1"), "msg1");
+  stash->Push(ctx, (u32)ILogger::LogLevel::Error, atoms->Intern(ctx, "module2"), "msg2");
+
+  DeferredArgs args;
+  args.Encode(42, "str");
+  u32 format = atoms->Intern(ctx, "value %i %s");
+  stash->PushDeferred(ctx, (u32)ILogger::LogLevel::Warn, atoms->Intern(ctx, "module1"), format, args.Data(), args.Size());
+
+  {
+    BinaryLogWriter writer(basePath);
+    EXPECT_EQ(3, stash->TryPopRaw(ctx, 10, [&](const SMLogStash::RawLogMessage& msg) { writer.Write(ctx, msg); }));
+  }
+  u64 after = TimestampToUnixMicroseconds(GetTimestamp());
+
+  auto index = binary_log::ReadIndex(basePath);
+  ASSERT_EQ(1, index.size());
+  EXPECT_EQ(3, index[0].NumMessages);
+
+  BinaryLogReader reader(binary_log::GetFilePath(basePath, 0));
+  BinaryLogReader::Message msg;
+
+  ASSERT_TRUE(reader.Next(msg));
+  EXPECT_EQ((u32)ILogger::LogLevel::Info, msg.Level);
+  EXPECT_EQ("module1", msg.Module);
+  EXPECT_EQ("msg1", msg.Text);
+  EXPECT_EQ(::GetCurrentThreadId(), msg.ThreadId);
+  EXPECT_LE(before, msg.Timestamp);
+  EXPECT_GE(after, msg.Timestamp);
+
+  ASSERT_TRUE(reader.Next(msg));
+  EXPECT_EQ("module2", msg.Module);
+  EXPECT_EQ("msg2", msg.Text);
+
+  // Deferred messages are formatted when reading
+  ASSERT_TRUE(reader.Next(msg));
+  EXPECT_EQ((u32)ILogger::LogLevel::Warn, msg.Level);
+  EXPECT_EQ("module1", msg.Module);
+  EXPECT_EQ("value 42 str", msg.Text);
+
+  EXPECT_FALSE(reader.Next(msg));
+}
+
+TEST_F(BinaryLogTest, Rotate) {
+  auto ctx = GetContext();
+  auto basePath = GetBasePath("bifrost-binary-log-rotate-test");
+
+  std::string text(8 * 1024, 'x');
+  SMLogStash::RawLogMessage rawMsg{(u32)ILogger::LogLevel::Info, 0, 0, ctx->Memory().GetSMAtomTable()->Intern(ctx, "module"), false, text.c_str(),
+                                   (u32)text.size()};
+
+  const u32 numMessages = 400;
+  {
+    BinaryLogWriter writer(basePath, BinaryLogWriter::MinFileSize, 2);
+    for (u32 i = 0; i < numMessages; ++i) {
+      rawMsg.Timestamp = GetTimestamp();
+      writer.Write(ctx, rawMsg);
+    }
+  }
+
+  // Only the last two files are kept and each can be decoded on its own
+  auto index = binary_log::ReadIndex(basePath);
+  ASSERT_EQ(2, index.size());
+  EXPECT_EQ(index[0].FileIndex + 1, index[1].FileIndex);
+  EXPECT_FALSE(std::filesystem::exists(binary_log::GetFilePath(basePath, 0)));
+
+  for (const auto& entry : index) {
+    BinaryLogReader reader(binary_log::GetFilePath(basePath, entry.FileIndex));
+    BinaryLogReader::Message msg;
+    u64 n = 0;
+    for (; reader.Next(msg); ++n) {
+      EXPECT_EQ("module", msg.Module);
+      EXPECT_EQ(text, msg.Text);
+    }
+    EXPECT_EQ(entry.NumMessages, n);
+    EXPECT_LE(entry.FirstTimestamp, entry.LastTimestamp);
+  }
+}
+
+TEST_F(BinaryLogTest, ContinueSession) {
+  auto ctx = GetContext();
+  auto basePath = GetBasePath("bifrost-binary-log-continue-test");
+
+  SMLogStash::RawLogMessage rawMsg{(u32)ILogger::LogLevel::Info, 0, 0, ctx->Memory().GetSMAtomTable()->Intern(ctx, "module"), false, "msg", 3};
+  {
+    BinaryLogWriter writer(basePath);
+    rawMsg.Timestamp = GetTimestamp();
+    writer.Write(ctx, rawMsg);
+
+    // Flushing publishes the size and timestamps of the active file
+    writer.Flush();
+    auto index = binary_log::ReadIndex(basePath);
+    ASSERT_EQ(1, index.size());
+    EXPECT_EQ(1, index[0].NumMessages);
+    EXPECT_LT(0, index[0].SizeInBytes);
+  }
+
+  // A second session appends a new file instead of overwriting the first one
+  {
+    BinaryLogWriter writer(basePath, BinaryLogWriter::DefaultMaxFileSize, 2);
+    EXPECT_EQ(binary_log::GetFilePath(basePath, 1), writer.GetPath());
+    rawMsg.Timestamp = GetTimestamp();
+    writer.Write(ctx, rawMsg);
+  }
+  {
+    BinaryLogWriter writer(basePath, BinaryLogWriter::DefaultMaxFileSize, 2);
+    EXPECT_EQ(binary_log::GetFilePath(basePath, 2), writer.GetPath());
+  }
+
+  auto index = binary_log::ReadIndex(basePath);
+  ASSERT_EQ(2, index.size());
+  EXPECT_EQ(1, index[0].FileIndex);
+  EXPECT_EQ(2, index[1].FileIndex);
+  EXPECT_FALSE(std::filesystem::exists(binary_log::GetFilePath(basePath, 0)));
+
+  BinaryLogReader reader(binary_log::GetFilePath(basePath, 1));
+  BinaryLogReader::Message msg;
+  ASSERT_TRUE(reader.Next(msg));
+  EXPECT_EQ("msg", msg.Text);
+  EXPECT_FALSE(reader.Next(msg));
+}
+
+TEST_F(BinaryLogTest, CorruptFrame) {
+  auto ctx = GetContext();
+  auto basePath = GetBasePath("bifrost-binary-log-corrupt-test");
+
+  SMLogStash::RawLogMessage rawMsg{(u32)ILogger::LogLevel::Info, 0, 0, ctx->Memory().GetSMAtomTable()->Intern(ctx, "module"), false, "msg", 3};
+  {
+    BinaryLogWriter writer(basePath);
+    writer.Write(ctx, rawMsg);
+    writer.Write(ctx, rawMsg);
+  }
+
+  // Make the length of the second message exceed its frame
+  auto path = binary_log::GetFilePath(basePath, 0);
+  std::string data;
+  {
+    std::ifstream ifs(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  }
+
+  binary_log::FileHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  u64 pos = header.HeaderSize;
+  u32 numMessages = 0;
+  while (pos < header.UsedBytes) {
+    binary_log::FrameHeader frame;
+    std::memcpy(&frame, data.data() + pos, sizeof(frame));
+    if (frame.Type == binary_log::MessageFrame && ++numMessages == 2) {
+      u32 length = 1 << 20;
+      std::memcpy(data.data() + pos + sizeof(frame) + offsetof(binary_log::MessageFrameData, Length), &length, sizeof(length));
+    }
+    pos += frame.Size;
+  }
+  ASSERT_EQ(2, numMessages);
+  {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(data.data(), data.size());
+  }
+
+  // Reading stops at the corrupt frame
+  BinaryLogReader reader(path);
+  BinaryLogReader::Message msg;
+  ASSERT_TRUE(reader.Next(msg));
+  EXPECT_EQ("msg", msg.Text);
+  EXPECT_FALSE(reader.Next(msg));
+}
+
+}  // namespace
@@ -0,0 +1,132 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/deferred_format.h"
+#include "bifrost/core/sm_atom_table.h"
+#include "bifrost/core/sm_log_stash.h"
+
+namespace {
+
+using namespace bifrost;
+
+class DeferredFormatTest : public TestBaseSharedMemory {
+ public:
+  template <class... Args>
+  std::string Format(const char* fmt, Args&&... args) {
+    DeferredArgs encodedArgs;
+    encodedArgs.Encode(std::forward<Args>(args)...);
+    return FormatDeferred(fmt, encodedArgs.Data(), encodedArgs.Size());
+  }
+};
+
+class MessageLogger : public ILogger {
+ public:
+  std::string Message;
+
+  virtual void SetModule(const char* module) override {}
+  virtual void Sink(LogLevel level, const char* module, const char* msg) override { Message = msg; }
+  virtual void Sink(LogLevel level, const char* msg) override { Message = msg; }
+};
+
+TEST_F(DeferredFormatTest, Format) {
+  EXPECT_EQ("no arguments", Format("no arguments"));
+  EXPECT_EQ("100%", Format("%i%%", 100));
+  EXPECT_EQ("-1 4294967295 ff", Format("%d %u %x", -1, 0xFFFFFFFFu, 255));
+  EXPECT_EQ("-5 18446744073709551615", Format("%lld %llu", -5ll, ~0ull));
+  EXPECT_EQ("  42|42   |0042", Format("%4d|%-5i|%04u", 42, 42, 42u));
+  EXPECT_EQ("3.14 2.500000e+00", Format("%.2f %e", 3.14159, 2.5f));
+  EXPECT_EQ("c true", Format("%c %s", 'c', "true"));
+  EXPECT_EQ("[str   ] std::string view", Format("[%-6s] %s %s", "str", std::string("std::string"), std::string_view("view")));
+  EXPECT_EQ("(null)", Format("%s", (const char*)nullptr));
+  EXPECT_EQ(StringFormat("%p", (void*)0x1234), Format("%p", (void*)0x1234));
+
+  // Width and precision passed as arguments
+  EXPECT_EQ("   42|42   |3.142|1.500000", Format("%*d|%*d|%.*f|%.*f", 5, 42, -5, 42, 3, 3.14159, -1, 1.5));
+  EXPECT_EQ("  3.1 x", Format("%*.*f %s", 5, 1, 3.14159, "x"));
+}
+
+TEST_F(DeferredFormatTest, InvalidArguments) {
+  EXPECT_EQ("1 <?>", Format("%i %i", 1));
+  EXPECT_EQ("<?>", Format("%s", 1));
+  EXPECT_EQ("<?>", Format("%d", "str"));
+  EXPECT_EQ("trailing %", Format("trailing %"));
+
+  // Invalid specifications consume their arguments
+  EXPECT_EQ("<?> 2", Format("%*d %i", "str", 1, 2));
+  std::string longSpec = "%" + std::string(100, '0') + "1d %i";
+  EXPECT_EQ("<?> 2", Format(longSpec.c_str(), 1, 2));
+
+  // Truncated strings
+  std::string longString(2 * DeferredArgs::Capacity, 'x');
+  EXPECT_EQ(DeferredArgs::Capacity - 1 - sizeof(u32), Format("%s", longString).size());
+}
+
+TEST_F(DeferredFormatTest, Site) {
+  auto ctx = GetContext();
+
+  DeferredFormatSite site("format %i");
+  u32 atom = site.GetAtom(ctx);
+  EXPECT_EQ(atom, site.GetAtom(ctx));
+  EXPECT_EQ("format %i", ctx->Memory().GetSMAtomTable()->GetString(ctx, atom));
+}
+
+TEST_F(DeferredFormatTest, SiteNewRegion) {
+  auto ctx = GetContext();
+  SharedMemory* memory = &ctx->Memory();
+
+  DeferredFormatSite site("format %i");
+  {
+    auto mem = CreateSharedMemory(1 << 14, "DeferredFormatTest.SiteNewRegion");
+    ctx->SetMemory(mem.get());
+    site.GetAtom(ctx);
+  }
+
+  // The new region is likely mapped at the same address but has its own atom table
+  auto mem = CreateSharedMemory(1 << 14, "DeferredFormatTest.SiteNewRegion");
+  ctx->SetMemory(mem.get());
+  ctx->Memory().GetSMAtomTable()->Intern(ctx, "shifts the atoms");
+  EXPECT_EQ("format %i", ctx->Memory().GetSMAtomTable()->GetString(ctx, site.GetAtom(ctx)));
+
+  ctx->SetMemory(memory);
+}
+
+TEST_F(DeferredFormatTest, Logger) {
+  MessageLogger logger;
+  BIFROST_LOG_DEFERRED(logger, ILogger::LogLevel::Info, "no arguments");
+  EXPECT_EQ("no arguments", logger.Message);
+
+  BIFROST_LOG_DEFERRED(logger, ILogger::LogLevel::Info, "%s = %i", "value", 5);
+  EXPECT_EQ("value = 5", logger.Message);
+}
+
+TEST_F(DeferredFormatTest, LogStash) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+  SMAtomTable* atoms = ctx->Memory().GetSMAtomTable();
+
+  DeferredFormatSite site("%s #%i");
+  DeferredArgs args;
+  args.Encode("message", 1);
+  stash->PushDeferred(ctx, (u32)ILogger::LogLevel::Warn, atoms->Intern(ctx, "module"), site.GetAtom(ctx), args.Data(), args.Size());
+  stash->Push(ctx, (u32)ILogger::LogLevel::Info, atoms->Intern(ctx, "module"), "plain message");
+
+  SMLogStash::LogMessage msg;
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_EQ((u32)ILogger::LogLevel::Warn, msg.Level);
+  EXPECT_EQ("module", msg.Module);
+  EXPECT_EQ("message #1", msg.Message);
+
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_EQ("plain message", msg.Message);
+}
+
+}  // namespace
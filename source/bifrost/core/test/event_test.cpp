@@ -0,0 +1,38 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/event.h"
+
+namespace {
+
+using namespace bifrost;
+
+class EventTest : public TestBaseNoSharedMemory {};
+
+TEST_F(EventTest, SignalAndWait) {
+  Event event1("EventTest.SignalAndWait");
+  Event event2("EventTest.SignalAndWait");
+
+  EXPECT_FALSE(event1.Wait(0));
+
+  // Signals are visible through every handle of the event and reset automatically
+  event1.Signal();
+  EXPECT_TRUE(event2.Wait(0));
+  EXPECT_FALSE(event1.Wait(0));
+
+  std::thread waiter([&]() { EXPECT_TRUE(event2.Wait()); });
+  ::Sleep(10);
+  event1.Signal();
+  waiter.join();
+}
+
+}  // namespace
@@ -0,0 +1,40 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/log_rate_limiter.h"
+
+namespace {
+
+using namespace bifrost;
+
+class LogRateLimiterTest : public TestBaseNoSharedMemory {};
+
+TEST_F(LogRateLimiterTest, Window) {
+  LogRateLimiter limiter(2);
+  u64 numSuppressed = 0;
+
+  EXPECT_TRUE(limiter.TryAcquire(numSuppressed));
+  EXPECT_EQ(0, numSuppressed);
+  EXPECT_TRUE(limiter.TryAcquire(numSuppressed));
+  EXPECT_FALSE(limiter.TryAcquire(numSuppressed));
+  EXPECT_FALSE(limiter.TryAcquire(numSuppressed));
+
+  // The next window reports the suppressed messages
+  ::Sleep(1100);
+  EXPECT_TRUE(limiter.TryAcquire(numSuppressed));
+  EXPECT_EQ(2, numSuppressed);
+  EXPECT_TRUE(limiter.TryAcquire(numSuppressed));
+  EXPECT_EQ(0, numSuppressed);
+}
+
+}  // namespace
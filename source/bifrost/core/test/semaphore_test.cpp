@@ -0,0 +1,41 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/semaphore.h"
+
+namespace {
+
+using namespace bifrost;
+
+class SemaphoreTest : public TestBaseNoSharedMemory {};
+
+TEST_F(SemaphoreTest, ReleaseAndWait) {
+  Semaphore semaphore1("SemaphoreTest.ReleaseAndWait");
+  Semaphore semaphore2("SemaphoreTest.ReleaseAndWait");
+
+  EXPECT_FALSE(semaphore1.Wait(0));
+
+  // The count is shared by every handle of the semaphore
+  semaphore1.Release(2);
+  EXPECT_TRUE(semaphore2.Wait(0));
+  EXPECT_TRUE(semaphore1.Wait(0));
+  EXPECT_FALSE(semaphore2.Wait(0));
+
+  // Wake up all waiters at once
+  std::vector<std::thread> waiters;
+  for (int i = 0; i < 3; ++i) waiters.emplace_back([&]() { EXPECT_TRUE(semaphore2.Wait()); });
+  ::Sleep(10);
+  semaphore1.Release(3);
+  for (auto& waiter : waiters) waiter.join();
+}
+
+}  // namespace
@@ -10,7 +10,12 @@
 // See LICENSE.txt for details.
 
 #include "bifrost/core/test/test.h"
+#include "bifrost/core/buffered_logger.h"
 #include "bifrost/core/injector_param.h"
+#include "bifrost/core/shared_logger.h"
+#include "bifrost/core/sm_atom_table.h"
+#include "bifrost/core/sm_log_levels.h"
+#include "bifrost/core/sm_log_stash.h"
 
 namespace {
 
@@ -18,6 +23,282 @@ using namespace bifrost;
 
 class BufferedLoggerTest : public TestBaseNoSharedMemory {};
 
-TEST_F(BufferedLoggerTest, Flush) {}
+class CountingLogger : public ILogger {
+ public:
+  LogLevel MinLevel = LogLevel::Trace;
+  u32 NumSunk = 0;
+  std::vector<std::string> Messages;
 
-}  // namespace
\ No newline at end of file
+  virtual bool IsEnabled(LogLevel level) override { return level >= MinLevel; }
+  virtual void SetModule(const char* module) override {}
+  virtual void Sink(LogLevel level, const char* module, const char* msg) override {
+    NumSunk++;
+    Messages.emplace_back(msg);
+  }
+  virtual void Sink(LogLevel level, const char* msg) override { Sink(level, "", msg); }
+};
+
+TEST_F(BufferedLoggerTest, Flush) {
+  BufferedLogger buffered;
+  buffered.SetModule("module");
+  buffered.Sink(ILogger::LogLevel::Warn, "msg1");
+  buffered.Sink(ILogger::LogLevel::Error, "msg2");
+  EXPECT_EQ(2, buffered.GetNumMessages());
+
+  CountingLogger logger;
+  buffered.Flush(&logger);
+  ASSERT_EQ(2, logger.Messages.size());
+  EXPECT_EQ("msg1", logger.Messages[0]);
+  EXPECT_EQ("msg2", logger.Messages[1]);
+  EXPECT_EQ(0, buffered.GetNumMessages());
+}
+
+TEST_F(BufferedLoggerTest, Evict) {
+  BufferedLogger buffered(4);
+  for (u32 i = 0; i < 200; ++i) buffered.Sink(ILogger::LogLevel::Warn, StringFormat("msg%u", i).c_str());
+  EXPECT_EQ(4, buffered.GetNumMessages());
+  EXPECT_EQ(196, buffered.GetNumDropped());
+
+  // Long messages are truncated
+  buffered.Sink(ILogger::LogLevel::Warn, std::string(1000, 'x').c_str());
+
+  CountingLogger logger;
+  buffered.Flush(&logger);
+  ASSERT_EQ(5, logger.Messages.size());
+  EXPECT_NE(std::string::npos, logger.Messages[0].find("Dropped 197 log messages"));
+  EXPECT_EQ("msg197", logger.Messages[1]);
+  EXPECT_EQ("msg199", logger.Messages[3]);
+  EXPECT_EQ(BufferedLogger::MaxMessageLength, logger.Messages[4].size());
+  EXPECT_EQ(0, buffered.GetNumDropped());
+}
+
+TEST_F(BufferedLoggerTest, IsEnabled) {
+  CountingLogger logger;
+  logger.MinLevel = ILogger::LogLevel::Warn;
+
+  logger.Info("msg");
+  logger.InfoFormat(L"msg %i", 1);
+  logger.Warn("msg");
+  logger.ErrorFormat("msg %i", 2);
+
+  const u32 numCompiledIn = ILogger::IsCompiledIn(ILogger::LogLevel::Warn) + ILogger::IsCompiledIn(ILogger::LogLevel::Error);
+  EXPECT_EQ(numCompiledIn, logger.NumSunk);
+  EXPECT_EQ(BIFROST_LOG_MIN_LEVEL <= 0, ILogger::IsCompiledIn(ILogger::LogLevel::Trace));
+  EXPECT_FALSE(BIFROST_LOG_ENABLED(logger, ILogger::LogLevel::Debug));
+}
+
+class SharedLoggerTest : public TestBaseSharedMemory {
+ public:
+  std::vector<SMLogStash::LogMessage> PopAll(Context* ctx) {
+    std::vector<SMLogStash::LogMessage> msgs;
+    SMLogStash::LogMessage msg;
+    while (ctx->Memory().GetSMLogStash()->TryPop(ctx, msg)) msgs.emplace_back(std::move(msg));
+    return msgs;
+  }
+};
+
+TEST_F(SharedLoggerTest, ModuleLevel) {
+  auto ctx = GetContext();
+  SMLogLevels* levels = ctx->Memory().GetSMLogLevels();
+
+  SharedLogger logger(ctx);
+  logger.SetModule("module");
+  EXPECT_TRUE(logger.IsEnabled(ILogger::LogLevel::Trace));
+
+  // Trace and debug messages compile away in release builds (see BIFROST_LOG_MIN_LEVEL)
+  logger.Info("msg1");
+  logger.Warn("msg2");
+
+  // The new level is picked up without calling SetModule again
+  levels->SetLevel(ctx, ctx->Memory().GetSMAtomTable()->Intern(ctx, "module"), (u32)ILogger::LogLevel::Warn);
+  EXPECT_FALSE(logger.IsEnabled(ILogger::LogLevel::Info));
+  EXPECT_TRUE(logger.IsEnabled(ILogger::LogLevel::Warn));
+
+  logger.Trace("msg3");
+  logger.InfoFormat("msg%i", 4);
+  logger.Error("msg5");
+  logger.Flush();
+
+  auto msgs = PopAll(ctx);
+  ASSERT_EQ(3, msgs.size());
+  EXPECT_EQ("msg1", msgs[0].Message);
+  EXPECT_EQ("msg2", msgs[1].Message);
+  EXPECT_EQ("msg5", msgs[2].Message);
+
+  // Other modules use the default level
+  logger.SetModule("other");
+  EXPECT_TRUE(logger.IsEnabled(ILogger::LogLevel::Trace));
+}
+
+TEST_F(SharedLoggerTest, ExplicitModuleLevel) {
+  auto ctx = GetContext();
+  SMLogLevels* levels = ctx->Memory().GetSMLogLevels();
+
+  SharedLogger logger(ctx, 0, 0);
+  logger.Sink(ILogger::LogLevel::Info, "plugin", "msg1");
+
+  // The cached level of the module is refreshed once the levels change
+  levels->SetLevel(ctx, ctx->Memory().GetSMAtomTable()->Intern(ctx, "plugin"), (u32)ILogger::LogLevel::Warn);
+  logger.Sink(ILogger::LogLevel::Info, "plugin", "msg2");
+  logger.Sink(ILogger::LogLevel::Info, "other", "msg3");
+  logger.Sink(ILogger::LogLevel::Warn, "plugin", "msg4");
+
+  auto msgs = PopAll(ctx);
+  ASSERT_EQ(3, msgs.size());
+  EXPECT_EQ("msg1", msgs[0].Message);
+  EXPECT_EQ("msg3", msgs[1].Message);
+  EXPECT_EQ("other", msgs[1].Module);
+  EXPECT_EQ("msg4", msgs[2].Message);
+}
+
+TEST_F(SharedLoggerTest, Batch) {
+  auto ctx = GetContext();
+  SMLogLevels* levels = ctx->Memory().GetSMLogLevels();
+  levels->SetLevel(ctx, ctx->Memory().GetSMAtomTable()->Intern(ctx, "module1"), (u32)ILogger::LogLevel::Error);
+
+  SharedLogger logger(ctx);
+  ILogger::LogRecord records[] = {{ILogger::LogLevel::Info, "module1", "msg1"},
+                                  {ILogger::LogLevel::Info, "module2", "msg2"},
+                                  {ILogger::LogLevel::Error, "module1", "msg3"}};
+  logger.SinkBatch(records, 3);
+
+  auto msgs = PopAll(ctx);
+  ASSERT_EQ(2, msgs.size());
+  EXPECT_EQ("msg2", msgs[0].Message);
+  EXPECT_EQ("msg3", msgs[1].Message);
+}
+
+TEST_F(SharedLoggerTest, Staging) {
+  auto ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+
+  SharedLogger logger(ctx, 60 * 1000, 0);
+  logger.SetModule("module");
+
+  // Messages are staged until the buffer is full
+  logger.Info("msg");
+  EXPECT_TRUE(PopAll(ctx).empty());
+  for (u32 i = 1; i < SharedLogger::StagingCapacity; ++i) logger.Info("msg");
+  EXPECT_EQ(SharedLogger::StagingCapacity, PopAll(ctx).size());
+
+  // Warnings are published immediately
+  logger.Info("msg1");
+  logger.Warn("msg2");
+  auto msgs = PopAll(ctx);
+  ASSERT_EQ(2, msgs.size());
+  EXPECT_EQ("msg1", msgs[0].Message);
+  EXPECT_EQ("msg2", msgs[1].Message);
+  EXPECT_LE(msgs[0].Timestamp, msgs[1].Timestamp);
+
+  // Flush publishes the messages of all threads
+  std::thread thread([&]() { logger.Info("msg3"); });
+  thread.join();
+  logger.Info("msg4");
+  EXPECT_TRUE(PopAll(ctx).empty());
+  logger.Flush();
+  EXPECT_EQ(2, PopAll(ctx).size());
+}
+
+TEST_F(SharedLoggerTest, PublishInterval) {
+  auto ctx = GetContext();
+
+  SharedLogger logger(ctx, 10);
+  logger.SetModule("module");
+  logger.Info("msg");
+
+  // The flusher thread publishes the message
+  std::vector<SMLogStash::LogMessage> msgs;
+  for (int i = 0; i < 100 && msgs.empty(); ++i) {
+    ::Sleep(10);
+    msgs = PopAll(ctx);
+  }
+  ASSERT_EQ(1, msgs.size());
+  EXPECT_EQ("msg", msgs[0].Message);
+}
+
+TEST_F(SharedLoggerTest, ReclaimExitedThreads) {
+  auto ctx = GetContext();
+
+  SharedLogger logger(ctx, 10);
+  logger.SetModule("module");
+  logger.Info("msg0");
+  std::thread([&]() { logger.Info("msg1"); }).join();
+  EXPECT_EQ(2, logger.NumStagingBuffers());
+
+  // The flusher thread publishes the message of the exited thread and reclaims its buffer
+  for (int i = 0; i < 100 && logger.NumStagingBuffers() > 1; ++i) ::Sleep(10);
+  EXPECT_EQ(1, logger.NumStagingBuffers());
+  logger.Flush();
+  EXPECT_EQ(2, PopAll(ctx).size());
+}
+
+TEST_F(SharedLoggerTest, Repeats) {
+  auto ctx = GetContext();
+
+  SharedLogger logger(ctx, 0, 60 * 1000);
+  logger.SetModule("module");
+
+  // Repeats of the last message are collapsed
+  for (u32 i = 0; i < 100; ++i) logger.Warn("msg1");
+  logger.Error("msg1");
+  logger.Warn("msg2");
+  logger.Warn("msg2");
+  logger.Flush();
+
+  auto msgs = PopAll(ctx);
+  ASSERT_EQ(5, msgs.size());
+  EXPECT_EQ("msg1", msgs[0].Message);
+  EXPECT_EQ("msg1 (repeated 99 times)", msgs[1].Message);
+  EXPECT_EQ("msg1", msgs[2].Message);
+  EXPECT_EQ((u32)ILogger::LogLevel::Error, msgs[2].Level);
+  EXPECT_EQ("msg2", msgs[3].Message);
+  EXPECT_EQ("msg2 (repeated 1 times)", msgs[4].Message);
+}
+
+TEST_F(SharedLoggerTest, DeferredRepeats) {
+  auto ctx = GetContext();
+
+  SharedLogger logger(ctx, 0, 60 * 1000);
+  logger.SetModule("module");
+
+  // Repeats of a call site are collapsed even if the arguments vary
+  for (i32 i = 0; i < 10; ++i) BIFROST_LOG_DEFERRED(logger, ILogger::LogLevel::Warn, "value %i", i);
+  logger.Warn("msg");
+  logger.Flush();
+
+  auto msgs = PopAll(ctx);
+  ASSERT_EQ(3, msgs.size());
+  EXPECT_EQ("value 0", msgs[0].Message);
+  EXPECT_EQ("value 9 (repeated 9 times)", msgs[1].Message);
+  EXPECT_EQ("msg", msgs[2].Message);
+}
+
+TEST_F(SharedLoggerTest, RepeatWindow) {
+  auto ctx = GetContext();
+
+  SharedLogger logger(ctx, 10, 10);
+  logger.SetModule("module");
+  logger.Warn("msg");
+  logger.Warn("msg");
+
+  // The flusher thread publishes the repeats once the window is over
+  std::vector<SMLogStash::LogMessage> msgs;
+  for (int i = 0; i < 100 && msgs.size() < 2; ++i) {
+    ::Sleep(10);
+    for (auto& msg : PopAll(ctx)) msgs.emplace_back(std::move(msg));
+  }
+  ASSERT_EQ(2, msgs.size());
+  EXPECT_EQ("msg (repeated 1 times)", msgs[1].Message);
+}
+
+TEST_F(SharedLoggerTest, RateLimited) {
+  CountingLogger logger;
+  for (u32 i = 0; i < 100; ++i) BIFROST_LOG_RATE_LIMITED(logger, ILogger::LogLevel::Warn, 10, "msg%u", i);
+
+  ASSERT_EQ(10, logger.Messages.size());
+  EXPECT_EQ("msg0", logger.Messages[0]);
+  EXPECT_EQ("msg9", logger.Messages[9]);
+}
+
+}  // namespace
@@ -0,0 +1,85 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/sm_atom_table.h"
+
+namespace {
+
+using namespace bifrost;
+
+class SMAtomTableTest : public TestBaseNoSharedMemory {};
+
+TEST_F(SMAtomTableTest, Intern) {
+  Context* ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+
+  SMAtomTable& atoms = *ctx->Memory().GetSMAtomTable();
+  EXPECT_EQ(SMAtomTable::EmptyAtom, atoms.Intern(ctx, ""));
+  EXPECT_EQ(0, atoms.Size());
+
+  u32 atom1 = atoms.Intern(ctx, "module1");
+  u32 atom2 = atoms.Intern(ctx, "a module with a name longer than the inline capacity");
+  EXPECT_NE(atom1, atom2);
+  EXPECT_EQ(2, atoms.Size());
+
+  // Interning again yields the same atom
+  EXPECT_EQ(atom1, atoms.Intern(ctx, "module1"));
+  EXPECT_EQ(atom2, atoms.Intern(ctx, "a module with a name longer than the inline capacity"));
+  EXPECT_EQ(2, atoms.Size());
+
+  EXPECT_EQ(std::string_view{}, atoms.GetString(ctx, SMAtomTable::EmptyAtom));
+  EXPECT_EQ(std::string_view{"module1"}, atoms.GetString(ctx, atom1));
+  EXPECT_EQ(std::string_view{"a module with a name longer than the inline capacity"}, atoms.GetString(ctx, atom2));
+
+  // TryGet does not intern
+  u32 atom = 0;
+  EXPECT_TRUE(atoms.TryGet(ctx, "module1", atom));
+  EXPECT_EQ(atom1, atom);
+  EXPECT_FALSE(atoms.TryGet(ctx, "module2", atom));
+  EXPECT_EQ(2, atoms.Size());
+}
+
+TEST_F(SMAtomTableTest, ManyAtoms) {
+  Context* ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 22);
+  ctx->SetMemory(mem.get());
+
+  SMAtomTable& atoms = *ctx->Memory().GetSMAtomTable();
+
+  // Spans several chunks
+  std::vector<u32> ids;
+  for (int i = 0; i < 1000; ++i) ids.emplace_back(atoms.Intern(ctx, "atom" + std::to_string(i)));
+
+  EXPECT_EQ(1000, atoms.Size());
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ("atom" + std::to_string(i), atoms.GetString(ctx, ids[i]));
+    EXPECT_EQ(ids[i], atoms.Intern(ctx, "atom" + std::to_string(i)));
+  }
+}
+
+TEST_F(SMAtomTableTest, MultiSharedMemory) {
+  Context* ctx1 = GetContext();
+  auto mem1 = CreateSharedMemory(1 << 20);
+  ctx1->SetMemory(mem1.get());
+
+  Context ctx2;
+  ctx2.SetLogger(GetLogger());
+  SharedMemory mem2(&ctx2, mem1->GetName(), mem1->GetSizeInBytes());
+  ctx2.SetMemory(&mem2);
+
+  u32 atom = ctx1->Memory().GetSMAtomTable()->Intern(ctx1, "module");
+  EXPECT_EQ(std::string_view{"module"}, ctx2.Memory().GetSMAtomTable()->GetString(&ctx2, atom));
+  EXPECT_EQ(atom, ctx2.Memory().GetSMAtomTable()->Intern(&ctx2, "module"));
+}
+
+}  // namespace
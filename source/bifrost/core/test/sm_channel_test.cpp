@@ -0,0 +1,129 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/sm_channel.h"
+
+namespace {
+
+using namespace bifrost;
+
+class SMChannelTest : public TestBaseSharedMemory {};
+
+struct Sample {
+  i32 Index;
+  double Value;
+};
+
+TEST_F(SMChannelTest, PushPop) {
+  auto ctx = GetContext();
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  auto channelA = New<SMByteChannel>(ctx, ctx, (u32)sizeof(i32), 5);
+  SMChannel<i32> channel(Resolve(channelA));
+  EXPECT_EQ(8, channel.Capacity());
+  EXPECT_EQ(sizeof(i32), channel.Get()->GetElementSize());
+  EXPECT_EQ(0, channel.Size());
+
+  i32 value = 0;
+  EXPECT_FALSE(channel.TryPop(ctx, value));
+
+  EXPECT_TRUE(channel.TryPush(ctx, 1));
+  EXPECT_TRUE(channel.TryPush(ctx, 2));
+  EXPECT_EQ(2, channel.Size());
+
+  EXPECT_TRUE(channel.TryPop(ctx, value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(channel.TryPop(ctx, value));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(channel.TryPop(ctx, value));
+
+  // Non-blocking pop with timeout
+  EXPECT_FALSE(channel.Pop(ctx, value, 10));
+
+  Delete(ctx, channelA);
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SMChannelTest, BatchWrapAround) {
+  auto ctx = GetContext();
+
+  auto channelA = New<SMByteChannel>(ctx, ctx, (u32)sizeof(i32), 8);
+  SMChannel<i32> channel(Resolve(channelA));
+
+  std::array<i32, 12> in;
+  std::iota(in.begin(), in.end(), 0);
+  std::array<i32, 12> out;
+
+  // Only a partial batch fits
+  EXPECT_EQ(8, channel.TryPush(ctx, in.data(), in.size()));
+  EXPECT_EQ(0, channel.TryPush(ctx, in.data(), in.size()));
+  EXPECT_EQ(5, channel.TryPop(ctx, out.data(), 5));
+  for (i32 i = 0; i < 5; ++i) EXPECT_EQ(i, out[i]);
+
+  // Wraps around the end of the buffer
+  EXPECT_EQ(4, channel.TryPush(ctx, in.data() + 8, 4));
+  EXPECT_EQ(7, channel.TryPop(ctx, out.data(), out.size()));
+  for (i32 i = 0; i < 7; ++i) EXPECT_EQ(i + 5, out[i]);
+  EXPECT_EQ(0, channel.Size());
+
+  Delete(ctx, channelA);
+}
+
+TEST_F(SMChannelTest, ProducerConsumer) {
+  auto ctx = GetContext();
+
+  auto channelA = New<SMByteChannel>(ctx, ctx, (u32)sizeof(Sample), 64);
+  SMChannel<Sample> channel(Resolve(channelA));
+
+  const i32 numSamples = 100000;
+  std::thread producer([&]() {
+    for (i32 i = 0; i < numSamples; ++i) ASSERT_TRUE(channel.Push(ctx, Sample{i, 2.0 * i}));
+  });
+
+  std::array<Sample, 16> buffer;
+  i32 expected = 0;
+  while (expected < numSamples) {
+    u64 n = channel.Pop(ctx, buffer.data(), buffer.size(), 5000);
+    ASSERT_NE(0, n);
+    for (u64 i = 0; i < n; ++i, ++expected) {
+      EXPECT_EQ(expected, buffer[i].Index);
+      EXPECT_EQ(2.0 * expected, buffer[i].Value);
+    }
+  }
+
+  producer.join();
+  Delete(ctx, channelA);
+}
+
+TEST_F(SMChannelTest, Registry) {
+  auto ctx = GetContext();
+
+  SMChannelRegistry& registry = *ctx->Memory().GetSMChannelRegistry();
+  EXPECT_EQ(0, registry.Size());
+
+  SMChannel<Sample> channel1 = registry.Open<Sample>(ctx, "samples", 16);
+  ASSERT_NE(nullptr, channel1.Get());
+  EXPECT_EQ(1, registry.Size());
+
+  // Reopening yields the same channel
+  SMChannel<Sample> channel2 = registry.Open<Sample>(ctx, "samples", 32);
+  EXPECT_EQ(channel1.Get(), channel2.Get());
+  EXPECT_EQ(16, channel2.Capacity());
+
+  // Element size mismatch
+  EXPECT_THROW(registry.Open<i32>(ctx, "samples", 16), std::runtime_error);
+
+  registry.Open<i32>(ctx, "ints", 16);
+  EXPECT_EQ(2, registry.Size());
+}
+
+}  // namespace
@@ -0,0 +1,113 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/sm_deque.h"
+#include "bifrost/core/sm_string.h"
+
+namespace {
+
+using namespace bifrost;
+
+class SMDequeTest : public TestBaseSharedMemory {};
+
+TEST_F(SMDequeTest, Construction) {
+  SMDeque<i32> deque;
+  EXPECT_EQ(0, deque.Size());
+  EXPECT_TRUE(deque.Empty());
+  EXPECT_EQ(nullptr, deque.PeekFront(GetContext()));
+  EXPECT_EQ(nullptr, deque.PeekBack(GetContext()));
+}
+
+TEST_F(SMDequeTest, PushBackPopFront) {
+  auto ctx = GetContext();
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  // Spans several blocks
+  SMDeque<i32, 4> deque;
+  for (i32 i = 0; i < 10; ++i) deque.PushBack(ctx, i);
+  EXPECT_EQ(10, deque.Size());
+  EXPECT_EQ(0, *deque.PeekFront(ctx));
+  EXPECT_EQ(9, *deque.PeekBack(ctx));
+
+  for (i32 i = 0; i < 10; ++i) {
+    ASSERT_NE(nullptr, deque.PeekFront(ctx));
+    EXPECT_EQ(i, *deque.PeekFront(ctx));
+    deque.PopFront(ctx);
+  }
+  EXPECT_TRUE(deque.Empty());
+
+  deque.Destruct(&ctx->Memory());
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SMDequeTest, PushFrontPopBack) {
+  auto ctx = GetContext();
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  SMDeque<i32, 4> deque;
+  for (i32 i = 0; i < 10; ++i) deque.PushFront(ctx, i);
+  EXPECT_EQ(10, deque.Size());
+  EXPECT_EQ(9, *deque.PeekFront(ctx));
+  EXPECT_EQ(0, *deque.PeekBack(ctx));
+
+  for (i32 i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, *deque.PeekBack(ctx));
+    deque.PopBack(ctx);
+  }
+  EXPECT_TRUE(deque.Empty());
+
+  deque.Destruct(&ctx->Memory());
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SMDequeTest, ForEach) {
+  auto ctx = GetContext();
+
+  SMDeque<i32, 4> deque;
+  for (i32 i = 0; i < 5; ++i) deque.PushBack(ctx, i);
+  for (i32 i = 1; i < 5; ++i) deque.PushFront(ctx, -i);
+
+  std::vector<i32> values;
+  deque.ForEach(ctx, [&values](i32* value) {
+    values.emplace_back(*value);
+    return true;
+  });
+  EXPECT_EQ((std::vector<i32>{-4, -3, -2, -1, 0, 1, 2, 3, 4}), values);
+
+  // Stop early
+  values.clear();
+  deque.ForEach(ctx, [&values](i32* value) {
+    values.emplace_back(*value);
+    return values.size() < 2;
+  });
+  EXPECT_EQ(2, values.size());
+
+  deque.Clear(ctx);
+  EXPECT_TRUE(deque.Empty());
+}
+
+TEST_F(SMDequeTest, SMObject) {
+  auto ctx = GetContext();
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  SMDeque<SMString, 4> deque;
+  for (i32 i = 0; i < 10; ++i) deque.PushBack(ctx, SMString(ctx, "a string which is too long to be stored inline #" + std::to_string(i)));
+  deque.PopFront(ctx);
+  deque.PopBack(ctx);
+  EXPECT_EQ(8, deque.Size());
+  EXPECT_EQ("a string which is too long to be stored inline #1", deque.PeekFront(ctx)->AsView(ctx));
+
+  deque.Destruct(&ctx->Memory());
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+}  // namespace
@@ -112,4 +112,60 @@ TEST_F(SMListTest, PushPopBack) {
   EXPECT_EQ(43, *tailValue);
 }
 
-}  // namespace
+TEST_F(SMListTest, Insert) {
+  auto ctx = GetContext();
+
+  SMList<i32> list;
+  list.Insert(ctx, nullptr, 1);
+  EXPECT_EQ(1, list.Size());
+
+  list.Insert(ctx, Resolve(list.GetTail()), 3);
+  list.Insert(ctx, Resolve(list.GetHead()), 2);
+  EXPECT_EQ(3, list.Size());
+
+  std::vector<i32> values;
+  list.ForeachHeadToTail(ctx, [&values](SMList<i32>::Node* node) {
+    values.emplace_back(node->Value);
+    return true;
+  });
+  EXPECT_EQ((std::vector<i32>{1, 2, 3}), values);
+  list.Destruct(&ctx->Memory());
+}
+
+TEST_F(SMListTest, Pool) {
+  auto ctx = GetContext();
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  SMList<i32> list;
+  list.ReservePool(ctx, 4);
+  EXPECT_EQ(4, list.PoolSize());
+  auto freeMemoryWithPool = ctx->Memory().GetNumFreeBytes();
+
+  // Steady state does not allocate
+  for (i32 i = 0; i < 100; ++i) {
+    list.PushBack(ctx, i);
+    list.PushBack(ctx, i + 1);
+    EXPECT_EQ(2, list.Size());
+    EXPECT_EQ(i, *list.PeekFront(ctx));
+    list.PopFront(ctx);
+    list.PopFront(ctx);
+    EXPECT_EQ(0, list.Size());
+  }
+  EXPECT_EQ(4, list.PoolSize());
+  EXPECT_EQ(freeMemoryWithPool, ctx->Memory().GetNumFreeBytes());
+
+  // Exceeding the pool capacity deletes the nodes
+  for (i32 i = 0; i < 6; ++i) list.PushBack(ctx, i);
+  EXPECT_EQ(0, list.PoolSize());
+  for (i32 i = 0; i < 6; ++i) list.PopBack(ctx);
+  EXPECT_EQ(4, list.PoolSize());
+
+  list.SetPoolCapacity(ctx, 1);
+  EXPECT_EQ(1, list.PoolSize());
+
+  list.Destruct(&ctx->Memory());
+  EXPECT_EQ(0, list.PoolSize());
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+}  // namespace
\ No newline at end of file
@@ -0,0 +1,59 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/sm_atom_table.h"
+#include "bifrost/core/sm_log_levels.h"
+
+namespace {
+
+using namespace bifrost;
+
+class SMLogLevelsTest : public TestBaseSharedMemory {};
+
+TEST_F(SMLogLevelsTest, DefaultLevel) {
+  auto ctx = GetContext();
+  SMLogLevels* levels = ctx->Memory().GetSMLogLevels();
+  u32 moduleAtom = ctx->Memory().GetSMAtomTable()->Intern(ctx, "module");
+
+  EXPECT_EQ(0, levels->GetLevel(ctx, moduleAtom));
+
+  u32 version = levels->GetVersion();
+  levels->SetDefaultLevel((u32)ILogger::LogLevel::Warn);
+  EXPECT_NE(version, levels->GetVersion());
+  EXPECT_EQ((u32)ILogger::LogLevel::Warn, levels->GetDefaultLevel());
+  EXPECT_EQ((u32)ILogger::LogLevel::Warn, levels->GetLevel(ctx, moduleAtom));
+
+  levels->SetDefaultLevel((u32)ILogger::LogLevel::Trace);
+}
+
+TEST_F(SMLogLevelsTest, ModuleLevel) {
+  auto ctx = GetContext();
+  SMLogLevels* levels = ctx->Memory().GetSMLogLevels();
+  u32 module1 = ctx->Memory().GetSMAtomTable()->Intern(ctx, "module1");
+  u32 module2 = ctx->Memory().GetSMAtomTable()->Intern(ctx, "module2");
+
+  levels->SetLevel(ctx, module1, (u32)ILogger::LogLevel::Error);
+  EXPECT_EQ((u32)ILogger::LogLevel::Error, levels->GetLevel(ctx, module1));
+  EXPECT_EQ(levels->GetDefaultLevel(), levels->GetLevel(ctx, module2));
+
+  // Overwrite
+  u32 version = levels->GetVersion();
+  levels->SetLevel(ctx, module1, (u32)ILogger::LogLevel::Info);
+  EXPECT_NE(version, levels->GetVersion());
+  EXPECT_EQ((u32)ILogger::LogLevel::Info, levels->GetLevel(ctx, module1));
+
+  // Reset to the default
+  levels->ResetLevel(ctx, module1);
+  EXPECT_EQ(levels->GetDefaultLevel(), levels->GetLevel(ctx, module1));
+}
+
+}  // namespace
@@ -10,7 +10,10 @@
 // See LICENSE.txt for details.
 
 #include "bifrost/core/test/test.h"
+#include "bifrost/core/event.h"
+#include "bifrost/core/sm_atom_table.h"
 #include "bifrost/core/sm_log_stash.h"
+#include "bifrost/core/timestamp.h"
 
 namespace {
 
@@ -18,7 +21,9 @@ using namespace bifrost;
 
 class SharedLogStashTest : public TestBaseSharedMemory {
  public:
-  void Log(Context* ctx, ILogger::LogLevel level, const char* module, const char* msg) { ctx->Memory().GetSMLogStash()->Push(ctx, (u32)level, module, msg); }
+  void Log(Context* ctx, ILogger::LogLevel level, const char* module, const char* msg) {
+    ctx->Memory().GetSMLogStash()->Push(ctx, (u32)level, ctx->Memory().GetSMAtomTable()->Intern(ctx, module), msg);
+  }
 };
 
 class LogBuffer : public ILogger {
@@ -29,7 +34,9 @@ class LogBuffer : public ILogger {
     std::string Msg;
   };
   std::vector<Message> Buffer;
+  std::atomic<u32> NumFlushes{0};
 
+  virtual void Flush() override { NumFlushes++; }
   virtual void SetModule(const char* module) override {}
   virtual void Sink(LogLevel level, const char* module, const char* msg) override { Buffer.emplace_back(Message{level, module, msg}); }
   virtual void Sink(LogLevel level, const char* msg) override { Buffer.emplace_back(Message{level, "", msg}); }
@@ -68,6 +75,41 @@ TEST_F(SharedLogStashTest, SingleSharedMemory) {
   EXPECT_STREQ("msg4", sink.Buffer[3].Msg.c_str());
 }
 
+TEST_F(SharedLogStashTest, FlushWhenIdle) {
+  LogBuffer sink;
+  LogStashConsumer consumer(GetContext(), GetContext()->Memory().GetSMLogStash(), &sink);
+  ::Sleep(200);
+  EXPECT_GT(sink.NumFlushes.load(), 0);
+
+  consumer.StopAndFlush();
+  EXPECT_EQ(0, sink.Buffer.size());
+}
+
+TEST_F(SharedLogStashTest, Reorder) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+
+  LogBuffer sink;
+  LogStashConsumer consumer(ctx, stash, &sink, nullptr, 1000);
+
+  // Thread 2 publishes its newer message before thread 1 publishes its staged older message
+  u64 now = GetTimestamp();
+  ILogger::LogRecord newer{ILogger::LogLevel::Info, "module", "newer", now, 2};
+  ILogger::LogRecord older{ILogger::LogLevel::Info, "module", "older", now - GetTimestampFrequency() / 100, 1};
+  stash->PushBatch(ctx, &newer, 1);
+  ::Sleep(50);
+  stash->PushBatch(ctx, &older, 1);
+
+  // Both messages are held back for the reorder window
+  ::Sleep(50);
+  EXPECT_EQ(0, sink.Buffer.size());
+
+  consumer.StopAndFlush();
+  ASSERT_EQ(2, sink.Buffer.size());
+  EXPECT_EQ("older", sink.Buffer[0].Msg);
+  EXPECT_EQ("newer", sink.Buffer[1].Msg);
+}
+
 TEST_F(SharedLogStashTest, MultiSharedMemory) {
   Context& ctx1 = *GetContext();
 
@@ -94,4 +136,347 @@ TEST_F(SharedLogStashTest, MultiSharedMemory) {
   EXPECT_STREQ("msg2", sink.Buffer[1].Msg.c_str());
 }
 
-}  // namespace
\ No newline at end of file
+TEST_F(SharedLogStashTest, Capacity) {
+  EXPECT_EQ(SMLogStash::MinCapacity, SMLogStash::ComputeCapacity(1 << 14));
+  EXPECT_EQ(1 << 18, SMLogStash::ComputeCapacity(1 << 22));
+  EXPECT_EQ(SMLogStash::MaxCapacity, SMLogStash::ComputeCapacity(u64(1) << 32));
+}
+
+TEST_F(SharedLogStashTest, TruncateAndDrop) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+  SMLogStash::LogMessage msg;
+
+  // Too long messages are truncated
+  std::string longMessage(stash->Capacity(), 'x');
+  Log(ctx, ILogger::LogLevel::Info, "module", longMessage.c_str());
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_EQ(stash->MaxMessageLength(), msg.Message.size());
+  EXPECT_TRUE(stash->Empty());
+
+  // Messages are dropped if the stash is full
+  u64 numPushed = 0;
+  while (stash->NumDropped() == 0) {
+    Log(ctx, ILogger::LogLevel::Info, "module", std::to_string(numPushed++).c_str());
+  }
+
+  for (u64 i = 0; i < numPushed - 1; ++i) {
+    ASSERT_TRUE(stash->TryPop(ctx, msg));
+    EXPECT_EQ(std::to_string(i), msg.Message);
+  }
+  EXPECT_FALSE(stash->TryPop(ctx, msg));
+  EXPECT_EQ(1, stash->NumDropped());
+
+  // Wrap around and keep the order
+  for (u64 i = 0; i < numPushed - 1; ++i) {
+    Log(ctx, ILogger::LogLevel::Info, "module", std::to_string(i).c_str());
+    ASSERT_TRUE(stash->TryPop(ctx, msg));
+    EXPECT_EQ(std::to_string(i), msg.Message);
+  }
+  EXPECT_TRUE(stash->Empty());
+}
+
+TEST_F(SharedLogStashTest, MultipleProducers) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+
+  const u64 numThreads = 4;
+  const u64 numMessagesPerThread = 10000;
+  std::atomic<u64> numDone{0};
+
+  std::vector<std::thread> threads;
+  for (u64 t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (u64 i = 0; i < numMessagesPerThread; ++i) Log(ctx, ILogger::LogLevel::Info, "module", std::to_string(t).c_str());
+      numDone++;
+    });
+  }
+
+  u64 numPopped = 0;
+  SMLogStash::LogMessage msg;
+  while (numDone.load() < numThreads || !stash->Empty()) {
+    if (stash->TryPop(ctx, msg)) {
+      EXPECT_EQ(1, msg.Message.size());
+      numPopped++;
+    }
+  }
+  for (auto& thread : threads) thread.join();
+
+  EXPECT_EQ(numThreads * numMessagesPerThread, numPopped + stash->NumDropped());
+}
+
+TEST_F(SharedLogStashTest, Wait) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+
+  // Producer wakes up the waiting consumer
+  std::thread producer([&]() {
+    ::Sleep(10);
+    Log(ctx, ILogger::LogLevel::Info, "module", "msg");
+  });
+  stash->Wait(ctx, Event::Infinite);
+  producer.join();
+
+  // Don't block if there are messages
+  stash->Wait(ctx, Event::Infinite);
+
+  SMLogStash::LogMessage msg;
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_EQ("msg", msg.Message);
+}
+
+TEST_F(SharedLogStashTest, Batch) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+
+  std::vector<std::string> messages;
+  std::vector<ILogger::LogRecord> records;
+  for (int i = 0; i < 10; ++i) messages.emplace_back("msg" + std::to_string(i));
+  for (int i = 0; i < 10; ++i) records.emplace_back(ILogger::LogRecord{ILogger::LogLevel::Info, i < 5 ? "module1" : "module2", messages[i].c_str()});
+  stash->PushBatch(ctx, records.data(), records.size());
+
+  std::vector<SMLogStash::LogMessage> popped(4);
+  EXPECT_EQ(4, stash->TryPopBatch(ctx, popped.data(), popped.size()));
+  EXPECT_EQ("msg0", popped[0].Message);
+  EXPECT_EQ("module1", popped[0].Module);
+  EXPECT_EQ("msg3", popped[3].Message);
+
+  popped.resize(10);
+  EXPECT_EQ(6, stash->TryPopBatch(ctx, popped.data(), popped.size()));
+  EXPECT_EQ("msg4", popped[0].Message);
+  EXPECT_EQ("module1", popped[0].Module);
+  EXPECT_EQ("msg9", popped[5].Message);
+  EXPECT_EQ("module2", popped[5].Module);
+  EXPECT_EQ(0, stash->TryPopBatch(ctx, popped.data(), popped.size()));
+
+  // Messages which don't fit are dropped
+  std::string longMessage(stash->MaxMessageLength(), 'x');
+  records.assign(8, ILogger::LogRecord{ILogger::LogLevel::Info, "module1", longMessage.c_str()});
+  stash->PushBatch(ctx, records.data(), records.size());
+  EXPECT_GT(stash->NumDropped(), 0);
+  EXPECT_EQ(records.size() - stash->NumDropped(), stash->TryPopBatch(ctx, popped.data(), popped.size()));
+}
+
+TEST_F(SharedLogStashTest, Timestamp) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+
+  u64 before = GetTimestamp();
+  Log(ctx, ILogger::LogLevel::Info, "module", "msg1");
+  u64 after = GetTimestamp();
+
+  // Timestamps of batched records are preserved
+  ILogger::LogRecord record{ILogger::LogLevel::Info, "module", "msg2", 42, 7};
+  stash->PushBatch(ctx, &record, 1);
+
+  SMLogStash::LogMessage msg;
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_LE(before, msg.Timestamp);
+  EXPECT_GE(after, msg.Timestamp);
+  EXPECT_EQ(::GetCurrentThreadId(), msg.ThreadId);
+
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_EQ(42, msg.Timestamp);
+  EXPECT_EQ(7, msg.ThreadId);
+}
+
+TEST_F(SharedLogStashTest, DropNewest) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+  SMLogStash::LogMessage msg;
+
+  // Record budget
+  stash->SetBudget(stash->Capacity(), 2);
+  Log(ctx, ILogger::LogLevel::Info, "module", "msg1");
+  Log(ctx, ILogger::LogLevel::Info, "module", "msg2");
+  Log(ctx, ILogger::LogLevel::Debug, "module", "msg3");
+  Log(ctx, ILogger::LogLevel::Error, "module", "msg4");
+  EXPECT_EQ(2, stash->NumDropped());
+  EXPECT_EQ(1, stash->NumDropped((u32)ILogger::LogLevel::Debug));
+  EXPECT_EQ(1, stash->NumDropped((u32)ILogger::LogLevel::Error));
+
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_EQ("msg1", msg.Message);
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_EQ("msg2", msg.Message);
+  EXPECT_FALSE(stash->TryPop(ctx, msg));
+}
+
+TEST_F(SharedLogStashTest, DropOldest) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+  SMLogStash::LogMessage msg;
+
+  stash->SetOverflowPolicy(SMLogStash::OverflowPolicy::DropOldest);
+  stash->SetBudget(stash->Capacity(), 2);
+  for (int i = 0; i < 5; ++i) Log(ctx, ILogger::LogLevel::Info, "module", std::to_string(i).c_str());
+  EXPECT_EQ(3, stash->NumDropped((u32)ILogger::LogLevel::Info));
+
+  // The newest messages are kept
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_EQ("3", msg.Message);
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_EQ("4", msg.Message);
+  EXPECT_TRUE(stash->Empty());
+}
+
+TEST_F(SharedLogStashTest, Block) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+  stash->SetOverflowPolicy(SMLogStash::OverflowPolicy::Block, 50);
+  stash->SetBudget(stash->Capacity(), 4);
+
+  // A consumer drains the stash while the producer is blocked
+  std::atomic<bool> done{false};
+  std::atomic<u64> numPopped{0};
+  std::thread consumer([&]() {
+    SMLogStash::LogMessage msg;
+    while (!done || !stash->Empty()) {
+      if (stash->TryPop(ctx, msg)) numPopped++;
+    }
+  });
+
+  for (int i = 0; i < 100; ++i) Log(ctx, ILogger::LogLevel::Info, "module", std::to_string(i).c_str());
+  done = true;
+  consumer.join();
+  EXPECT_EQ(100, numPopped + stash->NumDropped());
+
+  // Without a consumer the message is dropped after the timeout
+  for (int i = 0; i < 5; ++i) Log(ctx, ILogger::LogLevel::Warn, "module", "msg");
+  EXPECT_EQ(1, stash->NumDropped((u32)ILogger::LogLevel::Warn));
+}
+
+TEST_F(SharedLogStashTest, Spill) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+  SMLogStash::LogMessage msg;
+  ctx->Memory().GetSMAtomTable()->Intern(ctx, "module");
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  stash->SetOverflowPolicy(SMLogStash::OverflowPolicy::Spill);
+  stash->SetBudget(stash->Capacity(), 2);
+  for (int i = 0; i < 5; ++i) Log(ctx, ILogger::LogLevel::Info, "module", std::to_string(i).c_str());
+  EXPECT_EQ(0, stash->NumDropped());
+  EXPECT_EQ(3, stash->NumSpilled());
+
+  // Spilled messages are consumed after the ring
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(stash->TryPop(ctx, msg));
+    EXPECT_EQ(std::to_string(i), msg.Message);
+  }
+  EXPECT_TRUE(stash->Empty());
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SharedLogStashTest, SpillToDisk) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+  SMLogStash::LogMessage msg;
+
+  stash->SetOverflowPolicy(SMLogStash::OverflowPolicy::SpillToDisk, 0);
+  stash->SetBudget(stash->Capacity(), 2);
+  for (int i = 0; i < 5; ++i) Log(ctx, ILogger::LogLevel::Info, "module", std::to_string(i).c_str());
+  EXPECT_EQ(0, stash->NumDropped());
+  EXPECT_TRUE(std::filesystem::exists(LogSpillFile::GetPath(ctx->Memory().GetName(), ::GetCurrentProcessId())));
+
+  // The stash was full, the spilled messages are announced once there is room for the marker
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(stash->TryPop(ctx, msg));
+    EXPECT_EQ(std::to_string(i), msg.Message);
+  }
+  EXPECT_TRUE(stash->Empty());
+  stash->AnnounceSpilled(ctx);
+
+  // Spilled messages are replayed in order (one message at a time)
+  for (int i = 2; i < 5; ++i) {
+    ASSERT_TRUE(stash->TryPop(ctx, msg));
+    EXPECT_EQ(std::to_string(i), msg.Message);
+  }
+  EXPECT_TRUE(stash->Empty());
+
+  // Once the spill file is caught up, messages go to the stash again
+  Log(ctx, ILogger::LogLevel::Info, "module", "5");
+  ASSERT_TRUE(stash->TryPop(ctx, msg));
+  EXPECT_EQ("5", msg.Message);
+}
+
+TEST_F(SharedLogStashTest, CloseSpillFileOfExitedProcess) {
+  auto ctx = GetContext();
+  LogSpillFiles& files = ctx->Memory().GetLogSpillFiles();
+  auto isStashEmpty = []() { return true; };
+
+  STARTUPINFOW startupInfo = {sizeof(startupInfo)};
+  PROCESS_INFORMATION processInfo = {};
+  wchar_t cmd[] = L"cmd.exe /c exit";
+  ASSERT_TRUE(::CreateProcessW(NULL, cmd, NULL, NULL, FALSE, CREATE_SUSPENDED | CREATE_NO_WINDOW, NULL, NULL, &startupInfo, &processInfo));
+  u32 pid = processInfo.dwProcessId;
+
+  // Spill file the other process wrote before it exits
+  {
+    LogSpillFile file(ctx->Memory().GetName(), pid, true, 4096);
+    ASSERT_NE(nullptr, files.Open(pid));
+  }
+
+  // The file is kept open while the process is alive
+  files.CloseExited(isStashEmpty);
+  EXPECT_EQ(1, files.NumOpened());
+
+  ::TerminateProcess(processInfo.hProcess, 0);
+  ::WaitForSingleObject(processInfo.hProcess, INFINITE);
+  ::CloseHandle(processInfo.hThread);
+  ::CloseHandle(processInfo.hProcess);
+
+  files.CloseExited(isStashEmpty);
+  EXPECT_EQ(0, files.NumOpened());
+  EXPECT_FALSE(std::filesystem::exists(LogSpillFile::GetPath(ctx->Memory().GetName(), pid)));
+}
+
+TEST_F(SharedLogStashTest, SpillFileOutlivesWriter) {
+  auto ctx = GetContext();
+  LogSpillFiles& files = ctx->Memory().GetLogSpillFiles();
+  auto isStashEmpty = []() { return true; };
+
+  STARTUPINFOW startupInfo = {sizeof(startupInfo)};
+  PROCESS_INFORMATION processInfo = {};
+  wchar_t cmd[] = L"cmd.exe /c exit";
+  ASSERT_TRUE(::CreateProcessW(NULL, cmd, NULL, NULL, FALSE, CREATE_SUSPENDED | CREATE_NO_WINDOW, NULL, NULL, &startupInfo, &processInfo));
+  u32 pid = processInfo.dwProcessId;
+
+  // The other process spills records and exits before the consumer opened its file
+  {
+    LogSpillFile file(ctx->Memory().GetName(), pid, true, 4096);
+    file.SetWritePos(64);
+  }
+  ::TerminateProcess(processInfo.hProcess, 0);
+  ::WaitForSingleObject(processInfo.hProcess, INFINITE);
+  ::CloseHandle(processInfo.hThread);
+  ::CloseHandle(processInfo.hProcess);
+
+  // The records can still be replayed, the consumer deletes the file afterwards
+  LogSpillFile* file = files.Open(pid);
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(64, file->GetWritePos());
+  files.CloseExited(isStashEmpty);
+  EXPECT_EQ(0, files.NumOpened());
+  EXPECT_FALSE(std::filesystem::exists(LogSpillFile::GetPath(ctx->Memory().GetName(), pid)));
+}
+
+TEST_F(SharedLogStashTest, ReportDropped) {
+  auto ctx = GetContext();
+  SMLogStash* stash = ctx->Memory().GetSMLogStash();
+  stash->SetBudget(stash->Capacity(), 1);
+  Log(ctx, ILogger::LogLevel::Info, "module", "msg1");
+  Log(ctx, ILogger::LogLevel::Trace, "module", "msg2");
+  Log(ctx, ILogger::LogLevel::Error, "module", "msg3");
+
+  LogBuffer sink;
+  LogStashConsumer consumer(ctx, stash, &sink);
+  consumer.StopAndFlush();
+
+  ASSERT_EQ(2, sink.Buffer.size());
+  EXPECT_EQ("msg1", sink.Buffer[0].Msg);
+  EXPECT_EQ(ILogger::LogLevel::Warn, sink.Buffer[1].Level);
+  EXPECT_EQ("Dropped 2 log messages as the log stash was full (trace: 1, error: 1)", sink.Buffer[1].Msg);
+}
+
+}  // namespace
@@ -0,0 +1,91 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/sm_mpmc_queue.h"
+
+namespace {
+
+using namespace bifrost;
+
+class SMMPMCQueueTest : public TestBaseSharedMemory {};
+
+TEST_F(SMMPMCQueueTest, PushPop) {
+  auto ctx = GetContext();
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  auto queueA = New<SMMPMCQueue<i32>>(ctx, ctx, 3);
+  SMMPMCQueue<i32>& queue = *Resolve(queueA);
+  EXPECT_EQ(4, queue.Capacity());
+  EXPECT_EQ(0, queue.Size());
+
+  i32 value = 0;
+  EXPECT_FALSE(queue.TryPop(ctx, value));
+
+  for (i32 i = 0; i < 4; ++i) EXPECT_TRUE(queue.TryPush(ctx, i));
+  EXPECT_FALSE(queue.TryPush(ctx, 4));
+  EXPECT_EQ(4, queue.Size());
+
+  // FIFO order over several laps
+  for (i32 lap = 0; lap < 3; ++lap) {
+    for (i32 i = 0; i < 4; ++i) {
+      ASSERT_TRUE(queue.TryPop(ctx, value));
+      EXPECT_EQ(i, value);
+      EXPECT_TRUE(queue.TryPush(ctx, i));
+    }
+  }
+
+  Delete(ctx, queueA);
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SMMPMCQueueTest, MultiProducerMultiConsumer) {
+  auto ctx = GetContext();
+
+  auto queueA = New<SMMPMCQueue<u64>>(ctx, ctx, 64);
+  SMMPMCQueue<u64>& queue = *Resolve(queueA);
+
+  const u64 numThreads = 4;
+  const u64 numElementsPerThread = 50000;
+
+  std::atomic<u64> sum{0};
+  std::atomic<u64> numPopped{0};
+
+  std::vector<std::thread> threads;
+  for (u64 t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (u64 i = 0; i < numElementsPerThread; ++i) {
+        while (!queue.TryPush(ctx, t * numElementsPerThread + i + 1)) std::this_thread::yield();
+      }
+    });
+    threads.emplace_back([&]() {
+      u64 value = 0;
+      while (numPopped.load() < numThreads * numElementsPerThread) {
+        if (queue.TryPop(ctx, value)) {
+          sum += value;
+          numPopped++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  const u64 n = numThreads * numElementsPerThread;
+  EXPECT_EQ(n, numPopped.load());
+  EXPECT_EQ(n * (n + 1) / 2, sum.load());
+  EXPECT_EQ(0, queue.Size());
+
+  Delete(ctx, queueA);
+}
+
+}  // namespace
@@ -0,0 +1,152 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/sm_ordered_map.h"
+
+namespace {
+
+using namespace bifrost;
+
+class SMOrderedMapTest : public TestBaseNoSharedMemory {};
+
+TEST_F(SMOrderedMapTest, Construction) {
+  auto ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+
+  SMOrderedMap<u64, u32> map;
+  EXPECT_EQ(0, map.Size());
+  EXPECT_TRUE(map.Empty());
+  EXPECT_EQ(nullptr, map.Find(ctx, 1));
+  EXPECT_FALSE(map.LowerBound(ctx, 1).IsValid());
+  EXPECT_FALSE(map.Begin(ctx).IsValid());
+}
+
+TEST_F(SMOrderedMapTest, InsertFindRemove) {
+  auto ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  // Small fanout to get a deep tree
+  SMOrderedMap<u64, u64, std::less<u64>, 4> map;
+  std::map<u64, u64> ref;
+
+  std::mt19937 rng(42);
+  for (int i = 0; i < 2000; ++i) {
+    u64 k = rng() % 1000;
+    EXPECT_EQ(ref.count(k) == 0, map.Insert(ctx, k, i));
+    ref[k] = i;
+  }
+  EXPECT_EQ(ref.size(), map.Size());
+  EXPECT_GT(map.Height(), 2);
+
+  for (u64 k = 0; k < 1000; ++k) {
+    u64* value = map.Find(ctx, k);
+    auto it = ref.find(k);
+    if (it == ref.end()) {
+      EXPECT_EQ(nullptr, value);
+    } else {
+      ASSERT_NE(nullptr, value);
+      EXPECT_EQ(it->second, *value);
+    }
+  }
+
+  // Remove every other key
+  for (u64 k = 0; k < 1000; k += 2) EXPECT_EQ(ref.erase(k) == 1, map.Remove(ctx, k));
+  EXPECT_EQ(ref.size(), map.Size());
+
+  // In-order traversal matches
+  auto it = ref.begin();
+  for (auto cursor = map.Begin(ctx); cursor.IsValid(); cursor.Next(), ++it) {
+    ASSERT_NE(ref.end(), it);
+    EXPECT_EQ(it->first, cursor.Key());
+    EXPECT_EQ(it->second, cursor.Value());
+  }
+  EXPECT_EQ(ref.end(), it);
+
+  map.Destruct(&ctx->Memory());
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SMOrderedMapTest, LowerBoundAndRange) {
+  auto ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+
+  SMOrderedMap<i32, i32, std::less<i32>, 4> map;
+  for (i32 i = 0; i < 100; ++i) map.Insert(ctx, i * 10, i);
+
+  auto cursor = map.LowerBound(ctx, 15);
+  ASSERT_TRUE(cursor.IsValid());
+  EXPECT_EQ(20, cursor.Key());
+
+  cursor = map.LowerBound(ctx, 20);
+  ASSERT_TRUE(cursor.IsValid());
+  EXPECT_EQ(20, cursor.Key());
+
+  EXPECT_FALSE(map.LowerBound(ctx, 991).IsValid());
+
+  std::vector<i32> keys;
+  map.ForEachRange(ctx, 95, 150, [&keys](const i32& k, i32& v) {
+    keys.emplace_back(k);
+    return true;
+  });
+  EXPECT_EQ((std::vector<i32>{100, 110, 120, 130, 140}), keys);
+
+  // Stop early
+  keys.clear();
+  map.ForEachRange(ctx, 0, 1000, [&keys](const i32& k, i32& v) {
+    keys.emplace_back(k);
+    return keys.size() < 3;
+  });
+  EXPECT_EQ(3, keys.size());
+
+  map.Clear(ctx);
+  EXPECT_TRUE(map.Empty());
+}
+
+TEST_F(SMOrderedMapTest, BulkLoad) {
+  auto ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  std::vector<u64> keys, values;
+  for (u64 i = 0; i < 1234; ++i) {
+    keys.emplace_back(2 * i);
+    values.emplace_back(i);
+  }
+
+  SMOrderedMap<u64, u64, std::less<u64>, 8> map;
+  map.BulkLoad(ctx, keys.data(), values.data(), keys.size());
+  EXPECT_EQ(keys.size(), map.Size());
+
+  for (u64 i = 0; i < keys.size(); ++i) {
+    ASSERT_NE(nullptr, map.Find(ctx, 2 * i));
+    EXPECT_EQ(i, *map.Find(ctx, 2 * i));
+    EXPECT_EQ(nullptr, map.Find(ctx, 2 * i + 1));
+  }
+
+  // Inserting after bulk loading splits the full nodes
+  for (u64 i = 0; i < keys.size(); ++i) EXPECT_TRUE(map.Insert(ctx, 2 * i + 1, i));
+  u64 expected = 0;
+  for (auto cursor = map.Begin(ctx); cursor.IsValid(); cursor.Next()) EXPECT_EQ(expected++, cursor.Key());
+  EXPECT_EQ(2 * keys.size(), expected);
+
+  EXPECT_THROW(map.BulkLoad(ctx, keys.data(), values.data(), keys.size()), std::runtime_error);
+
+  map.Destruct(&ctx->Memory());
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+}  // namespace
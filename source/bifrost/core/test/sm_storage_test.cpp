@@ -100,4 +100,187 @@ TEST_F(SharedStorageTest, InsertAndRemove) {
   EXPECT_EQ(initialMem, ctx->Memory().GetNumFreeBytes());
 }
 
+TEST_F(SharedStorageTest, Blob) {
+  Context* ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+
+  SMStorage& storage = *ctx->Memory().GetSMStorage();
+
+  const char data[] = "binary\0data";
+  storage.InsertBlob(ctx, "blob", data, sizeof(data));
+  {
+    SMStorageView view = storage.GetBlob(ctx, "blob");
+    ASSERT_TRUE(view.IsValid());
+    ASSERT_EQ(sizeof(data), view.SizeInBytes());
+    EXPECT_EQ(0, std::memcmp(data, view.Data(), sizeof(data)));
+
+    // Zero-copy
+    EXPECT_EQ(view.Data(), storage.GetBlob(ctx, "blob").Data());
+  }
+
+  // No conversions
+  EXPECT_THROW(storage.GetString(ctx, "blob"), std::runtime_error);
+  EXPECT_THROW(storage.GetInt(ctx, "blob"), std::runtime_error);
+  EXPECT_THROW(storage.GetArray<float>(ctx, "blob"), std::runtime_error);
+  EXPECT_THROW(storage.GetBlob(ctx, "unknown"), std::runtime_error);
+
+  storage.InsertInt(ctx, "int", 5);
+  EXPECT_THROW(storage.GetBlob(ctx, "int"), std::runtime_error);
+}
+
+TEST_F(SharedStorageTest, Array) {
+  Context* ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+
+  SMStorage& storage = *ctx->Memory().GetSMStorage();
+
+  std::vector<float> floats = {1.0f, 2.0f, 3.0f};
+  std::vector<double> doubles = {1.0, 2.0};
+  std::vector<i32> ints32 = {-1, 0, 1, 2};
+  std::vector<i64> ints64 = {1ll << 40};
+
+  storage.InsertArray(ctx, "float", floats.data(), floats.size());
+  storage.InsertArray(ctx, "double", doubles.data(), doubles.size());
+  storage.InsertArray(ctx, "i32", ints32.data(), ints32.size());
+  storage.InsertArray(ctx, "i64", ints64.data(), ints64.size());
+  storage.InsertArray<float>(ctx, "empty", nullptr, 0);
+  ASSERT_EQ(5, storage.Size());
+
+  EXPECT_EQ(floats, std::vector<float>(storage.GetArray<float>(ctx, "float").begin(), storage.GetArray<float>(ctx, "float").end()));
+
+  auto doubleView = storage.GetArray<double>(ctx, "double");
+  ASSERT_EQ(2, doubleView.Size());
+  EXPECT_EQ(2.0, doubleView[1]);
+
+  i32 sum = 0;
+  for (i32 v : storage.GetArray<i32>(ctx, "i32")) sum += v;
+  EXPECT_EQ(2, sum);
+
+  EXPECT_EQ(1ll << 40, storage.GetArray<i64>(ctx, "i64")[0]);
+  EXPECT_EQ(0, storage.GetArray<float>(ctx, "empty").Size());
+
+  // Raw bytes of an array
+  EXPECT_EQ(4 * sizeof(i32), storage.GetBlob(ctx, "i32").SizeInBytes());
+
+  // Type mismatch
+  EXPECT_THROW(storage.GetArray<double>(ctx, "float"), std::runtime_error);
+  EXPECT_THROW(storage.GetArray<i64>(ctx, "i32"), std::runtime_error);
+}
+
+TEST_F(SharedStorageTest, ViewOutlivesValue) {
+  Context* ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 16);
+  ctx->SetMemory(mem.get());
+
+  SMStorage& storage = *ctx->Memory().GetSMStorage();
+  auto initialMem = ctx->Memory().GetNumFreeBytes();
+
+  std::vector<i32> values(64, 7);
+  storage.InsertArray(ctx, "key", values.data(), values.size());
+  {
+    auto view = storage.GetArray<i32>(ctx, "key");
+
+    // Overwrite and remove the key -> the view still references the old data
+    std::vector<i32> newValues(64, 8);
+    storage.InsertArray(ctx, "key", newValues.data(), newValues.size());
+    EXPECT_EQ(8, storage.GetArray<i32>(ctx, "key")[0]);
+    ASSERT_TRUE(storage.Remove(ctx, "key"));
+
+    ASSERT_EQ(64, view.Size());
+    EXPECT_EQ(7, view[0]);
+    EXPECT_EQ(7, view[63]);
+  }
+  storage.Clear(ctx);
+
+  EXPECT_EQ(initialMem, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SharedStorageTest, Version) {
+  Context* ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+
+  SMStorage& storage = *ctx->Memory().GetSMStorage();
+  EXPECT_EQ(0, storage.GetVersion(ctx, "foo"));
+
+  storage.InsertInt(ctx, "foo", 1);
+  u64 version1 = storage.GetVersion(ctx, "foo");
+  EXPECT_NE(0, version1);
+
+  // Other keys don't change the version
+  storage.InsertInt(ctx, "bar", 1);
+  EXPECT_EQ(version1, storage.GetVersion(ctx, "foo"));
+
+  storage.InsertInt(ctx, "foo", 2);
+  u64 version2 = storage.GetVersion(ctx, "foo");
+  EXPECT_GT(version2, version1);
+
+  ASSERT_TRUE(storage.Remove(ctx, "foo"));
+  EXPECT_EQ(0, storage.GetVersion(ctx, "foo"));
+
+  // Re-inserting a removed key never reuses an old version
+  storage.InsertInt(ctx, "foo", 1);
+  EXPECT_GT(storage.GetVersion(ctx, "foo"), version2);
+}
+
+TEST_F(SharedStorageTest, Watch) {
+  Context* ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+
+  SMStorage& storage = *ctx->Memory().GetSMStorage();
+  storage.InsertInt(ctx, "foo", 1);
+  u64 version = storage.GetVersion(ctx, "foo");
+
+  // Changed already
+  EXPECT_EQ(version, storage.Watch(ctx, "foo", 0, 0));
+
+  // Timeout
+  EXPECT_EQ(version, storage.Watch(ctx, "foo", version, 10));
+
+  // Wake up all watchers of the key, changes of other keys are ignored
+  std::vector<std::thread> watchers;
+  for (int i = 0; i < 3; ++i) {
+    watchers.emplace_back([&]() {
+      u64 newVersion = storage.Watch(ctx, "foo", version);
+      EXPECT_NE(version, newVersion);
+      EXPECT_EQ(2, storage.GetInt(ctx, "foo"));
+    });
+  }
+  ::Sleep(10);
+  storage.InsertInt(ctx, "bar", 1);
+  ::Sleep(10);
+  storage.InsertInt(ctx, "foo", 2);
+  for (auto& watcher : watchers) watcher.join();
+}
+
+TEST_F(SharedStorageTest, WatchDifferentKeys) {
+  Context* ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 20);
+  ctx->SetMemory(mem.get());
+
+  SMStorage& storage = *ctx->Memory().GetSMStorage();
+
+  // Back to back changes of two keys wake up the watchers of both keys (the watcher of the first key must not steal the permit of the
+  // second change)
+  for (int i = 0; i < 20; ++i) {
+    storage.InsertInt(ctx, "foo", i);
+    storage.InsertInt(ctx, "bar", i);
+    u64 fooVersion = storage.GetVersion(ctx, "foo");
+    u64 barVersion = storage.GetVersion(ctx, "bar");
+
+    std::vector<std::thread> watchers;
+    for (int j = 0; j < 2; ++j) {
+      watchers.emplace_back([&]() { EXPECT_NE(fooVersion, storage.Watch(ctx, "foo", fooVersion, 5000)); });
+      watchers.emplace_back([&]() { EXPECT_NE(barVersion, storage.Watch(ctx, "bar", barVersion, 5000)); });
+    }
+    ::Sleep(10);
+    storage.InsertInt(ctx, "foo", i + 1);
+    storage.InsertInt(ctx, "bar", i + 1);
+    for (auto& watcher : watchers) watcher.join();
+  }
+}
+
 }  // namespace
\ No newline at end of file
@@ -79,4 +79,81 @@ TEST_F(SMStringTest, CopyAssign) {
   EXPECT_STREQ(str.c_str(), s2.AsString(ctx).c_str());
 }
 
+TEST_F(SMStringTest, SmallString) {
+  auto ctx = GetContext();
+  auto freeBytes = ctx->Memory().GetNumFreeBytes();
+
+  auto str = std::string(SMString::InlineCapacity, 'x');
+  SMString s1(ctx, str);
+  EXPECT_TRUE(s1.IsInline());
+  EXPECT_EQ(str.size(), s1.Size());
+  EXPECT_STREQ(str.c_str(), s1.AsString(ctx).c_str());
+  EXPECT_EQ(freeBytes, ctx->Memory().GetNumFreeBytes());
+
+  SMString s2(std::move(s1));
+  EXPECT_TRUE(s2.IsInline());
+  EXPECT_EQ(0, s1.Size());
+  EXPECT_STREQ(str.c_str(), s2.AsString(ctx).c_str());
+
+  s2.Destruct(&ctx->Memory());
+  EXPECT_EQ(freeBytes, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SMStringTest, Growth) {
+  auto ctx = GetContext();
+  auto freeBytes = ctx->Memory().GetNumFreeBytes();
+
+  SMString s1(ctx, "short");
+  EXPECT_EQ(SMString::InlineCapacity, s1.Capacity());
+
+  auto str = std::string(SMString::InlineCapacity + 1, 'x');
+  s1.Assign(ctx, str);
+  EXPECT_FALSE(s1.IsInline());
+  EXPECT_EQ(2 * SMString::InlineCapacity, s1.Capacity());
+  EXPECT_STREQ(str.c_str(), s1.AsString(ctx).c_str());
+
+  // Assigning a shorter string does not reallocate
+  auto freeBytesAfterGrowth = ctx->Memory().GetNumFreeBytes();
+  s1.Assign(ctx, "short");
+  EXPECT_EQ(2 * SMString::InlineCapacity, s1.Capacity());
+  EXPECT_EQ(freeBytesAfterGrowth, ctx->Memory().GetNumFreeBytes());
+  EXPECT_STREQ("short", s1.AsString(ctx).c_str());
+
+  s1.Clear(ctx);
+  EXPECT_EQ(0, s1.Size());
+  EXPECT_TRUE(s1.IsInline());
+  EXPECT_EQ(freeBytes, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SMStringTest, ReserveAndShrinkToFit) {
+  auto ctx = GetContext();
+  auto freeBytes = ctx->Memory().GetNumFreeBytes();
+
+  SMString s1(ctx, "Hello World!");
+  s1.Reserve(ctx, 100);
+  EXPECT_EQ(100, s1.Capacity());
+  EXPECT_STREQ("Hello World!", s1.AsString(ctx).c_str());
+
+  // Reserving less than the capacity is a no-op
+  s1.Reserve(ctx, 50);
+  EXPECT_EQ(100, s1.Capacity());
+
+  // Fits inline again
+  s1.ShrinkToFit(ctx);
+  EXPECT_TRUE(s1.IsInline());
+  EXPECT_STREQ("Hello World!", s1.AsString(ctx).c_str());
+  EXPECT_EQ(freeBytes, ctx->Memory().GetNumFreeBytes());
+
+  // Shrink to exact size on the heap
+  auto str = std::string(50, 'x');
+  s1.Assign(ctx, str);
+  s1.Reserve(ctx, 200);
+  s1.ShrinkToFit(ctx);
+  EXPECT_EQ(50, s1.Capacity());
+  EXPECT_STREQ(str.c_str(), s1.AsString(ctx).c_str());
+
+  s1.Destruct(&ctx->Memory());
+  EXPECT_EQ(freeBytes, ctx->Memory().GetNumFreeBytes());
+}
+
 }  // namespace
\ No newline at end of file
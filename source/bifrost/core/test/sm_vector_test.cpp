@@ -0,0 +1,140 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/sm_list.h"
+#include "bifrost/core/sm_string.h"
+#include "bifrost/core/sm_vector.h"
+#include "bifrost/core/timer.h"
+
+namespace {
+
+using namespace bifrost;
+
+class SMVectorTest : public TestBaseSharedMemory {};
+
+TEST_F(SMVectorTest, Construction) {
+  auto ctx = GetContext();
+
+  SMVector<i32> vec1;
+  EXPECT_EQ(0, vec1.Size());
+  EXPECT_EQ(0, vec1.Capacity());
+  EXPECT_TRUE(vec1.Empty());
+
+  SMVector<i32> vec2(ctx, 10);
+  EXPECT_EQ(0, vec2.Size());
+  EXPECT_EQ(10, vec2.Capacity());
+  vec2.Destruct(&ctx->Memory());
+}
+
+TEST_F(SMVectorTest, PushPopBack) {
+  auto ctx = GetContext();
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  SMVector<i32> vec;
+  for (i32 i = 0; i < 100; ++i) vec.PushBack(ctx, i);
+  ASSERT_EQ(100, vec.Size());
+  EXPECT_GE(vec.Capacity(), 100);
+
+  for (i32 i = 0; i < 100; ++i) EXPECT_EQ(i, vec.At(ctx, i));
+
+  vec.PopBack(ctx);
+  EXPECT_EQ(99, vec.Size());
+  EXPECT_EQ(98, vec.Data(ctx)[vec.Size() - 1]);
+
+  vec.Clear(ctx);
+  EXPECT_TRUE(vec.Empty());
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SMVectorTest, AppendAndResize) {
+  auto ctx = GetContext();
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  std::array<u64, 5> values{1, 2, 3, 4, 5};
+
+  SMVector<u64> vec;
+  vec.Append(ctx, values.data(), values.size());
+  vec.Append(ctx, values.data(), values.size());
+  ASSERT_EQ(10, vec.Size());
+  for (u64 i = 0; i < vec.Size(); ++i) EXPECT_EQ(values[i % values.size()], vec.At(ctx, i));
+
+  vec.Resize(ctx, 3);
+  EXPECT_EQ(3, vec.Size());
+
+  vec.Resize(ctx, 20);
+  EXPECT_EQ(20, vec.Size());
+  EXPECT_EQ(3, vec.At(ctx, 2));
+  EXPECT_EQ(0, vec.At(ctx, 19));
+
+  vec.Clear(ctx);
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+TEST_F(SMVectorTest, SMObject) {
+  auto ctx = GetContext();
+  auto freeMemory = ctx->Memory().GetNumFreeBytes();
+
+  SMVector<SMString> vec;
+  for (i32 i = 0; i < 20; ++i) vec.EmplaceBack(ctx, ctx, "a string which is too long to be stored inline #" + std::to_string(i));
+  ASSERT_EQ(20, vec.Size());
+  for (i32 i = 0; i < 20; ++i) EXPECT_EQ("a string which is too long to be stored inline #" + std::to_string(i), vec.At(ctx, i).AsView(ctx));
+
+  vec.PopBack(ctx);
+  EXPECT_EQ(19, vec.Size());
+
+  vec.Destruct(&ctx->Memory());
+  EXPECT_EQ(freeMemory, ctx->Memory().GetNumFreeBytes());
+}
+
+class SMVectorBenchmark : public TestBaseNoSharedMemory {};
+
+TEST_F(SMVectorBenchmark, IterationVsSMList) {
+  Context* ctx = GetContext();
+  auto mem = CreateSharedMemory(1 << 26);
+  ctx->SetMemory(mem.get());
+
+  const u64 numElements = 1 << 18;
+  const int numIterations = 10;
+
+  SMVector<u64> vec;
+  SMList<u64> list;
+  for (u64 i = 0; i < numElements; ++i) {
+    vec.PushBack(ctx, i);
+    list.PushBack(ctx, i);
+  }
+
+  Timer timer;
+  u64 vecSum = 0;
+  for (int n = 0; n < numIterations; ++n) {
+    const u64* data = vec.Data(ctx);
+    for (u64 i = 0; i < vec.Size(); ++i) vecSum += data[i];
+  }
+  auto vecTime = timer.Stop();
+
+  timer.Start();
+  u64 listSum = 0;
+  for (int n = 0; n < numIterations; ++n) {
+    list.ForeachHeadToTail(ctx, [&listSum](SMList<u64>::Node* node) {
+      listSum += node->Value;
+      return true;
+    });
+  }
+  auto listTime = timer.Stop();
+
+  EXPECT_EQ(vecSum, listSum);
+  GetLogger()->InfoFormat("Iterating %llu elements %i times: SMVector %llu ms, SMList %llu ms", numElements, numIterations, (u64)vecTime, (u64)listTime);
+
+  vec.Destruct(&ctx->Memory());
+  list.Destruct(&ctx->Memory());
+}
+
+}  // namespace
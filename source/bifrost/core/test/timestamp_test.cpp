@@ -0,0 +1,54 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/test/test.h"
+#include "bifrost/core/timestamp.h"
+
+namespace {
+
+using namespace bifrost;
+
+class TimestampTest : public TestBaseNoSharedMemory {};
+
+TEST_F(TimestampTest, Monotonic) {
+  u64 t1 = GetTimestamp();
+  u64 t2 = GetTimestamp();
+  EXPECT_LE(t1, t2);
+  EXPECT_GT(GetTimestampFrequency(), 0);
+}
+
+TEST_F(TimestampTest, UnixMicroseconds) {
+  u64 frequency = GetTimestampFrequency();
+  u64 ticks = GetTimestamp();
+
+  u64 now = (u64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  u64 micros = TimestampToUnixMicroseconds(ticks);
+  EXPECT_LT(std::max(now, micros) - std::min(now, micros), 1000000);
+
+  EXPECT_EQ(micros + 1000000, TimestampToUnixMicroseconds(ticks + frequency));
+}
+
+TEST_F(TimestampTest, Formatter) {
+  TimestampFormatter formatter;
+  u64 ticks = GetTimestamp();
+
+  std::string str = formatter.Format(ticks);
+  ASSERT_EQ(12, str.size());
+  EXPECT_EQ(':', str[2]);
+  EXPECT_EQ(':', str[5]);
+  EXPECT_EQ('.', str[8]);
+
+  // The milliseconds are updated while the cached prefix is reused
+  EXPECT_EQ(str, formatter.Format(ticks));
+  EXPECT_NE(str, formatter.Format(ticks + GetTimestampFrequency()));
+}
+
+}  // namespace
@@ -0,0 +1,80 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/timestamp.h"
+
+namespace bifrost {
+
+namespace {
+
+/// Pair of a timestamp and the wall clock time taken at the same time
+struct Calibration {
+  u64 Frequency;
+  u64 Ticks;
+  u64 UnixMicroseconds;
+};
+
+const Calibration& GetCalibration() {
+  static Calibration calibration = []() {
+    Calibration c;
+    LARGE_INTEGER frequency;
+    ::QueryPerformanceFrequency(&frequency);
+    c.Frequency = (u64)frequency.QuadPart;
+    c.Ticks = GetTimestamp();
+    c.UnixMicroseconds =
+        (u64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    return c;
+  }();
+  return calibration;
+}
+
+}  // namespace
+
+u64 GetTimestamp() {
+  LARGE_INTEGER ticks;
+  ::QueryPerformanceCounter(&ticks);
+  return (u64)ticks.QuadPart;
+}
+
+u64 GetTimestampFrequency() { return GetCalibration().Frequency; }
+
+u64 TimestampToUnixMicroseconds(u64 ticks) {
+  const Calibration& c = GetCalibration();
+
+  // Split into seconds and remainder to not overflow for timestamps far away from the calibration
+  i64 delta = (i64)(ticks - c.Ticks);
+  i64 frequency = (i64)c.Frequency;
+  i64 micros = (delta / frequency) * 1000000 + ((delta % frequency) * 1000000) / frequency;
+  return (u64)((i64)c.UnixMicroseconds + micros);
+}
+
+const char* TimestampFormatter::Format(u64 ticks) { return FormatUnixMicroseconds(TimestampToUnixMicroseconds(ticks)); }
+
+const char* TimestampFormatter::FormatUnixMicroseconds(u64 micros) {
+  i64 second = (i64)(micros / 1000000);
+  if (second != m_second) {
+    std::time_t time = (std::time_t)second;
+    struct tm* localTime = std::localtime(&time);
+    std::snprintf(m_buffer, sizeof(m_buffer), "%02i:%02i:%02i", localTime->tm_hour, localTime->tm_min, localTime->tm_sec);
+    m_second = second;
+  }
+
+  u32 millis = (u32)((micros / 1000) % 1000);
+  m_buffer[8] = '.';
+  m_buffer[9] = (char)('0' + millis / 100);
+  m_buffer[10] = (char)('0' + (millis / 10) % 10);
+  m_buffer[11] = (char)('0' + millis % 10);
+  m_buffer[12] = '\0';
+  return m_buffer;
+}
+
+}  // namespace bifrost
@@ -0,0 +1,44 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+#pragma once
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/type.h"
+
+namespace bifrost {
+
+/// Get a monotonic timestamp in ticks of the performance counter - timestamps are comparable across processes
+extern u64 GetTimestamp();
+
+/// Get the number of timestamp ticks per second
+extern u64 GetTimestampFrequency();
+
+/// Convert the timestamp `ticks` to microseconds since the Unix epoch
+extern u64 TimestampToUnixMicroseconds(u64 ticks);
+
+/// Format timestamps as "HH:MM:SS.mmm" in local time
+///
+/// The "HH:MM:SS" prefix is cached, hence `localtime` is only called once per second of log output.
+class TimestampFormatter {
+ public:
+  /// Format the timestamp `ticks` - the returned string is valid until the next call
+  const char* Format(u64 ticks);
+
+  /// Format the microseconds since the Unix epoch `micros` - the returned string is valid until the next call
+  const char* FormatUnixMicroseconds(u64 micros);
+
+ private:
+  i64 m_second = -1;
+  char m_buffer[16] = {};
+};
+
+}  // namespace bifrost
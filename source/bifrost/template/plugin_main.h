@@ -31,6 +31,9 @@
 #pragma endregion
 
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
 
 #if BIFROST_ENABLE_INCLUDE
 BIFROST_PLUGIN_INCLUDES
@@ -224,13 +227,149 @@ BIFROST_CACHE_ALIGN class Plugin {
   /// @param[in] ignoreErrors  Don't call `FatalError` if something goes wrong
   void Log(LogLevel level, const char* msg, bool ignoreErrors = false) const;
 
+  /// Log the printf-style message `fmt` whose formatting is deferred to the injector - calls Error on failure
+  ///
+  /// Arguments are integers, enums, floating point values, pointers and strings (`const char*` or anything with `data()` and `size()`).
+  ///
+  /// @param[in] level  Severity level
+  /// @param[in] fmt    Format string which has to be a string literal
+  /// @param[in] args   Arguments of the format string
+  template <class... Args>
+  void LogDeferred(LogLevel level, const char* fmt, const Args&... args) const {
+    _LogArgs encodedArgs;
+    (encodedArgs.Encode(args), ...);
+    _LogDeferred(level, fmt, encodedArgs.Data, encodedArgs.Size);
+  }
+
+  //
+  // CHANNEL
+  //
+
+  /// Wait forever in `Channel::Push` and `Channel::Pop`
+  static constexpr std::uint32_t InfiniteTimeout = 0xFFFFFFFF;
+
+  /// Single-producer/single-consumer channel of trivially copyable elements in shared memory (see `OpenChannel`)
+  template <class T>
+  class Channel {
+   public:
+    Channel(Plugin* plugin, void* channel) : m_plugin(plugin), m_channel(channel) {}
+    Channel(Channel&& other) noexcept : m_plugin(other.m_plugin), m_channel(other.m_channel) { other.m_channel = nullptr; }
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+    ~Channel() {
+      if (m_channel) m_plugin->_ChannelFree(m_channel);
+    }
+
+    /// Push up to `count` elements without blocking - returns the number of pushed elements
+    std::uint32_t TryPush(const T* elements, std::uint32_t count) { return m_plugin->_ChannelPush(m_channel, elements, count, 0); }
+    bool TryPush(const T& element) { return TryPush(&element, 1) == 1; }
+
+    /// Push all `count` elements waiting at most `timeoutInMs` for free space - returns the number of pushed elements
+    std::uint32_t Push(const T* elements, std::uint32_t count, std::uint32_t timeoutInMs = InfiniteTimeout) {
+      return m_plugin->_ChannelPush(m_channel, elements, count, timeoutInMs);
+    }
+    bool Push(const T& element, std::uint32_t timeoutInMs = InfiniteTimeout) { return Push(&element, 1, timeoutInMs) == 1; }
+
+    /// Pop up to `count` elements without blocking - returns the number of popped elements
+    std::uint32_t TryPop(T* elements, std::uint32_t count) { return m_plugin->_ChannelPop(m_channel, elements, count, 0); }
+    bool TryPop(T& element) { return TryPop(&element, 1) == 1; }
+
+    /// Pop up to `count` elements waiting at most `timeoutInMs` for the first element - returns the number of popped elements
+    std::uint32_t Pop(T* elements, std::uint32_t count, std::uint32_t timeoutInMs = InfiniteTimeout) {
+      return m_plugin->_ChannelPop(m_channel, elements, count, timeoutInMs);
+    }
+    bool Pop(T& element, std::uint32_t timeoutInMs = InfiniteTimeout) { return Pop(&element, 1, timeoutInMs) == 1; }
+
+   private:
+    Plugin* m_plugin;
+    void* m_channel;
+  };
+
+  /// Open the channel `name` in the shared memory or create it with `capacity` elements if it does not exist yet - calls `FatalError` on failure
+  ///
+  /// The element type `T` has to match the element type used by the other side (e.g `bfi_ChannelOpen` in the injector).
+  template <class T>
+  Channel<T> OpenChannel(const char* name, std::uint32_t capacity = 1024) {
+    static_assert(std::is_trivially_copyable<T>::value, "channel elements have to be trivially copyable");
+    return Channel<T>(this, _ChannelOpen(name, sizeof(T), capacity));
+  }
+
   //
   // INTERNAL
   //
+
+  /// Arguments of `LogDeferred` encoded as described by `bfp_LogArgTag`
+  struct _LogArgs {
+    enum Tag : std::uint8_t { I32 = 0, U32, I64, U64, F64, Ptr, Str };
+    static constexpr std::uint32_t Capacity = 512;
+
+    template <class T, class = void>
+    struct IsString : std::false_type {};
+    template <class T>
+    struct IsString<T, std::void_t<decltype(std::declval<const T&>().data()), decltype(std::declval<const T&>().size())>> : std::true_type {};
+
+    template <class T>
+    void Encode(const T& arg) {
+      if constexpr (std::is_enum<T>::value) {
+        Encode(static_cast<std::underlying_type_t<T>>(arg));
+      } else if constexpr (std::is_same<T, bool>::value) {
+        EncodeValue(U32, (std::uint32_t)arg);
+      } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+        if constexpr (sizeof(T) <= 4) {
+          EncodeValue(I32, (std::int32_t)arg);
+        } else {
+          EncodeValue(I64, (std::int64_t)arg);
+        }
+      } else if constexpr (std::is_integral<T>::value) {
+        if constexpr (sizeof(T) <= 4) {
+          EncodeValue(U32, (std::uint32_t)arg);
+        } else {
+          EncodeValue(U64, (std::uint64_t)arg);
+        }
+      } else if constexpr (std::is_floating_point<T>::value) {
+        EncodeValue(F64, (double)arg);
+      } else if constexpr (std::is_same<std::decay_t<T>, char*>::value || std::is_same<std::decay_t<T>, const char*>::value) {
+        const char* str = arg == nullptr ? "(null)" : arg;
+        EncodeString(str, std::strlen(str));
+      } else if constexpr (IsString<T>::value) {
+        EncodeString(arg.data(), arg.size());
+      } else if constexpr (std::is_pointer<T>::value) {
+        EncodeValue(Ptr, (std::uint64_t)arg);
+      } else {
+        static_assert(std::is_void<T>::value, "unsupported deferred log argument");
+      }
+    }
+
+    template <class T>
+    void EncodeValue(Tag tag, T value) {
+      if (Size + 1 + sizeof(T) > Capacity) return;
+      Data[Size++] = tag;
+      std::memcpy(Data + Size, &value, sizeof(T));
+      Size += sizeof(T);
+    }
+
+    void EncodeString(const char* str, std::size_t size) {
+      if (Size + 1 + sizeof(std::uint32_t) > Capacity) return;
+      std::uint32_t length = (std::uint32_t)(size < Capacity - Size - 1 - sizeof(std::uint32_t) ? size : Capacity - Size - 1 - sizeof(std::uint32_t));
+      Data[Size++] = Str;
+      std::memcpy(Data + Size, &length, sizeof(std::uint32_t));
+      std::memcpy(Data + Size + sizeof(std::uint32_t), str, length);
+      Size += sizeof(std::uint32_t) + length;
+    }
+
+    std::uint8_t Data[Capacity];
+    std::uint32_t Size = 0;
+  };
+
   bfp_PluginContext_t* _GetPlugin();
   void _SetUpImpl(bfp_PluginContext_t*);
   void _TearDownImpl(bool);
   void _SetArguments(const char*);
+  void* _ChannelOpen(const char* name, std::uint32_t elementSize, std::uint32_t capacity);
+  void _ChannelFree(void* channel);
+  std::uint32_t _ChannelPush(void* channel, const void* elements, std::uint32_t count, std::uint32_t timeoutInMs);
+  std::uint32_t _ChannelPop(void* channel, void* elements, std::uint32_t count, std::uint32_t timeoutInMs);
+  void _LogDeferred(LogLevel level, const char* fmt, const void* args, std::uint32_t argsSize) const;
 
  private:
   static BIFROST_CACHE_ALIGN Plugin* s_instance;
@@ -562,6 +701,7 @@ class BifrostPluginApi {
   BIFROST_PLUGIN_API_DECL(bfp_StringFree)
   BIFROST_PLUGIN_API_DECL(bfp_PluginGetLastError)
   BIFROST_PLUGIN_API_DECL(bfp_PluginLog)
+  BIFROST_PLUGIN_API_DECL(bfp_PluginLogDeferred)
   BIFROST_PLUGIN_API_DECL(bfp_PluginSetUpStart)
   BIFROST_PLUGIN_API_DECL(bfp_PluginSetUpEnd)
   BIFROST_PLUGIN_API_DECL(bfp_PluginTearDownStart)
@@ -569,6 +709,10 @@ class BifrostPluginApi {
   BIFROST_PLUGIN_API_DECL(bfp_HookSet)
   BIFROST_PLUGIN_API_DECL(bfp_HookRemove)
   BIFROST_PLUGIN_API_DECL(bfp_HookEnableDebug)
+  BIFROST_PLUGIN_API_DECL(bfp_ChannelOpen)
+  BIFROST_PLUGIN_API_DECL(bfp_ChannelFree)
+  BIFROST_PLUGIN_API_DECL(bfp_ChannelPush)
+  BIFROST_PLUGIN_API_DECL(bfp_ChannelPop)
 
   BifrostPluginApi() {
     HMODULE hModule = NULL;
@@ -579,6 +723,7 @@ class BifrostPluginApi {
     BIFROST_PLUGIN_API_DEF(bfp_StringFree)
     BIFROST_PLUGIN_API_DEF(bfp_PluginGetLastError)
     BIFROST_PLUGIN_API_DEF(bfp_PluginLog)
+    BIFROST_PLUGIN_API_DEF(bfp_PluginLogDeferred)
     BIFROST_PLUGIN_API_DEF(bfp_PluginSetUpStart)
     BIFROST_PLUGIN_API_DEF(bfp_PluginSetUpEnd)
     BIFROST_PLUGIN_API_DEF(bfp_PluginTearDownStart)
@@ -586,6 +731,10 @@ class BifrostPluginApi {
     BIFROST_PLUGIN_API_DEF(bfp_HookSet)
     BIFROST_PLUGIN_API_DEF(bfp_HookRemove)
     BIFROST_PLUGIN_API_DEF(bfp_HookEnableDebug)
+    BIFROST_PLUGIN_API_DEF(bfp_ChannelOpen)
+    BIFROST_PLUGIN_API_DEF(bfp_ChannelFree)
+    BIFROST_PLUGIN_API_DEF(bfp_ChannelPush)
+    BIFROST_PLUGIN_API_DEF(bfp_ChannelPop)
 
 #undef BIFROST_PLUGIN_API_DECL
 #undef BIFROST_PLUGIN_API_DEF
@@ -741,6 +890,15 @@ void Plugin::Log(Plugin::LogLevel level, const char* msg, bool ignoreErrors) con
   }
 }
 
+void Plugin::_LogDeferred(Plugin::LogLevel level, const char* fmt, const void* args, std::uint32_t argsSize) const {
+  static_assert(_LogArgs::Str == BFP_LOG_ARG_STR, "_LogArgs::Tag does not match bfp_LogArgTag");
+
+  auto& api = GetApi();
+  if (api.bfp_PluginLogDeferred(m_impl->Context, (uint32_t)level, GetName(), fmt, args, argsSize) != BFP_OK) {
+    FatalError(api.bfp_PluginGetLastError(m_impl->Context));
+  }
+}
+
 const char* Plugin::GetArguments() const noexcept { return m_impl->Arguments.c_str(); }
 
 void Plugin::FatalError(const char* msg) const {
@@ -922,6 +1080,34 @@ void Plugin::_TearDownImpl(bool noFail) {
 
 void Plugin::_SetArguments(const char* arguments) { m_impl->Arguments = arguments; }
 
+void* Plugin::_ChannelOpen(const char* name, std::uint32_t elementSize, std::uint32_t capacity) {
+  auto& api = GetApi();
+  bfp_Channel* channel = nullptr;
+  if (api.bfp_ChannelOpen(m_impl->Context, name, elementSize, capacity, &channel) != BFP_OK) FatalError(api.bfp_PluginGetLastError(m_impl->Context));
+  return channel;
+}
+
+void Plugin::_ChannelFree(void* channel) {
+  auto& api = GetApi();
+  if (api.bfp_ChannelFree(m_impl->Context, (bfp_Channel*)channel) != BFP_OK) Log(LogLevel::Warn, api.bfp_PluginGetLastError(m_impl->Context), true);
+}
+
+std::uint32_t Plugin::_ChannelPush(void* channel, const void* elements, std::uint32_t count, std::uint32_t timeoutInMs) {
+  auto& api = GetApi();
+  std::uint32_t numPushed = 0;
+  if (api.bfp_ChannelPush(m_impl->Context, (bfp_Channel*)channel, elements, count, timeoutInMs, &numPushed) != BFP_OK)
+    FatalError(api.bfp_PluginGetLastError(m_impl->Context));
+  return numPushed;
+}
+
+std::uint32_t Plugin::_ChannelPop(void* channel, void* elements, std::uint32_t count, std::uint32_t timeoutInMs) {
+  auto& api = GetApi();
+  std::uint32_t numPopped = 0;
+  if (api.bfp_ChannelPop(m_impl->Context, (bfp_Channel*)channel, elements, count, timeoutInMs, &numPopped) != BFP_OK)
+    FatalError(api.bfp_PluginGetLastError(m_impl->Context));
+  return numPopped;
+}
+
 BIFROST_NAMESPACE_END
 
 #include "bifrost/template/plugin_fwd.h"
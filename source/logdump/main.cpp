@@ -0,0 +1,135 @@
+//   ____  _  __               _
+//  |  _ \(_)/ _|             | |
+//  | |_) |_| |_ _ __ ___  ___| |_
+//  |  _ <| |  _| '__/ _ \/ __| __|
+//  | |_) | | | | | | (_) \__ \ |_
+//  |____/|_|_| |_|  \___/|___/\__|   2018 - 2019
+//
+//
+// This file is distributed under the MIT License (MIT).
+// See LICENSE.txt for details.
+
+
+#include "bifrost/core/common.h"
+#include "bifrost/core/type.h"
+#include "bifrost/core/util.h"
+#include "bifrost/core/binary_log.h"
+#include "bifrost/core/timestamp.h"
+#include <args.hxx>
+#include <iostream>
+
+using namespace bifrost;
+
+namespace {
+
+static const char* LevelNames[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+
+/// Parse a log level given by name or number
+u32 ParseLevel(const std::string& level) {
+  for (u32 i = 0; i < ArraySize(LevelNames); ++i) {
+    if (_stricmp(level.c_str(), LevelNames[i]) == 0) return i;
+  }
+  if (!level.empty() && std::all_of(level.begin(), level.end(), ::isdigit)) return (u32)std::stoul(level);
+  throw std::runtime_error(StringFormat("Invalid log level \"%s\": expected one of trace, debug, info, warn or error", level.c_str()));
+}
+
+/// Expand the input `input` into the list of binary log files - inputs without the .bflog extension are treated as the base path of a
+/// rotated binary log
+std::vector<std::filesystem::path> ExpandInput(const std::filesystem::path& input) {
+  if (input.extension() == ".bflog") return {input};
+
+  std::filesystem::path basePath = input.extension() == ".bfidx" ? std::filesystem::path(input).replace_extension() : input;
+
+  std::vector<std::filesystem::path> files;
+  for (const auto& entry : binary_log::ReadIndex(basePath)) {
+    auto path = binary_log::GetFilePath(basePath, entry.FileIndex);
+    if (std::filesystem::exists(path)) files.emplace_back(std::move(path));
+  }
+  if (files.empty()) throw std::runtime_error(StringFormat("No binary log files found for \"%s\"", input.string().c_str()));
+  return files;
+}
+
+/// Message filter
+struct Filter {
+  u32 MinLevel = 0;
+  std::string Module;
+  std::optional<u32> ThreadId;
+  std::string Grep;
+
+  bool Matches(const BinaryLogReader::Message& msg) const {
+    if (msg.Level < MinLevel) return false;
+    if (!Module.empty() && msg.Module != Module) return false;
+    if (ThreadId && msg.ThreadId != *ThreadId) return false;
+    if (!Grep.empty() && msg.Text.find(Grep) == std::string::npos) return false;
+    return true;
+  }
+};
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  auto program = argc > 0 ? std::filesystem::path(argv[0]).filename().string() : "bifrost-logdump";
+
+  args::ArgumentParser parser("Bifrost Log Dump - Decode binary log files written by the injector.");
+  parser.helpParams.addDefault = false;
+  parser.helpParams.valueOpen = "<";
+  parser.helpParams.valueClose = ">";
+  parser.Prog(program);
+  parser.Epilog(StringFormat("\nEXAMPLES:\n  %s log.0.bflog log.1.bflog\n  %s log --level=warn --grep=\"hook\"\n", program.c_str(), program.c_str()));
+
+  args::HelpFlag help(parser, "help", "Display this help menu and exit.", {'h', "help"});
+  args::ValueFlag<std::string> level(parser, "level", "Only print messages with a level of at least <level>.", {"level"});
+  args::ValueFlag<std::string> module(parser, "module", "Only print messages of the module <module>.", {"module"});
+  args::ValueFlag<u32> thread(parser, "tid", "Only print messages of the thread <tid>.", {"thread"});
+  args::ValueFlag<std::string> grep(parser, "text", "Only print messages containing <text>.", {"grep"});
+  args::PositionalList<std::string> inputs(parser, "files",
+                                           "Binary log files (.bflog) or the base path of a rotated binary log. Messages of all files are "
+                                           "merged by their timestamp.");
+
+  try {
+    parser.ParseCLI(argc, argv);
+  } catch (args::Help) {
+    std::cout << parser;
+    return 0;
+  } catch (args::Error& e) {
+    std::cerr << program << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  try {
+    if (!inputs) throw std::runtime_error("No input files given");
+
+    Filter filter;
+    if (level) filter.MinLevel = ParseLevel(level.Get());
+    if (module) filter.Module = module.Get();
+    if (thread) filter.ThreadId = thread.Get();
+    if (grep) filter.Grep = grep.Get();
+
+    // Decode the matching messages of all files - the writer stores messages in the order they arrived from the log stash, which is
+    // not necessarily the order of their timestamps
+    std::vector<BinaryLogReader::Message> messages;
+    for (const auto& input : inputs) {
+      for (const auto& path : ExpandInput(input)) {
+        BinaryLogReader reader(path);
+        BinaryLogReader::Message msg;
+        while (reader.Next(msg)) {
+          if (filter.Matches(msg)) messages.emplace_back(msg);
+        }
+      }
+    }
+
+    // Merge the files by timestamp (messages with the same timestamp keep their order)
+    std::stable_sort(messages.begin(), messages.end(),
+                     [](const BinaryLogReader::Message& a, const BinaryLogReader::Message& b) { return a.Timestamp < b.Timestamp; });
+
+    TimestampFormatter formatter;
+    for (const auto& msg : messages) {
+      std::printf("[%s] [%u] [%s] [%s]: %s\n", formatter.FormatUnixMicroseconds(msg.Timestamp), msg.ThreadId,
+                  msg.Level < ArraySize(LevelNames) ? LevelNames[msg.Level] : "?", msg.Module.c_str(), msg.Text.c_str());
+    }
+  } catch (std::exception& e) {
+    std::cerr << program << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}